@@ -0,0 +1,392 @@
+/**
+ * @file bench/main.cpp
+ * @brief lcblog-bench: measure LCBLog throughput and producer latency.
+ *
+ * Usage: lcblog-bench [--threads N] [--messages M] [--queue Q]
+ *
+ * Runs every message shape in every mode at 1, 2, 4, ... up to N
+ * producer threads (default: the number of cores, at least 2), each
+ * thread logging M messages (default 100000) into a sink that discards
+ * them. One JSON object per run is written to standard output so results
+ * can be saved and compared across commits; progress goes to standard
+ * error.
+ *
+ * This software is distributed under the MIT License. See LICENSE.md for
+ * details.
+ *
+ * Copyright (C) 2023-2025 Lee C. Bussy (@LBussy). All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include "../lcblog.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Heap allocations made by any thread while a run is in progress
+static std::atomic<uint64_t> allocations{0};
+
+// GCC cannot see that these replace the global pair and flags free() here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(std::size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+#pragma GCC diagnostic pop
+
+/**
+ * @class NullSink
+ * @brief Sink that counts and discards entries, so runs measure the logger.
+ */
+class NullSink : public LogSink
+{
+public:
+    void write(LogEntrySpan entries) override
+    {
+        written.fetch_add(entries.size(), std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> written{0}; /**< Entries received. */
+};
+
+/**
+ * @enum Shape
+ * @brief Kind of message logged by a run.
+ */
+enum Shape
+{
+    Short,     /**< One short literal. */
+    Mixed,     /**< Many components of mixed types. */
+    Multiline, /**< Three lines in one message. */
+    Floats     /**< Several floating-point values. */
+};
+
+/**
+ * @enum Mode
+ * @brief Logger configuration used by a run.
+ */
+enum Mode
+{
+    Eager,     /**< Format on the calling thread into a shared queue. */
+    Deferred,  /**< Queue packed arguments; format on the worker. */
+    PerThread  /**< Eager formatting into per-thread queues. */
+};
+
+static const char *shapeName(Shape shape)
+{
+    switch (shape)
+    {
+    case Short:
+        return "short";
+    case Mixed:
+        return "mixed";
+    case Multiline:
+        return "multiline";
+    case Floats:
+        return "floats";
+    }
+    return "unknown";
+}
+
+static const char *modeName(Mode mode)
+{
+    switch (mode)
+    {
+    case Eager:
+        return "eager";
+    case Deferred:
+        return "deferred";
+    case PerThread:
+        return "per_thread";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Log one message of the given shape.
+ *
+ * @param logger Logger under test.
+ * @param shape  Kind of message.
+ * @param i      Sequence number, so values vary between calls.
+ */
+static void logShape(LCBLog &logger, Shape shape, int i)
+{
+    switch (shape)
+    {
+    case Short:
+        logger.logS(INFO, "Short message");
+        break;
+    case Mixed:
+        logger.logS(INFO, "Test start:", i, "is an int,", 3.14159, "is Pi,", -7.25,
+                    "is negative,", "true", "is a bool,", nullptr, "is null,",
+                    "this", "should", "have", "spaces.", "(Parentheses)",
+                    "[Brackets]", "{Braces}", "\"Quotes\"", "'Single quotes'",
+                    "Comma,", "period.", "exclamation!", "question?", "colon:",
+                    "semicolon;", "hyphen-", "underscore_", "slash/", "backslash\\",
+                    "percent%", "ampersand&", "asterisk*", "at@", "hash#", "dollar$",
+                    "caret^", "pipe|", "tilde~", "backtick`");
+        break;
+    case Multiline:
+        logger.logS(INFO, "First line", i, "\nSecond line\nThird line");
+        break;
+    case Floats:
+        logger.logS(INFO, i * 0.001, 3.14159, -7.25, 1e-7, 2.5e15, 100.0);
+        break;
+    }
+}
+
+/**
+ * @struct Result
+ * @brief Measurements from one run.
+ */
+struct Result
+{
+    double seconds = 0;           /**< Wall time until the last producer finished. */
+    uint64_t messages = 0;        /**< Messages logged by all producers. */
+    uint64_t written = 0;         /**< Entries that reached the sink. */
+    uint64_t dropped = 0;         /**< Messages lost to overflow. */
+    uint64_t allocations = 0;     /**< Heap allocations during the run. */
+    uint64_t p50 = 0;             /**< Median producer call time, in ns. */
+    uint64_t p99 = 0;             /**< 99th percentile call time, in ns. */
+    uint64_t p999 = 0;            /**< 99.9th percentile call time, in ns. */
+};
+
+/**
+ * @brief Return a percentile of sorted samples.
+ *
+ * @param sorted   Samples in ascending order.
+ * @param fraction Percentile as a fraction, such as 0.99.
+ * @return The sample at that rank, or 0 if there are none.
+ */
+static uint64_t percentile(const std::vector<uint64_t> &sorted, double fraction)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    size_t rank = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1));
+    return sorted[rank];
+}
+
+/**
+ * @brief Run one shape and mode at a thread count.
+ *
+ * Each producer times every call it makes. Allocations are counted from
+ * the first call until the logger has drained and shut down, so worker
+ * allocations are included.
+ *
+ * @param shape    Kind of message.
+ * @param mode     Logger configuration.
+ * @param threads  Number of producer threads.
+ * @param messages Messages per producer.
+ * @param queue    Queue capacity.
+ * @return Measurements for the run.
+ */
+static Result run(Shape shape, Mode mode, int threads, int messages, size_t queue)
+{
+    LCBLogConfig config;
+    config.queueCapacity = queue;
+    config.threadQueueCapacity = queue;
+    config.batchSize = 256;
+    config.flushInterval = std::chrono::milliseconds(10);
+    config.deferredFormatting = (mode == Deferred);
+    config.perThreadQueues = (mode == PerThread);
+
+    auto sink = std::make_shared<NullSink>();
+    std::vector<std::vector<uint64_t>> samples(threads);
+    for (auto &s : samples)
+    {
+        s.resize(static_cast<size_t>(messages));
+    }
+
+    Result result;
+    std::atomic<int> ready{0};
+    std::atomic<bool> go{false};
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+    uint64_t allocationsBefore = 0;
+    {
+        LCBLog logger({{sink}}, config);
+        logger.enableTimestamps(true);
+
+        // Warm up thread-local buffers and queues so they are not counted
+        for (int i = 0; i < 64; ++i)
+        {
+            logShape(logger, shape, i);
+        }
+        while (sink->written.load() < 64 && logger.droppedCount() == 0)
+        {
+            std::this_thread::yield();
+        }
+        const uint64_t warmWritten = sink->written.load();
+        const uint64_t warmDropped = logger.droppedCount();
+
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t)
+        {
+            producers.emplace_back([&, t]
+                                   {
+                                       std::vector<uint64_t> &mine = samples[t];
+                                       ready.fetch_add(1);
+                                       while (!go.load(std::memory_order_acquire))
+                                       {
+                                           std::this_thread::yield();
+                                       }
+                                       for (int i = 0; i < messages; ++i)
+                                       {
+                                           auto t0 = std::chrono::steady_clock::now();
+                                           logShape(logger, shape, i);
+                                           auto t1 = std::chrono::steady_clock::now();
+                                           mine[i] = static_cast<uint64_t>(
+                                               std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+                                       }
+                                   });
+        }
+        while (ready.load() < threads)
+        {
+            std::this_thread::yield();
+        }
+        allocationsBefore = allocations.load();
+        start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &p : producers)
+        {
+            p.join();
+        }
+        end = std::chrono::steady_clock::now();
+
+        // Thread start-up allocations were made before the count began
+        result.dropped = logger.droppedCount() - warmDropped;
+        result.written = warmWritten;
+    }
+    result.allocations = allocations.load() - allocationsBefore;
+    result.written = sink->written.load() - result.written;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.messages = static_cast<uint64_t>(threads) * static_cast<uint64_t>(messages);
+
+    std::vector<uint64_t> all;
+    all.reserve(static_cast<size_t>(result.messages));
+    for (const auto &s : samples)
+    {
+        all.insert(all.end(), s.begin(), s.end());
+    }
+    std::sort(all.begin(), all.end());
+    result.p50 = percentile(all, 0.50);
+    result.p99 = percentile(all, 0.99);
+    result.p999 = percentile(all, 0.999);
+    return result;
+}
+
+/**
+ * @brief Parse a positive integer option value.
+ *
+ * @param text  Option value.
+ * @param value Receives the number.
+ * @return False if text is not a positive integer.
+ */
+static bool parseCount(const char *text, long &value)
+{
+    char *end = nullptr;
+    value = std::strtol(text, &end, 10);
+    return end != text && *end == '\0' && value > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    long maxThreads = std::max(2u, std::thread::hardware_concurrency());
+    long messages = 100000;
+    long queue = 1024;
+    for (int i = 1; i < argc; ++i)
+    {
+        long *target = nullptr;
+        if (std::strcmp(argv[i], "--threads") == 0)
+        {
+            target = &maxThreads;
+        }
+        else if (std::strcmp(argv[i], "--messages") == 0)
+        {
+            target = &messages;
+        }
+        else if (std::strcmp(argv[i], "--queue") == 0)
+        {
+            target = &queue;
+        }
+        if (target == nullptr || i + 1 >= argc || !parseCount(argv[i + 1], *target))
+        {
+            std::cerr << "Usage: " << argv[0] << " [--threads N] [--messages M] [--queue Q]" << std::endl;
+            return 2;
+        }
+        ++i;
+    }
+
+    for (Mode mode : {Eager, Deferred, PerThread})
+    {
+        for (Shape shape : {Short, Mixed, Multiline, Floats})
+        {
+            for (long threads = 1; threads <= maxThreads; threads *= 2)
+            {
+                std::cerr << modeName(mode) << " " << shapeName(shape) << " x" << threads << std::endl;
+                Result r = run(shape, mode, static_cast<int>(threads), static_cast<int>(messages),
+                               static_cast<size_t>(queue));
+                char line[512];
+                std::snprintf(line, sizeof(line),
+                              "{\"mode\":\"%s\",\"shape\":\"%s\",\"threads\":%ld,\"messages\":%llu,"
+                              "\"msgs_per_sec\":%.0f,\"p50_ns\":%llu,\"p99_ns\":%llu,\"p999_ns\":%llu,"
+                              "\"allocs_per_msg\":%.4f,\"dropped\":%llu,\"written\":%llu}",
+                              modeName(mode), shapeName(shape), threads,
+                              static_cast<unsigned long long>(r.messages),
+                              r.seconds > 0 ? static_cast<double>(r.messages) / r.seconds : 0.0,
+                              static_cast<unsigned long long>(r.p50), static_cast<unsigned long long>(r.p99),
+                              static_cast<unsigned long long>(r.p999),
+                              static_cast<double>(r.allocations) / static_cast<double>(r.messages),
+                              static_cast<unsigned long long>(r.dropped),
+                              static_cast<unsigned long long>(r.written));
+                std::cout << line << std::endl;
+            }
+        }
+    }
+    return 0;
+}
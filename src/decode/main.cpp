@@ -0,0 +1,107 @@
+/**
+ * @file decode/main.cpp
+ * @brief lcblog-decode: print binary LCBLog files as the text they stand for.
+ *
+ * Usage: lcblog-decode [file...]
+ *
+ * Reads each file in turn, or standard input when none is given, and
+ * writes the decoded log text to standard output. A truncated final
+ * record is reported and skipped; everything before it is printed.
+ *
+ * This software is distributed under the MIT License. See LICENSE.md for
+ * details.
+ *
+ * Copyright (C) 2023-2025 Lee C. Bussy (@LBussy). All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "../lcblog.hpp"
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Decode one binary log stream to standard output.
+ *
+ * @param in   Stream to read.
+ * @param name Name used in diagnostics.
+ * @return True if the stream decoded cleanly or ended mid-record.
+ */
+static bool decodeStream(std::istream &in, const std::string &name)
+{
+    LogBinaryDecoder decoder;
+    std::string pending; // Bytes not yet consumed
+    std::string text;    // Decoded output for the current chunk
+    char chunk[65536];
+    size_t offset = 0;   // File offset of pending[0]
+
+    while (in)
+    {
+        in.read(chunk, sizeof(chunk));
+        pending.append(chunk, static_cast<size_t>(in.gcount()));
+
+        std::string_view view(pending);
+        text.clear();
+        LogBinaryDecoder::Result result;
+        while ((result = decoder.next(view, text)) == LogBinaryDecoder::Decoded)
+        {
+        }
+        std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+
+        const size_t used = pending.size() - view.size();
+        if (result == LogBinaryDecoder::Malformed)
+        {
+            std::cerr << name << ": malformed record at offset " << offset + used << std::endl;
+            return false;
+        }
+        pending.erase(0, used);
+        offset += used;
+    }
+
+    if (!pending.empty())
+    {
+        std::cerr << name << ": ignoring truncated record at offset " << offset << " ("
+                  << pending.size() << " bytes)" << std::endl;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    bool ok = true;
+    if (argc < 2)
+    {
+        ok = decodeStream(std::cin, "<stdin>");
+    }
+    for (int i = 1; i < argc; ++i)
+    {
+        std::ifstream file(argv[i], std::ios::binary);
+        if (!file)
+        {
+            std::cerr << argv[i] << ": cannot open" << std::endl;
+            ok = false;
+            continue;
+        }
+        ok = decodeStream(file, argv[i]) && ok;
+    }
+    std::cout.flush();
+    return ok ? 0 : 1;
+}
@@ -36,271 +36,5489 @@
 #include "lcblog.hpp"
 
 #include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <cstddef>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <iostream>
-#include <regex>
 #include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(LCBLOG_WITH_IO_URING)
+#include <linux/io_uring.h>
+#endif
+
+#if defined(LCBLOG_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+/**
+ * @brief Converts a log level to its string representation.
+ *
+ * @param level The log level to convert.
+ * @return A string representing the log level.
+ */
+std::string logLevelToString(LogLevel level)
+{
+    switch (level)
+    {
+    case DEBUG:
+        return "DEBUG";
+    case INFO:
+        return "INFO";
+    case WARN:
+        return "WARN";
+    case ERROR:
+        return "ERROR";
+    case FATAL:
+        return "FATAL";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Return the level name padded to the five-character tag width.
+ *
+ * @param level The log level to convert.
+ * @return A view of a static padded level name.
+ */
+static std::string_view levelTag(LogLevel level)
+{
+    switch (level)
+    {
+    case DEBUG:
+        return "DEBUG";
+    case INFO:
+        return "INFO ";
+    case WARN:
+        return "WARN ";
+    case ERROR:
+        return "ERROR";
+    case FATAL:
+        return "FATAL";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+/**
+ * @brief Find the file descriptor behind one of the standard streams.
+ *
+ * @param stream Stream to inspect.
+ * @return 1 for std::cout, 2 for std::cerr or std::clog, -1 otherwise.
+ */
+static int streamFd(const std::ostream &stream)
+{
+    if (&stream == &std::cout)
+    {
+        return STDOUT_FILENO;
+    }
+    if (&stream == &std::cerr || &stream == &std::clog)
+    {
+        return STDERR_FILENO;
+    }
+    return -1;
+}
+
+/**
+ * @brief Write bytes to a descriptor, retrying partial writes and EINTR.
+ *
+ * @param fd   Destination descriptor.
+ * @param data Bytes to write.
+ * @param size Number of bytes.
+ */
+static void writeFully(int fd, const char *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return; // Nowhere left to report the failure
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+/**
+ * @brief Write every entry's bytes to a descriptor with writev(2).
+ *
+ * Retries partial writes and EINTR, and splits batches longer than
+ * IOV_MAX. Sockets are written with sendmsg(2) instead, so a closed peer
+ * is reported as an error rather than raising SIGPIPE.
+ *
+ * @param fd      Destination descriptor.
+ * @param entries Entries whose bytes are written in order.
+ * @param iov     Scatter list reused between calls.
+ * @param socket  True if fd is a stream socket.
+ * @return False if a write failed before every byte was written.
+ */
+static bool writeEntries(int fd, LogEntrySpan entries, std::vector<struct iovec> &iov, bool socket = false)
+{
+    iov.clear();
+    for (const LogEntry &e : entries)
+    {
+        std::string_view bytes = e.text();
+        if (!bytes.empty())
+        {
+            iov.push_back({const_cast<char *>(bytes.data()), bytes.size()});
+        }
+    }
+
+    size_t first = 0;
+    while (first < iov.size())
+    {
+        const int count = static_cast<int>(std::min<size_t>(iov.size() - first, IOV_MAX));
+        ssize_t n;
+        if (socket)
+        {
+            struct msghdr msg{};
+            msg.msg_iov = &iov[first];
+            msg.msg_iovlen = static_cast<size_t>(count);
+            n = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+        }
+        else
+        {
+            n = ::writev(fd, &iov[first], count);
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false; // Nowhere left to report the failure
+        }
+
+        // Skip buffers written in full, then trim the one written in part
+        size_t done = static_cast<size_t>(n);
+        while (first < iov.size() && done >= iov[first].iov_len)
+        {
+            done -= iov[first].iov_len;
+            ++first;
+        }
+        if (done > 0)
+        {
+            iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + done;
+            iov[first].iov_len -= done;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Wrap a stream.
+ *
+ * @param stream Stream to write; must outlive the sink.
+ */
+StreamSink::StreamSink(std::ostream &stream)
+    : stream_(stream), fd_(streamFd(stream))
+{
+}
+
+/**
+ * @brief Write a batch to the stream or its descriptor.
+ *
+ * Anything the caller has buffered on a standard stream is flushed first
+ * so ordering holds.
+ *
+ * @param entries Entries to write, oldest first.
+ */
+void StreamSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (fd_ < 0)
+    {
+        for (const LogEntry &e : entries)
+        {
+            std::string_view bytes = e.text();
+            stream_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+        stream_.flush();
+        return;
+    }
+
+    stream_.flush();
+    writeEntries(fd_, entries, iov_);
+}
+
+/**
+ * @brief Wrap a file descriptor.
+ *
+ * @param fd    Descriptor open for writing.
+ * @param owned Close fd when the sink is destroyed.
+ */
+FdSink::FdSink(int fd, bool owned)
+    : fd_(fd), owned_(owned)
+{
+}
+
+/**
+ * @brief Close the descriptor if the sink owns it.
+ */
+FdSink::~FdSink()
+{
+    if (owned_ && fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+/**
+ * @brief Write a batch with writev(2).
+ *
+ * @param entries Entries to write, oldest first.
+ */
+void FdSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    writeEntries(fd_, entries, iov_);
+}
+
+/**
+ * @brief Open path for appending, creating it if needed.
+ *
+ * @param path       File to write.
+ * @param bufferSize Bytes held before writing to the file.
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+FileSink::FileSink(const std::string &path, size_t bufferSize)
+    : path_(path), bufferSize_(bufferSize)
+{
+    if (!reopen())
+    {
+        throw std::runtime_error("Cannot open log file " + path + ": " + std::strerror(errno));
+    }
+    buffer_.reserve(bufferSize_);
+}
+
+/**
+ * @brief Write out buffered bytes and close the file.
+ */
+FileSink::~FileSink()
+{
+    writeOut();
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+/**
+ * @brief Buffer a batch, writing to the file whenever the buffer fills.
+ *
+ * @param entries Entries to write, oldest first.
+ */
+void FileSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (const LogEntry &e : entries)
+    {
+        append(e.text());
+    }
+}
+
+/**
+ * @brief Write buffered bytes to the file.
+ */
+void FileSink::flush()
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    writeOut();
+}
+
+/**
+ * @brief Buffer bytes, writing the buffer out once it is full.
+ *
+ * Caller must hold mtx_.
+ *
+ * @param bytes Bytes to append.
+ */
+void FileSink::append(std::string_view bytes)
+{
+    buffer_.append(bytes.data(), bytes.size());
+    fileBytes_ += bytes.size();
+    if (buffer_.size() >= bufferSize_)
+    {
+        writeOut();
+    }
+}
+
+/**
+ * @brief Write the buffer to the file. Caller must hold mtx_.
+ */
+void FileSink::writeOut()
+{
+    if (fd_ >= 0 && !buffer_.empty())
+    {
+        writeFully(fd_, buffer_.data(), buffer_.size());
+    }
+    buffer_.clear();
+}
+
+/**
+ * @brief Close the current file and open path_ again. Caller must hold mtx_.
+ *
+ * @return False if the file could not be reopened; output is then
+ * discarded until a later reopen succeeds.
+ */
+bool FileSink::reopen()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    fileBytes_ = 0;
+    if (fd_ < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) == 0)
+    {
+        fileBytes_ = static_cast<uint64_t>(st.st_size);
+    }
+    return true;
+}
+
+/**
+ * @brief Open path, rotating by size and optionally by age.
+ *
+ * @param path       File to write.
+ * @param maxBytes   Largest file size before rotating; 0 for no limit.
+ * @param maxAge     Longest time to keep one file; 0 for no limit.
+ * @param keep       Number of rotated files to retain.
+ * @param bufferSize Bytes held before writing to the file.
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+RotatingFileSink::RotatingFileSink(const std::string &path, uint64_t maxBytes,
+                                   std::chrono::seconds maxAge, unsigned keep, size_t bufferSize)
+    : FileSink(path, bufferSize), maxBytes_(maxBytes), maxAge_(maxAge), keep_(keep),
+      opened_(std::chrono::steady_clock::now())
+{
+}
+
+/**
+ * @brief Buffer a batch, rotating before any entry that crosses a limit.
+ *
+ * Entries are never split across files.
+ *
+ * @param entries Entries to write, oldest first.
+ */
+void RotatingFileSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (const LogEntry &e : entries)
+    {
+        const bool tooBig = maxBytes_ > 0 && fileBytes_ > 0 && fileBytes_ + e.text().size() > maxBytes_;
+        const bool tooOld = maxAge_.count() > 0 &&
+                            std::chrono::steady_clock::now() - opened_ >= maxAge_;
+        if (tooBig || tooOld)
+        {
+            rotate();
+        }
+        append(e.text());
+    }
+}
+
+/**
+ * @brief Shift older files up and start a new one. Caller must hold mtx_.
+ *
+ * path.(keep-1) becomes path.keep, and so on down to path becoming
+ * path.1. With keep set to zero the old file is simply removed.
+ */
+void RotatingFileSink::rotate()
+{
+    writeOut();
+    if (keep_ == 0)
+    {
+        std::remove(path_.c_str());
+    }
+    else
+    {
+        for (unsigned i = keep_ - 1; i >= 1; --i)
+        {
+            std::rename((path_ + "." + std::to_string(i)).c_str(),
+                        (path_ + "." + std::to_string(i + 1)).c_str());
+        }
+        std::rename(path_.c_str(), (path_ + ".1").c_str());
+    }
+    reopen();
+    opened_ = std::chrono::steady_clock::now();
+}
+
+#if defined(LCBLOG_WITH_IO_URING)
+
+/**
+ * @struct UringFileSink::Ring
+ * @brief Submission and completion rings, mapped from the kernel, plus
+ * the registered buffers they write from.
+ *
+ * Uses the raw system calls so that no liburing dependency is needed.
+ */
+struct UringFileSink::Ring
+{
+    /**
+     * @struct Buffer
+     * @brief One registered buffer and the write it is part of.
+     */
+    struct Buffer
+    {
+        char *data = nullptr;  /**< Start of the buffer. */
+        size_t used = 0;       /**< Bytes filled. */
+        uint64_t offset = 0;   /**< File offset of the pending write. */
+        bool inFlight = false; /**< Submitted and not yet completed. */
+    };
+
+    int fd = -1;            /**< File being written. */
+    int ringFd = -1;        /**< io_uring instance. */
+    uint64_t offset = 0;    /**< File offset of the next submitted byte. */
+    size_t bufferSize = 0;  /**< Bytes per buffer. */
+    size_t current = 0;     /**< Buffer being filled. */
+    unsigned inFlight = 0;  /**< Writes submitted and not yet completed. */
+
+    void *sqMap = nullptr;  /**< Submission ring mapping. */
+    size_t sqMapSize = 0;
+    void *cqMap = nullptr;  /**< Completion ring mapping; may equal sqMap. */
+    size_t cqMapSize = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned *sqTail = nullptr;
+    unsigned *sqMask = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned *cqMask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    std::unique_ptr<char[]> storage; /**< Backing memory for all buffers. */
+    std::vector<Buffer> buffers;     /**< Registered buffers. */
+
+    ~Ring()
+    {
+        if (sqes != nullptr)
+        {
+            ::munmap(sqes, sqesSize);
+        }
+        if (cqMap != nullptr && cqMap != sqMap)
+        {
+            ::munmap(cqMap, cqMapSize);
+        }
+        if (sqMap != nullptr)
+        {
+            ::munmap(sqMap, sqMapSize);
+        }
+        if (ringFd >= 0)
+        {
+            ::close(ringFd);
+        }
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+
+    /**
+     * @brief Create the ring, map it, and register the buffers.
+     *
+     * @param depth Number of buffers and submission entries.
+     * @return False if the kernel does not support what is needed.
+     */
+    bool setup(unsigned depth)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        ringFd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &params));
+        if (ringFd < 0)
+        {
+            return false;
+        }
+
+        sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            sqMapSize = cqMapSize = std::max(sqMapSize, cqMapSize);
+        }
+        sqMap = ::mmap(nullptr, sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ringFd, IORING_OFF_SQ_RING);
+        if (sqMap == MAP_FAILED)
+        {
+            sqMap = nullptr;
+            return false;
+        }
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            cqMap = sqMap;
+        }
+        else
+        {
+            cqMap = ::mmap(nullptr, cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           ringFd, IORING_OFF_CQ_RING);
+            if (cqMap == MAP_FAILED)
+            {
+                cqMap = nullptr;
+                return false;
+            }
+        }
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void *sqeMap = ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                              ringFd, IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED)
+        {
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe *>(sqeMap);
+
+        char *sq = static_cast<char *>(sqMap);
+        char *cq = static_cast<char *>(cqMap);
+        sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+        // Register the buffers once so each write skips the page pinning
+        storage.reset(new char[depth * bufferSize]);
+        buffers.resize(depth);
+        std::vector<struct iovec> iov(depth);
+        for (unsigned i = 0; i < depth; ++i)
+        {
+            buffers[i].data = storage.get() + i * bufferSize;
+            iov[i].iov_base = buffers[i].data;
+            iov[i].iov_len = bufferSize;
+        }
+        return ::syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, iov.data(), depth) == 0;
+    }
+
+    /**
+     * @brief Write a buffer's bytes synchronously, from skip onwards.
+     *
+     * Used when the kernel rejects a submission or completes it short.
+     *
+     * @param b    Buffer to write.
+     * @param skip Bytes already written.
+     */
+    void writeDirect(const Buffer &b, size_t skip)
+    {
+        while (skip < b.used)
+        {
+            ssize_t n = ::pwrite(fd, b.data + skip, b.used - skip, static_cast<off_t>(b.offset + skip));
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                return; // Nowhere left to report the failure
+            }
+            skip += static_cast<size_t>(n);
+        }
+    }
+
+    /**
+     * @brief Queue the current buffer as a fixed-buffer write.
+     */
+    void submit()
+    {
+        Buffer &b = buffers[current];
+        if (b.used == 0)
+        {
+            return;
+        }
+        b.offset = offset;
+        offset += b.used;
+
+        const unsigned tail = *sqTail;
+        const unsigned index = tail & *sqMask;
+        io_uring_sqe &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_WRITE_FIXED;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(b.data);
+        sqe.len = static_cast<uint32_t>(b.used);
+        sqe.off = b.offset;
+        sqe.buf_index = static_cast<uint16_t>(current);
+        sqe.user_data = current;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+
+        int rc;
+        do
+        {
+            rc = static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, 1, 0, 0, nullptr, 0));
+        } while (rc < 0 && errno == EINTR);
+
+        if (rc == 1)
+        {
+            b.inFlight = true;
+            ++inFlight;
+        }
+        else
+        {
+            // The entry was not consumed; take it back and write it here
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            writeDirect(b, 0);
+            b.used = 0;
+        }
+        advance();
+    }
+
+    /**
+     * @brief Move to the next buffer, waiting if it is still in flight.
+     */
+    void advance()
+    {
+        current = (current + 1) % buffers.size();
+        while (buffers[current].inFlight)
+        {
+            reap(true);
+        }
+    }
+
+    /**
+     * @brief Retire finished writes.
+     *
+     * @param wait Block until at least one write completes.
+     */
+    void reap(bool wait)
+    {
+        if (wait && inFlight > 0)
+        {
+            int rc;
+            do
+            {
+                rc = static_cast<int>(::syscall(__NR_io_uring_enter, ringFd, 0, 1,
+                                                IORING_ENTER_GETEVENTS, nullptr, 0));
+            } while (rc < 0 && errno == EINTR);
+        }
+
+        unsigned head = *cqHead;
+        while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+        {
+            const io_uring_cqe &cqe = cqes[head & *cqMask];
+            Buffer &b = buffers[static_cast<size_t>(cqe.user_data)];
+            // Finish short or failed writes synchronously so nothing is lost
+            const size_t written = cqe.res > 0 ? static_cast<size_t>(cqe.res) : 0;
+            if (written < b.used)
+            {
+                writeDirect(b, written);
+            }
+            b.used = 0;
+            b.inFlight = false;
+            --inFlight;
+            ++head;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+};
+
+#else
+
+/**
+ * @struct UringFileSink::Ring
+ * @brief Placeholder when io_uring support is not compiled in.
+ */
+struct UringFileSink::Ring
+{
+};
+
+#endif // LCBLOG_WITH_IO_URING
+
+/**
+ * @brief Open path for appending, creating it if needed.
+ *
+ * Tries to set up io_uring first and falls back to an FdSink on the same
+ * file if that is not possible.
+ *
+ * @param path       File to write.
+ * @param depth      Number of buffers, and so the most writes in flight.
+ * @param bufferSize Bytes per buffer.
+ * @throws std::runtime_error if the file cannot be opened.
+ * @throws std::invalid_argument if depth or bufferSize is zero.
+ */
+UringFileSink::UringFileSink(const std::string &path, unsigned depth, size_t bufferSize)
+{
+    if (depth == 0 || bufferSize == 0)
+    {
+        throw std::invalid_argument("UringFileSink: depth and bufferSize must be greater than zero");
+    }
+
+#if defined(LCBLOG_WITH_IO_URING)
+    // Writes carry explicit offsets, so the file is not opened for append
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open log file " + path + ": " + std::strerror(errno));
+    }
+    auto ring = std::make_unique<Ring>();
+    ring->fd = fd;
+    ring->bufferSize = bufferSize;
+    struct stat st;
+    if (::fstat(fd, &st) == 0)
+    {
+        ring->offset = static_cast<uint64_t>(st.st_size);
+    }
+    if (ring->setup(depth))
+    {
+        ring_ = std::move(ring);
+        return;
+    }
+#endif
+
+    int appendFd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (appendFd < 0)
+    {
+        throw std::runtime_error("Cannot open log file " + path + ": " + std::strerror(errno));
+    }
+    fallback_ = std::make_unique<FdSink>(appendFd, true);
+}
+
+/**
+ * @brief Submit buffered bytes, wait for every write, and close the file.
+ */
+UringFileSink::~UringFileSink()
+{
+#if defined(LCBLOG_WITH_IO_URING)
+    if (ring_)
+    {
+        ring_->submit();
+        while (ring_->inFlight > 0)
+        {
+            ring_->reap(true);
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Copy a batch into the buffers, submitting each one that fills.
+ *
+ * @param entries Entries to write, oldest first.
+ */
+void UringFileSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (!ring_)
+    {
+        fallback_->write(entries);
+        return;
+    }
+
+#if defined(LCBLOG_WITH_IO_URING)
+    ring_->reap(false);
+    for (const LogEntry &e : entries)
+    {
+        std::string_view bytes = e.text();
+        while (!bytes.empty())
+        {
+            Ring::Buffer &b = ring_->buffers[ring_->current];
+            const size_t n = std::min(bytes.size(), ring_->bufferSize - b.used);
+            std::memcpy(b.data + b.used, bytes.data(), n);
+            b.used += n;
+            bytes.remove_prefix(n);
+            if (b.used == ring_->bufferSize)
+            {
+                ring_->submit();
+            }
+        }
+    }
+#endif
+}
+
+/**
+ * @brief Submit the partly filled buffer without waiting for it.
+ */
+void UringFileSink::flush()
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+#if defined(LCBLOG_WITH_IO_URING)
+    if (ring_)
+    {
+        ring_->submit();
+        ring_->reap(false);
+    }
+#endif
+}
+
+/**
+ * @brief Report whether writes go through io_uring.
+ *
+ * @return False if the sink fell back to plain writes.
+ */
+bool UringFileSink::usingUring() const
+{
+    return ring_ != nullptr;
+}
+
+/**
+ * @struct GzipSink::Deflater
+ * @brief zlib stream for gzip output, plus the chunk it deflates into.
+ */
+struct GzipSink::Deflater
+{
+#if defined(LCBLOG_WITH_ZLIB)
+    z_stream stream{};      /**< Deflate state, reset between members. */
+    Bytef chunk[16 * 1024]; /**< Output staging for one deflate() call. */
+
+    ~Deflater() { deflateEnd(&stream); }
+#endif
+};
+
+/**
+ * @brief Compress into another sink, usually a file sink.
+ *
+ * @param inner      Sink that receives the compressed members.
+ * @param level      zlib compression level, 0 (stored) to 9, or -1 for
+ * zlib's default.
+ * @param frameBytes Input bytes after which a member is closed.
+ * @throws std::invalid_argument if inner is null, level is out of range,
+ * or frameBytes is zero.
+ * @throws std::runtime_error if zlib is not compiled in or cannot be
+ * initialized.
+ */
+GzipSink::GzipSink(std::shared_ptr<LogSink> inner, int level, size_t frameBytes)
+    : inner_(std::move(inner)), frameBytes_(frameBytes)
+{
+    if (!inner_)
+    {
+        throw std::invalid_argument("GzipSink needs an inner sink");
+    }
+    if (level < -1 || level > 9)
+    {
+        throw std::invalid_argument("GzipSink: level must be between 0 and 9, or -1");
+    }
+    if (frameBytes_ == 0)
+    {
+        throw std::invalid_argument("GzipSink: frameBytes must be greater than zero");
+    }
+#if defined(LCBLOG_WITH_ZLIB)
+    auto deflater = std::make_unique<Deflater>();
+    // 16 added to the window bits asks for a gzip header and trailer
+    if (deflateInit2(&deflater->stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("GzipSink: cannot initialize zlib");
+    }
+    deflater_ = std::move(deflater);
+#else
+    throw std::runtime_error("GzipSink: built without zlib");
+#endif
+}
+
+/**
+ * @brief Close the open member and flush the inner sink.
+ */
+GzipSink::~GzipSink()
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (frameInput_ > 0)
+    {
+        endFrame();
+        inner_->flush();
+    }
+}
+
+/**
+ * @brief Deflate each entry into the open member, closing it at frameBytes.
+ *
+ * @param entries Entries to compress, oldest first.
+ */
+void GzipSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    for (const LogEntry &e : entries)
+    {
+        compress(e.text(), NoFlush);
+        frameInput_ += e.text().size();
+        unsynced_ = true;
+        if (frameInput_ >= frameBytes_)
+        {
+            endFrame();
+        }
+    }
+}
+
+/**
+ * @brief Sync the deflater, hand on the bytes so far, and flush the inner
+ * sink.
+ *
+ * A sync point costs a few bytes but keeps the dictionary, so flushing
+ * after every quiet spell still compresses well.
+ */
+void GzipSink::flush()
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (unsynced_)
+    {
+        compress(std::string_view(), SyncFlush);
+        handOn();
+    }
+    inner_->flush();
+}
+
+/**
+ * @brief Deflate bytes into the open member. Caller must hold mtx_.
+ *
+ * @param bytes Input to compress.
+ * @param mode  Flush to apply after the input.
+ */
+void GzipSink::compress(std::string_view bytes, Flush mode)
+{
+#if defined(LCBLOG_WITH_ZLIB)
+    const int flush = mode == Finish ? Z_FINISH : mode == SyncFlush ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+    z_stream &z = deflater_->stream;
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(bytes.data()));
+    z.avail_in = static_cast<uInt>(bytes.size());
+    do
+    {
+        z.next_out = deflater_->chunk;
+        z.avail_out = sizeof(deflater_->chunk);
+        deflate(&z, flush);
+        frame_.msg.append(reinterpret_cast<const char *>(deflater_->chunk), sizeof(deflater_->chunk) - z.avail_out);
+    } while (z.avail_out == 0);
+#else
+    (void)bytes;
+    (void)mode;
+#endif
+}
+
+/**
+ * @brief Pass the compressed bytes held so far to the inner sink. Caller
+ * must hold mtx_.
+ */
+void GzipSink::handOn()
+{
+    if (!frame_.msg.empty())
+    {
+        inner_->write(LogEntrySpan{&frame_, 1});
+        frame_.msg.clear();
+    }
+    unsynced_ = false;
+}
+
+/**
+ * @brief Close the open member and pass it to the inner sink. Caller must
+ * hold mtx_.
+ */
+void GzipSink::endFrame()
+{
+    compress(std::string_view(), Finish);
+#if defined(LCBLOG_WITH_ZLIB)
+    deflateReset(&deflater_->stream);
+#endif
+    handOn();
+    frameInput_ = 0;
+}
+
+/**
+ * @struct MappedRingHeader
+ * @brief Layout of the first 64 bytes of a MappedRingSink file.
+ *
+ * Positions are absolute byte counts since the ring was created; the
+ * data offset of a position is pos % dataSize. Entries in
+ * [oldestPos, writePos) are complete. Each is a 4-byte little-endian
+ * length followed by that many bytes.
+ */
+struct MappedRingHeader
+{
+    char magic[8];        /**< "LCBRING" and a terminating zero. */
+    uint32_t version;     /**< Layout version, currently 1. */
+    uint32_t headerSize;  /**< Bytes before the ring data. */
+    uint64_t dataSize;    /**< Bytes of ring data. */
+    uint64_t writePos;    /**< End of the newest complete entry. */
+    uint64_t oldestPos;   /**< Start of the oldest complete entry. */
+    uint8_t reserved[24]; /**< Pads the header to 64 bytes. */
+};
+
+static_assert(sizeof(MappedRingHeader) == 64, "MappedRingHeader must stay 64 bytes");
+
+static constexpr char mappedRingMagic[8] = "LCBRING";
+
+/**
+ * @brief Open or create a ring file.
+ *
+ * An existing file is reused when its header is valid and its data size
+ * matches; anything else is reinitialized as an empty ring.
+ *
+ * @param path     File to map.
+ * @param dataSize Bytes of log data the ring holds.
+ * @throws std::runtime_error if the file cannot be created or mapped.
+ * @throws std::invalid_argument if dataSize is too small to be useful.
+ */
+MappedRingSink::MappedRingSink(const std::string &path, size_t dataSize)
+    : mapSize_(sizeof(MappedRingHeader) + dataSize), dataSize_(dataSize)
+{
+    if (dataSize < 64)
+    {
+        throw std::invalid_argument("MappedRingSink: dataSize must be at least 64 bytes");
+    }
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open ring file " + path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    const bool sized = ::fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == mapSize_;
+    if (!sized && ::ftruncate(fd, static_cast<off_t>(mapSize_)) != 0)
+    {
+        int saved = errno;
+        ::close(fd);
+        throw std::runtime_error("Cannot size ring file " + path + ": " + std::strerror(saved));
+    }
+    map_ = ::mmap(nullptr, mapSize_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    int saved = errno;
+    ::close(fd); // The mapping keeps the file open
+    if (map_ == MAP_FAILED)
+    {
+        map_ = nullptr;
+        throw std::runtime_error("Cannot map ring file " + path + ": " + std::strerror(saved));
+    }
+    data_ = static_cast<char *>(map_) + sizeof(MappedRingHeader);
+
+    auto *header = static_cast<MappedRingHeader *>(map_);
+    const bool valid = sized && std::memcmp(header->magic, mappedRingMagic, sizeof(header->magic)) == 0 &&
+                       header->version == 1 && header->headerSize == sizeof(MappedRingHeader) &&
+                       header->dataSize == dataSize_ && header->oldestPos <= header->writePos &&
+                       header->writePos - header->oldestPos <= dataSize_;
+    if (!valid)
+    {
+        std::memset(header, 0, sizeof(MappedRingHeader));
+        header->version = 1;
+        header->headerSize = sizeof(MappedRingHeader);
+        header->dataSize = dataSize_;
+        // Magic last, so a half-written header is never taken for a ring
+        std::memcpy(header->magic, mappedRingMagic, sizeof(header->magic));
+    }
+}
+
+/**
+ * @brief Unmap the file; its contents stay on disk.
+ */
+MappedRingSink::~MappedRingSink()
+{
+    if (map_ != nullptr)
+    {
+        ::munmap(map_, mapSize_);
+    }
+}
+
+/**
+ * @brief Copy bytes into the ring at an absolute position, wrapping.
+ *
+ * @param pos  Absolute position; reduced modulo the data size.
+ * @param data Bytes to copy.
+ * @param size Number of bytes.
+ */
+void MappedRingSink::put(uint64_t pos, const void *data, size_t size)
+{
+    const size_t at = static_cast<size_t>(pos % dataSize_);
+    const size_t first = std::min(size, dataSize_ - at);
+    std::memcpy(data_ + at, data, first);
+    std::memcpy(data_, static_cast<const char *>(data) + first, size - first);
+}
+
+/**
+ * @brief Read the length stored at an absolute position.
+ *
+ * @param pos Absolute position of a record.
+ * @return Stored length.
+ */
+uint32_t MappedRingSink::lengthAt(uint64_t pos) const
+{
+    unsigned char bytes[4];
+    for (size_t i = 0; i < 4; ++i)
+    {
+        bytes[i] = static_cast<unsigned char>(data_[(pos + i) % dataSize_]);
+    }
+    return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+           static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+}
+
+/**
+ * @brief Copy a batch into the ring.
+ *
+ * For each entry the oldest position is first moved past every entry the
+ * new one will overwrite, then the bytes are copied, and only then is the
+ * write position advanced. A process killed at any point leaves
+ * [oldestPos, writePos) holding complete entries. A stored length that
+ * runs past the write position means the file was damaged; the ring is
+ * then emptied rather than walked with a bad length.
+ *
+ * @param entries Entries to write, oldest first.
+ */
+void MappedRingSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    auto *header = static_cast<MappedRingHeader *>(map_);
+    uint64_t writePos = header->writePos;
+    uint64_t oldestPos = header->oldestPos;
+
+    for (const LogEntry &e : entries)
+    {
+        std::string_view bytes = e.text();
+        if (bytes.empty())
+        {
+            continue;
+        }
+        bytes = bytes.substr(0, dataSize_ - 4);
+        const uint64_t end = writePos + 4 + bytes.size();
+
+        // Retire entries that the new one will overwrite
+        while (end - oldestPos > dataSize_)
+        {
+            const uint64_t live = writePos - oldestPos;
+            const uint64_t step = live < 4 ? 0 : 4 + uint64_t{lengthAt(oldestPos)};
+            if (step == 0 || step > live)
+            {
+                // Corrupt length: nothing from here on can be trusted
+                oldestPos = writePos;
+                break;
+            }
+            oldestPos += step;
+        }
+        __atomic_store_n(&header->oldestPos, oldestPos, __ATOMIC_RELEASE);
+
+        unsigned char length[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            length[i] = static_cast<unsigned char>(bytes.size() >> (8 * i));
+        }
+        put(writePos, length, sizeof(length));
+        put(writePos + 4, bytes.data(), bytes.size());
+        writePos = end;
+        __atomic_store_n(&header->writePos, writePos, __ATOMIC_RELEASE);
+    }
+}
+
+/**
+ * @brief Read the entries that survive in a ring file.
+ *
+ * @param path  Ring file written by a MappedRingSink.
+ * @param out   Receives the entries, oldest first.
+ * @param error Receives a description when recovery fails; may be null.
+ * @return False if the file is missing or not a valid ring.
+ */
+bool MappedRingSink::recover(const std::string &path, std::string &out, std::string *error)
+{
+    auto fail = [error](const std::string &why)
+    {
+        if (error != nullptr)
+        {
+            *error = why;
+        }
+        return false;
+    };
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return fail(std::string("cannot open: ") + std::strerror(errno));
+    }
+    std::string file;
+    char chunk[65536];
+    ssize_t n;
+    while ((n = ::read(fd, chunk, sizeof(chunk))) > 0 || (n < 0 && errno == EINTR))
+    {
+        if (n > 0)
+        {
+            file.append(chunk, static_cast<size_t>(n));
+        }
+    }
+    ::close(fd);
+
+    MappedRingHeader header;
+    if (file.size() < sizeof(header))
+    {
+        return fail("file is too short to be a ring");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, mappedRingMagic, sizeof(header.magic)) != 0 || header.version != 1 ||
+        header.headerSize != sizeof(header) || file.size() != sizeof(header) + header.dataSize ||
+        header.dataSize == 0)
+    {
+        return fail("not a ring file");
+    }
+    if (header.oldestPos > header.writePos || header.writePos - header.oldestPos > header.dataSize)
+    {
+        return fail("ring positions are inconsistent");
+    }
+
+    const char *data = file.data() + sizeof(header);
+    const uint64_t size = header.dataSize;
+    auto byteAt = [&](uint64_t pos)
+    { return static_cast<unsigned char>(data[pos % size]); };
+
+    for (uint64_t pos = header.oldestPos; pos < header.writePos;)
+    {
+        if (header.writePos - pos < 4)
+        {
+            return fail("truncated entry length");
+        }
+        const uint32_t len = static_cast<uint32_t>(byteAt(pos)) | static_cast<uint32_t>(byteAt(pos + 1)) << 8 |
+                             static_cast<uint32_t>(byteAt(pos + 2)) << 16 |
+                             static_cast<uint32_t>(byteAt(pos + 3)) << 24;
+        pos += 4;
+        if (header.writePos - pos < len)
+        {
+            return fail("truncated entry");
+        }
+        const size_t at = static_cast<size_t>(pos % size);
+        const size_t first = std::min<size_t>(len, size - at);
+        out.append(data + at, first);
+        out.append(data, len - first);
+        pos += len;
+    }
+    return true;
+}
+
+/**
+ * @brief Map a log level to a syslog severity.
+ *
+ * @param level Level to map.
+ * @return Severity from 2 (critical) for FATAL to 7 (debug) for DEBUG.
+ */
+static int syslogSeverity(LogLevel level)
+{
+    switch (level)
+    {
+    case DEBUG:
+        return 7;
+    case WARN:
+        return 4;
+    case ERROR:
+        return 3;
+    case FATAL:
+        return 2;
+    default:
+        return 6;
+    }
+}
+
+/**
+ * @brief Drop one trailing newline, which syslog and the journal supply.
+ *
+ * @param text Entry text.
+ * @return text without its final newline.
+ */
+static std::string_view withoutNewline(std::string_view text)
+{
+    if (!text.empty() && text.back() == '\n')
+    {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+/**
+ * @brief Build a Unix socket address.
+ *
+ * @param path Socket path.
+ * @return The address.
+ * @throws std::invalid_argument if path is empty or too long.
+ */
+static SocketAddress unixAddress(const std::string &path)
+{
+    struct sockaddr_un addr{};
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+    {
+        throw std::invalid_argument("Unix socket path is empty or too long: " + path);
+    }
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    SocketAddress peer;
+    std::memcpy(&peer.addr, &addr, sizeof(addr));
+    peer.size = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + path.size() + 1);
+    return peer;
+}
+
+/**
+ * @brief Resolve a host and port to its first address.
+ *
+ * @param host Host name or numeric address.
+ * @param port Port number.
+ * @param type SOCK_DGRAM or SOCK_STREAM.
+ * @return The address.
+ * @throws std::runtime_error if host cannot be resolved.
+ */
+static SocketAddress resolveAddress(const std::string &host, uint16_t port, int type)
+{
+    struct addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = type;
+    hints.ai_flags = AI_NUMERICSERV;
+    struct addrinfo *found = nullptr;
+    const int rc = ::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &found);
+    if (rc != 0 || found == nullptr)
+    {
+        throw std::runtime_error("Cannot resolve " + host + ": " + ::gai_strerror(rc));
+    }
+    SocketAddress peer;
+    std::memcpy(&peer.addr, found->ai_addr, found->ai_addrlen);
+    peer.size = found->ai_addrlen;
+    ::freeaddrinfo(found);
+    return peer;
+}
+
+/**
+ * @brief Open a socket of the given type connected to peer.
+ *
+ * @param peer Address to connect to.
+ * @param type SOCK_DGRAM or SOCK_STREAM.
+ * @return Connected descriptor, or -1.
+ */
+static int connectSocket(const SocketAddress &peer, int type)
+{
+    int fd = ::socket(peer.addr.ss_family, type | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<const struct sockaddr *>(&peer.addr), peer.size) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Remember the peer and connect to it.
+ *
+ * A peer that is not there yet is retried on every batch.
+ *
+ * @param peer Peer address.
+ */
+DatagramSink::DatagramSink(const SocketAddress &peer)
+    : peer_(peer)
+{
+    reconnect();
+}
+
+/**
+ * @brief Close the socket.
+ */
+DatagramSink::~DatagramSink()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+/**
+ * @brief Open a new socket to the peer, closing the old one.
+ *
+ * @return False if the socket could not be created or connected.
+ */
+bool DatagramSink::reconnect()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+    fd_ = connectSocket(peer_, SOCK_DGRAM);
+    return fd_ >= 0;
+}
+
+/**
+ * @brief Send the batch, one datagram per entry.
+ *
+ * Headers for the whole batch are built first, so the scatter lists can
+ * point into headers_ without it moving. A datagram too large for the
+ * socket is skipped; other failures reconnect once and then drop what is
+ * left of the batch.
+ *
+ * @param entries Entries to send, oldest first.
+ */
+void DatagramSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    headers_.clear();
+    datagrams_.clear();
+    for (const LogEntry &e : entries)
+    {
+        std::string_view body = e.text();
+        const size_t start = headers_.size();
+        std::string_view trailer = frame(e, headers_, body);
+        datagrams_.push_back(Datagram{start, headers_.size() - start, body, trailer});
+    }
+
+    const size_t count = datagrams_.size();
+    iov_.resize(3 * count);
+    msgs_.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Datagram &d = datagrams_[i];
+        iov_[3 * i] = {&headers_[d.headerStart], d.headerSize};
+        iov_[3 * i + 1] = {const_cast<char *>(d.body.data()), d.body.size()};
+        iov_[3 * i + 2] = {const_cast<char *>(d.trailer.data()), d.trailer.size()};
+        msgs_[i] = {};
+        msgs_[i].msg_hdr.msg_iov = &iov_[3 * i];
+        msgs_[i].msg_hdr.msg_iovlen = 3;
+    }
+
+    if (fd_ < 0 && !reconnect())
+    {
+        return;
+    }
+    size_t sent = 0;
+    bool retried = false;
+    while (sent < count)
+    {
+        const unsigned burst = static_cast<unsigned>(std::min<size_t>(count - sent, IOV_MAX));
+        const int n = ::sendmmsg(fd_, &msgs_[sent], burst, MSG_NOSIGNAL);
+        if (n > 0)
+        {
+            sent += static_cast<size_t>(n);
+            continue;
+        }
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n < 0 && errno == EMSGSIZE)
+        {
+            ++sent; // Too large for one datagram
+            continue;
+        }
+        if (retried || !reconnect())
+        {
+            return; // Peer is gone; drop the rest
+        }
+        retried = true;
+    }
+}
+
+/**
+ * @brief Connect to a syslog daemon.
+ *
+ * HOSTNAME and PROCID are fixed here, so a forked child reports its
+ * parent's PID.
+ *
+ * @param appName  APP-NAME field.
+ * @param facility Facility code, 0 to 23; 1 is user-level messages.
+ * @param path     Datagram socket the daemon reads.
+ * @throws std::invalid_argument if facility or path is out of range.
+ */
+SyslogSink::SyslogSink(const std::string &appName, int facility, const std::string &path)
+    : DatagramSink(unixAddress(path)), facility_(facility)
+{
+    if (facility < 0 || facility > 23)
+    {
+        throw std::invalid_argument("SyslogSink facility must be 0 to 23");
+    }
+    char host[256] = {};
+    if (::gethostname(host, sizeof(host) - 1) != 0 || host[0] == '\0')
+    {
+        std::strcpy(host, "-");
+    }
+    // TIMESTAMP HOSTNAME APP-NAME PROCID MSGID STRUCTURED-DATA
+    prefix_ = std::string("- ") + host + ' ' + (appName.empty() ? "-" : appName) + ' ' +
+              std::to_string(::getpid()) + " - - ";
+}
+
+/**
+ * @brief Prefix an entry with its priority and the fixed header fields.
+ *
+ * @param e      Entry being sent.
+ * @param header Buffer to append the header to.
+ * @param body   Entry text; its trailing newline is dropped.
+ * @return Empty trailer.
+ */
+std::string_view SyslogSink::frame(const LogEntry &e, std::string &header, std::string_view &body)
+{
+    char digits[8];
+    const char *end = std::to_chars(digits, digits + sizeof(digits), facility_ * 8 + syslogSeverity(e.level)).ptr;
+    header.push_back('<');
+    header.append(digits, static_cast<size_t>(end - digits));
+    header.append(">1 ");
+    header.append(prefix_);
+    body = withoutNewline(body);
+    return {};
+}
+
+/**
+ * @brief Connect to the journal.
+ *
+ * @param identifier SYSLOG_IDENTIFIER field.
+ * @param path       Native protocol socket.
+ * @throws std::invalid_argument if path is too long or identifier
+ * contains a newline.
+ */
+JournaldSink::JournaldSink(const std::string &identifier, const std::string &path)
+    : DatagramSink(unixAddress(path)), identifier_(identifier)
+{
+    if (identifier.find('\n') != std::string::npos)
+    {
+        throw std::invalid_argument("JournaldSink identifier must not contain a newline");
+    }
+}
+
+/**
+ * @brief Encode the fixed fields and the message length.
+ *
+ * The message uses the binary field form: the name, a newline, a 64-bit
+ * little-endian length, the bytes, and a closing newline.
+ *
+ * @param e      Entry being sent.
+ * @param header Buffer to append the fields to.
+ * @param body   Entry text; its trailing newline is dropped.
+ * @return The newline that ends the MESSAGE field.
+ */
+std::string_view JournaldSink::frame(const LogEntry &e, std::string &header, std::string_view &body)
+{
+    header.append("PRIORITY=");
+    header.push_back(static_cast<char>('0' + syslogSeverity(e.level)));
+    header.append("\nSYSLOG_IDENTIFIER=");
+    header.append(identifier_);
+    header.append("\nMESSAGE\n");
+    body = withoutNewline(body);
+    const uint64_t size = body.size();
+    for (int i = 0; i < 8; ++i)
+    {
+        header.push_back(static_cast<char>((size >> (8 * i)) & 0xff));
+    }
+    return "\n";
+}
+
+/**
+ * @brief Resolve a collector address.
+ *
+ * @param host Host name or numeric address.
+ * @param port Port number.
+ * @throws std::runtime_error if host cannot be resolved.
+ */
+UdpSink::UdpSink(const std::string &host, uint16_t port)
+    : DatagramSink(resolveAddress(host, port, SOCK_DGRAM))
+{
+}
+
+/**
+ * @brief Send an entry as formatted.
+ *
+ * @param e      Entry being sent.
+ * @param header Left empty.
+ * @param body   Entry text, unchanged.
+ * @return Empty trailer.
+ */
+std::string_view UdpSink::frame(const LogEntry & /*e*/, std::string & /*header*/, std::string_view & /*body*/)
+{
+    return {};
+}
+
+/**
+ * @brief Resolve a collector address and try to connect.
+ *
+ * A collector that is down now is retried on the next batch.
+ *
+ * @param host Host name or numeric address.
+ * @param port Port number.
+ * @throws std::runtime_error if host cannot be resolved.
+ */
+TcpSink::TcpSink(const std::string &host, uint16_t port)
+    : peer_(resolveAddress(host, port, SOCK_STREAM))
+{
+    reconnect();
+}
+
+/**
+ * @brief Close the connection.
+ */
+TcpSink::~TcpSink()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+}
+
+/**
+ * @brief Open a new connection, closing the old one. Caller must hold mtx_.
+ *
+ * @return False if the collector could not be reached.
+ */
+bool TcpSink::reconnect()
+{
+    if (fd_ >= 0)
+    {
+        ::close(fd_);
+    }
+    fd_ = connectSocket(peer_, SOCK_STREAM);
+    return fd_ >= 0;
+}
+
+/**
+ * @brief Stream a batch, reconnecting first if the connection is down.
+ *
+ * A batch interrupted by a failed send is not resent, since the
+ * collector may already hold part of it.
+ *
+ * @param entries Entries to send, oldest first.
+ */
+void TcpSink::write(LogEntrySpan entries)
+{
+    std::lock_guard<std::mutex> lk(mtx_);
+    if (fd_ < 0 && !reconnect())
+    {
+        return;
+    }
+    if (!writeEntries(fd_, entries, iov_, true))
+    {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+/**
+ * @struct FormatRegistry
+ * @brief Process-wide table of texts registered with registerFormat().
+ *
+ * A deque keeps each string at a fixed address as the table grows, so
+ * LogFormat::text stays valid.
+ */
+struct FormatRegistry
+{
+    std::mutex mtx;                /**< Guards texts. */
+    std::deque<std::string> texts; /**< Text by format ID. */
+};
+
+/**
+ * @brief Access the process-wide format table.
+ *
+ * @return Reference to the table, created on first use.
+ */
+static FormatRegistry &formatRegistry()
+{
+    static FormatRegistry registry;
+    return registry;
+}
+
+/**
+ * @brief Append the text registered under a format ID.
+ *
+ * @param buffer Destination buffer.
+ * @param id     Format ID.
+ * @return False if no format has that ID.
+ */
+static bool appendRegisteredFormat(std::string &buffer, uint32_t id)
+{
+    FormatRegistry &registry = formatRegistry();
+    std::lock_guard<std::mutex> lk(registry.mtx);
+    if (id >= registry.texts.size())
+    {
+        return false;
+    }
+    buffer.append(registry.texts[id]);
+    return true;
+}
+
+/**
+ * @brief Check that every field holds a usable value.
+ *
+ * @throws std::invalid_argument naming the first offending field.
+ */
+void LCBLogConfig::validate() const
+{
+    if (queueCapacity == 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: queueCapacity must be at least 1");
+    }
+    if (batchSize == 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: batchSize must be at least 1");
+    }
+    if (flushInterval.count() <= 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: flushInterval must be positive");
+    }
+    if (blockTimeout.count() < 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: blockTimeout must not be negative");
+    }
+    if (threadQueueCapacity == 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: threadQueueCapacity must be at least 1");
+    }
+    if (statsInterval.count() < 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: statsInterval must not be negative");
+    }
+    if (shutdownTimeout.count() < 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: shutdownTimeout must not be negative");
+    }
+    for (int cpu : workerCpus)
+    {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+        {
+            throw std::invalid_argument("LCBLogConfig: workerCpus holds an invalid core number");
+        }
+    }
+    if (workerNice < -20 || workerNice > 19)
+    {
+        throw std::invalid_argument("LCBLogConfig: workerNice must be between -20 and 19");
+    }
+    if (workerRealtimePriority < 0 || workerRealtimePriority > 99)
+    {
+        throw std::invalid_argument("LCBLogConfig: workerRealtimePriority must be between 0 and 99");
+    }
+    if (workerSpin.count() < 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: workerSpin must not be negative");
+    }
+    if (overflowPolicy == GrowToCap && overflowByteCap == 0)
+    {
+        throw std::invalid_argument("LCBLogConfig: overflowByteCap must be positive for GrowToCap");
+    }
+}
+
+/**
+ * @brief Append a 32-bit value in little-endian order.
+ *
+ * @param buffer Destination buffer.
+ * @param value  Value to append.
+ */
+void LogPack::putU32(std::string &buffer, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        buffer.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+/**
+ * @brief Append a 64-bit value in little-endian order.
+ *
+ * @param buffer Destination buffer.
+ * @param value  Value to append.
+ */
+void LogPack::putU64(std::string &buffer, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        buffer.push_back(static_cast<char>(value >> (8 * i)));
+    }
+}
+
+/**
+ * @brief Consume a little-endian 32-bit value.
+ *
+ * @param in    Encoded bytes; advanced on success.
+ * @param value Receives the decoded value.
+ * @return False if in is too short.
+ */
+bool LogPack::getU32(std::string_view &in, uint32_t &value)
+{
+    if (in.size() < 4)
+    {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        value |= static_cast<uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    in.remove_prefix(4);
+    return true;
+}
+
+/**
+ * @brief Consume a little-endian 64-bit value.
+ *
+ * @param in    Encoded bytes; advanced on success.
+ * @param value Receives the decoded value.
+ * @return False if in is too short.
+ */
+bool LogPack::getU64(std::string_view &in, uint64_t &value)
+{
+    if (in.size() < 8)
+    {
+        return false;
+    }
+    value = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    }
+    in.remove_prefix(8);
+    return true;
+}
+
+/**
+ * @brief Append the style byte and timestamp.
+ *
+ * @param buffer Destination buffer.
+ * @param style  Style to encode.
+ */
+void LogPack::putHeader(std::string &buffer, const LogStyle &style)
+{
+    uint8_t bits = 0;
+    bits |= style.timestamps ? Stamped : 0;
+    bits |= style.normalize ? Normalized : 0;
+    bits |= style.precision == StampMicros ? Micros : 0;
+    buffer.push_back(static_cast<char>(bits));
+    putU64(buffer, static_cast<uint64_t>(style.stamp.sec));
+    putU32(buffer, static_cast<uint32_t>(style.stamp.nsec));
+}
+
+/**
+ * @brief Consume the style byte and timestamp.
+ *
+ * @param in    Encoded bytes; advanced past the header on success.
+ * @param style Receives the decoded style.
+ * @return False if in is too short.
+ */
+bool LogPack::getHeader(std::string_view &in, LogStyle &style)
+{
+    if (in.size() < headerSize)
+    {
+        return false;
+    }
+    uint8_t bits = static_cast<uint8_t>(in[0]);
+    in.remove_prefix(1);
+    uint64_t sec = 0;
+    uint32_t nsec = 0;
+    getU64(in, sec);
+    getU32(in, nsec);
+    style.timestamps = (bits & Stamped) != 0;
+    style.normalize = (bits & Normalized) != 0;
+    style.precision = (bits & Micros) ? StampMicros : StampMillis;
+    style.stamp.sec = static_cast<int64_t>(sec);
+    style.stamp.nsec = static_cast<int32_t>(nsec);
+    return true;
+}
+
+/**
+ * @brief Append a Text argument.
+ *
+ * @param buffer Destination buffer.
+ * @param text   Characters to copy.
+ */
+void LogPack::putText(std::string &buffer, std::string_view text)
+{
+    buffer.push_back(Text);
+    putU32(buffer, static_cast<uint32_t>(text.size()));
+    buffer.append(text.data(), text.size());
+}
+
+/**
+ * @brief Consume one argument.
+ *
+ * @param in  Encoded arguments; advanced past the argument on success.
+ * @param arg Receives the decoded argument.
+ * @return False if the tag is unknown or in is too short.
+ */
+bool LogPack::nextArg(std::string_view &in, Arg &arg)
+{
+    if (in.empty())
+    {
+        return false;
+    }
+    std::string_view rest = in.substr(1);
+    arg.tag = static_cast<Tag>(in[0]);
+    arg.raw = 0;
+    arg.text = std::string_view();
+
+    uint32_t len = 0;
+    switch (arg.tag)
+    {
+    case Int:
+    case Uint:
+    case Float:
+    case Pointer:
+        if (!getU64(rest, arg.raw))
+        {
+            return false;
+        }
+        break;
+    case Char:
+    case Bool:
+        if (rest.empty())
+        {
+            return false;
+        }
+        arg.raw = static_cast<unsigned char>(rest[0]);
+        rest.remove_prefix(1);
+        break;
+    case Null:
+        break;
+    case Text:
+        if (!getU32(rest, len) || rest.size() < len)
+        {
+            return false;
+        }
+        arg.text = rest.substr(0, len);
+        rest.remove_prefix(len);
+        break;
+    case Borrowed:
+    {
+        uint64_t size = 0;
+        if (!getU64(rest, arg.raw) || !getU64(rest, size))
+        {
+            return false;
+        }
+        arg.text = std::string_view(reinterpret_cast<const char *>(static_cast<std::uintptr_t>(arg.raw)), size);
+        break;
+    }
+    case Format:
+        if (!getU32(rest, len))
+        {
+            return false;
+        }
+        arg.raw = len;
+        break;
+    default:
+        return false;
+    }
+    in = rest;
+    return true;
+}
+
+/**
+ * @brief Construct a ring holding up to capacity entries.
+ *
+ * Slot i starts with sequence number i, which marks it free for the
+ * producer that claims position i. Reserving each slot's buffer up
+ * front means pushes of messages up to reserve bytes never allocate,
+ * even on the first lap; buffers then circulate between the slots and
+ * the worker's batch.
+ *
+ * @param capacity Number of slots; values below one are raised to one.
+ * @param reserve  Bytes preallocated in each slot's message buffer.
+ */
+LogRing::LogRing(size_t capacity, size_t reserve)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      reserve_(reserve),
+      slots_(new Slot[capacity_]),
+      limit_(capacity_)
+{
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+        slots_[i].seq.store(i, std::memory_order_relaxed);
+        slots_[i].entry.msg.reserve(reserve_);
+    }
+}
+
+/**
+ * @brief Copy a message into the next free slot.
+ *
+ * Claims a position with a compare-and-swap on head_, fills the slot,
+ * then publishes it by advancing the slot's sequence number.
+ *
+ * @param dest   Destination recorded with the entry.
+ * @param level  Severity recorded with the entry.
+ * @param text   Formatted message text or packed arguments.
+ * @param packed True if text is a LogPack encoding.
+ * @param shared Buffer holding text for several queues; when set it is
+ * referenced instead of copying text.
+ * @param stamp  Enqueue time recorded with the entry.
+ * @return True if the entry was queued, false if the ring is full.
+ */
+bool LogRing::tryPush(LogEntry::Destination dest, LogLevel level, std::string_view text, bool packed,
+                      const std::shared_ptr<const std::string> &shared, int64_t stamp)
+{
+    size_t pos = head_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;)
+    {
+        slot = &slots_[pos % capacity_];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+        if (diff == 0)
+        {
+            // Respect a limit set below the slot count
+            if (pos - tail_.load(std::memory_order_relaxed) >= limit_.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+            // Slot is free for this position; try to claim it
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Slot still holds the entry from the previous lap
+            return false;
+        }
+        else
+        {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->entry.dest = dest;
+    slot->entry.level = level;
+    slot->entry.packed = packed;
+    slot->entry.stamp = stamp;
+    if (shared)
+    {
+        slot->entry.shared = shared;
+        slot->entry.msg.clear();
+    }
+    else
+    {
+        slot->entry.shared.reset();
+        slot->entry.msg.assign(text.data(), text.size());
+    }
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Remove the oldest entry, swapping its contents into out.
+ *
+ * Claims a position with a compare-and-swap on tail_, so it is safe to
+ * call from several threads at once. The slot is then marked free for
+ * the producer one lap ahead. The overflow list is served only once the
+ * ring is empty; while a claimed slot is still being filled this
+ * returns false, so every producer's messages leave in the order it
+ * queued them.
+ *
+ * @param out Receives the entry; its previous buffer returns to the slot.
+ * @return True if an entry was removed, false if the ring is empty.
+ */
+bool LogRing::tryPop(LogEntry &out)
+{
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;)
+    {
+        slot = &slots_[pos % capacity_];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+        if (diff == 0)
+        {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Nothing published at this position; fall back to the overflow list
+            if (spillCount_.load(std::memory_order_acquire) == 0)
+            {
+                return false;
+            }
+            // Listed entries are newer than every claimed slot, so wait for a
+            // slot that is still being filled rather than pass it
+            if (head_.load(std::memory_order_relaxed) != pos)
+            {
+                const size_t tail = tail_.load(std::memory_order_relaxed);
+                if (tail != pos || slot->seq.load(std::memory_order_acquire) == pos + 1)
+                {
+                    pos = tail;
+                    continue;
+                }
+                return false;
+            }
+            std::lock_guard<std::mutex> lk(spillMtx_);
+            if (spill_.empty())
+            {
+                return false;
+            }
+            std::swap(out, spill_.front());
+            spillBytes_ -= out.text().size();
+            spill_.pop_front();
+            spillCount_.fetch_sub(1, std::memory_order_release);
+            return true;
+        }
+        else
+        {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::swap(out, slot->entry);
+    slot->seq.store(pos + capacity_, std::memory_order_release);
+
+    // Release a producer waiting under BlockWithTimeout
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (blocked_.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lk(spaceMtx_);
+        spaceCv_.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Discard the oldest entry to make room for a new one.
+ *
+ * @return True if an entry was discarded.
+ */
+bool LogRing::discardOldest()
+{
+    static thread_local LogEntry discarded;
+    return tryPop(discarded);
+}
+
+/**
+ * @brief Append a message to the overflow list if it fits the byte cap.
+ *
+ * @param dest    Destination recorded with the entry.
+ * @param level   Severity recorded with the entry.
+ * @param text    Formatted message text or packed arguments.
+ * @param byteCap Maximum total bytes held in the overflow list.
+ * @param packed  True if text is a LogPack encoding.
+ * @param shared  Buffer holding text for several queues; when set it is
+ * referenced instead of copying text.
+ * @param stamp   Enqueue time recorded with the entry.
+ * @return True if the entry was queued, false if it would exceed the cap.
+ */
+bool LogRing::trySpill(LogEntry::Destination dest, LogLevel level, std::string_view text, size_t byteCap,
+                       bool packed, const std::shared_ptr<const std::string> &shared, int64_t stamp)
+{
+    std::lock_guard<std::mutex> lk(spillMtx_);
+    if (spillBytes_ + text.size() > byteCap)
+    {
+        return false;
+    }
+    spill_.emplace_back();
+    spill_.back().dest = dest;
+    spill_.back().level = level;
+    spill_.back().packed = packed;
+    spill_.back().stamp = stamp;
+    if (shared)
+    {
+        spill_.back().shared = shared;
+    }
+    else
+    {
+        spill_.back().msg.assign(text.data(), text.size());
+    }
+    spillBytes_ += text.size();
+    // Count the entry as listed before as accepted, so poppedTotal() never runs ahead
+    spillCount_.fetch_add(1, std::memory_order_release);
+    spilledTotal_.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Check whether the overflow list holds entries.
+ *
+ * @return True while entries are waiting in the overflow list.
+ */
+bool LogRing::spilling() const
+{
+    return spillCount_.load(std::memory_order_acquire) != 0;
+}
+
+/**
+ * @brief Wait until a slot may be free or the deadline passes.
+ *
+ * Registers as blocked so that tryPop() signals after freeing a slot.
+ * A true return means "try again", not a guaranteed free slot.
+ *
+ * @param deadline Latest time to keep waiting.
+ * @return False if the deadline passed, true otherwise.
+ */
+bool LogRing::waitForSpace(std::chrono::steady_clock::time_point deadline)
+{
+    blocked_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    bool inTime;
+    {
+        std::unique_lock<std::mutex> lk(spaceMtx_);
+        inTime = spaceCv_.wait_until(lk, deadline, [&]
+                                     { return size() < limit_.load(std::memory_order_relaxed); });
+    }
+    blocked_.fetch_sub(1, std::memory_order_relaxed);
+    return inTime;
+}
+
+/**
+ * @brief Count one message lost to overflow.
+ */
+void LogRing::recordDrop()
+{
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    droppedTotal_.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Return and reset the drops not yet reported by the worker.
+ *
+ * @return Messages dropped since the previous call.
+ */
+uint64_t LogRing::takeDropped()
+{
+    return dropped_.exchange(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Return the total number of messages dropped by this queue.
+ *
+ * @return Cumulative drop count.
+ */
+uint64_t LogRing::droppedTotal() const
+{
+    return droppedTotal_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Check whether any published entry is waiting.
+ *
+ * Overflow entries behind a slot that is still being filled do not
+ * count, matching what tryPop() will hand out.
+ *
+ * @return True if neither the ring nor the overflow list holds an entry
+ * that tryPop() can take.
+ */
+bool LogRing::empty() const
+{
+    size_t pos = tail_.load(std::memory_order_acquire);
+    size_t seq = slots_[pos % capacity_].seq.load(std::memory_order_acquire);
+    if (seq == pos + 1)
+    {
+        return false;
+    }
+    return !spilling() || head_.load(std::memory_order_relaxed) != pos;
+}
+
+/**
+ * @brief Return the approximate number of queued entries.
+ *
+ * @return Entries claimed by producers and not yet popped.
+ */
+size_t LogRing::size() const
+{
+    size_t tail = tail_.load(std::memory_order_acquire);
+    size_t head = head_.load(std::memory_order_acquire);
+    return head > tail ? head - tail : 0;
+}
+
+/**
+ * @brief Return the number of entries ever accepted by the ring and
+ * its overflow list.
+ *
+ * @return Cumulative accepted entries, including ones later evicted.
+ */
+uint64_t LogRing::pushedTotal() const
+{
+    return head_.load(std::memory_order_relaxed) + spilledTotal_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Return the number of entries ever removed from the ring and
+ * its overflow list, by the consumer or by eviction.
+ *
+ * Spilled entries count as removed once they leave the overflow list.
+ * Reading the accepted total before the listed count means a concurrent
+ * spill can only make the result too low.
+ *
+ * @return Cumulative removed entries.
+ */
+uint64_t LogRing::poppedTotal() const
+{
+    const uint64_t spilled = spilledTotal_.load(std::memory_order_acquire);
+    const uint64_t listed = spillCount_.load(std::memory_order_acquire);
+    return tail_.load(std::memory_order_acquire) + (spilled > listed ? spilled - listed : 0);
+}
+
+/**
+ * @brief Write every published, unpopped text entry to fd.
+ *
+ * Walks the positions between tail_ and head_, writing slots whose
+ * sequence number shows a published entry. Nothing is removed, and an
+ * entry popped while it is being written may be written anyway; this is
+ * meant for a process that is about to die.
+ *
+ * @param fd Destination descriptor.
+ * @return Packed entries skipped because they need formatting.
+ */
+size_t LogRing::dumpPending(int fd) const
+{
+    size_t skipped = 0;
+    const size_t head = head_.load(std::memory_order_acquire);
+    for (size_t pos = tail_.load(std::memory_order_acquire); pos < head; ++pos)
+    {
+        const Slot &slot = slots_[pos % capacity_];
+        if (slot.seq.load(std::memory_order_acquire) != pos + 1)
+        {
+            continue; // Claimed but not yet published, or already popped
+        }
+        if (slot.entry.packed)
+        {
+            ++skipped;
+            continue;
+        }
+        std::string_view text = slot.entry.text();
+        writeFully(fd, text.data(), text.size());
+    }
+    return skipped;
+}
+
+/**
+ * @brief Lower the number of entries accepted before the ring is full.
+ *
+ * Entries already queued above a new, lower limit stay queued; the
+ * limit only affects later pushes.
+ *
+ * @param limit Entry limit, clamped to the range 1..capacity().
+ */
+void LogRing::setLimit(size_t limit)
+{
+    limit_.store(std::min(std::max<size_t>(limit, 1), capacity_), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Wake the consumer if it is parked.
+ *
+ * The fence orders the slot publication before the sleeping_ check; it
+ * pairs with the fence in wait() so that one side always sees the other.
+ */
+void LogRing::notify()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (doorbell_ != nullptr)
+    {
+        doorbell_->ring();
+    }
+    else if (sleeping_.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lk(waitMtx_);
+        waitCv_.notify_one();
+    }
+}
+
+/**
+ * @brief Wake the consumer unconditionally, for example on shutdown.
+ */
+void LogRing::notifyAll()
+{
+    if (doorbell_ != nullptr)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        doorbell_->ring();
+        return;
+    }
+    std::lock_guard<std::mutex> lk(waitMtx_);
+    waitCv_.notify_all();
+}
+
+/**
+ * @brief Park the consumer until an entry arrives, stop is set, or the
+ * timeout elapses.
+ *
+ * @param timeout Maximum time to wait.
+ * @param stop    Flag that ends the wait early when set.
+ * @param ready   Extra wake condition, such as work in other queues
+ * whose producers call notify() on this ring; may be empty.
+ */
+void LogRing::wait(std::chrono::milliseconds timeout, const std::atomic<bool> &stop,
+                   const std::function<bool()> &ready)
+{
+    sleeping_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lk(waitMtx_);
+        waitCv_.wait_for(lk, timeout, [&]
+                         { return stop.load(std::memory_order_acquire) || !empty() || (ready && ready()); });
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Name a thread after a prefix and its index.
+ *
+ * Linux keeps 15 bytes of a name, so the prefix is shortened rather than
+ * the index.
+ *
+ * @param prefix Name shared by a group of threads.
+ * @param index  Position of the thread in its group.
+ * @return Name to pass to pthread_setname_np().
+ */
+static std::string indexedThreadName(const std::string &prefix, size_t index)
+{
+    const std::string suffix = "-" + std::to_string(index);
+    return prefix.substr(0, 15 - std::min<size_t>(suffix.size(), 15)) + suffix;
+}
+
+/**
+ * @brief Announce that the consumer is about to park.
+ *
+ * The fence pairs with the one producers issue before ring(), so either
+ * the consumer's next check sees their work or they see it armed.
+ *
+ * @return Ring count to hand to park().
+ */
+uint32_t LogDoorbell::arm()
+{
+    waiters_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return rings_.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Sleep until the bell rings after arm() or the timeout elapses.
+ *
+ * @param armed   Value returned by arm().
+ * @param timeout Longest sleep; nanoseconds::max() waits without a limit.
+ */
+void LogDoorbell::park(uint32_t armed, std::chrono::nanoseconds timeout)
+{
+    timespec limit{};
+    const timespec *bound = nullptr;
+    if (timeout != std::chrono::nanoseconds::max())
+    {
+        limit.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+        limit.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+        bound = &limit;
+    }
+    // The kernel compares the word again, so a ring after arm() is never lost
+    syscall(SYS_futex, reinterpret_cast<uint32_t *>(&rings_), FUTEX_WAIT_PRIVATE, armed, bound, nullptr, 0);
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Withdraw arm() when work turned up before parking.
+ */
+void LogDoorbell::disarm()
+{
+    waiters_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Wake the consumer if it is armed or parked.
+ *
+ * Costs a single atomic load when the consumer is running.
+ */
+void LogDoorbell::ring()
+{
+    if (waiters_.load(std::memory_order_relaxed) != 0)
+    {
+        rings_.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&rings_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+    }
+}
+
+namespace
+{
+    thread_local const LogExecutor *runningExecutor = nullptr; // Executor owning the calling thread
+}
+
+/**
+ * @brief Start the executor's threads.
+ *
+ * @param threads Number of threads, at least 1.
+ * @param name    Thread name prefix; each thread adds its index.
+ * @throws std::invalid_argument if threads is 0.
+ */
+LogExecutor::LogExecutor(size_t threads, const std::string &name)
+{
+    if (threads == 0)
+    {
+        throw std::invalid_argument("LogExecutor needs at least one thread");
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        lanes_.push_back(std::make_unique<Lane>());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        lanes_[i]->thread = std::thread(&LogExecutor::laneLoop, this, std::ref(*lanes_[i]), i, name);
+    }
+}
+
+/**
+ * @brief Stop and join the threads.
+ *
+ * Loggers hold a reference to their executor, so none is attached by
+ * the time it is destroyed.
+ */
+LogExecutor::~LogExecutor()
+{
+    stop_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    for (const auto &lane : lanes_)
+    {
+        lane->bell.ring();
+    }
+    for (const auto &lane : lanes_)
+    {
+        lane->thread.join();
+    }
+}
+
+/**
+ * @brief Check whether the caller is one of this executor's threads.
+ *
+ * @return True on an executor thread.
+ */
+bool LogExecutor::onExecutorThread() const
+{
+    return runningExecutor == this;
+}
+
+/**
+ * @brief Hand a task to the thread serving the fewest tasks.
+ *
+ * The task runs until run() reports that it has finished.
+ *
+ * @param task Task to serve; must outlive its run.
+ * @return Bell of the thread now serving the task.
+ */
+LogDoorbell &LogExecutor::add(Task &task)
+{
+    Lane *lane;
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        lane = std::min_element(lanes_.begin(), lanes_.end(), [](const auto &a, const auto &b)
+                                { return a->tasks.size() < b->tasks.size(); })
+                   ->get();
+        lane->tasks.push_back(&task);
+        lane->version.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    lane->bell.ring();
+    return lane->bell;
+}
+
+/**
+ * @brief Block until a task has finished and no thread refers to it.
+ *
+ * @param task Task passed to add().
+ */
+void LogExecutor::wait(Task &task)
+{
+    std::unique_lock<std::mutex> lk(mtx_);
+    finished_.wait(lk, [&]
+                   { return std::none_of(lanes_.begin(), lanes_.end(), [&](const auto &lane)
+                                         { return std::find(lane->tasks.begin(), lane->tasks.end(), &task) !=
+                                                  lane->tasks.end(); }); });
+}
+
+/**
+ * @brief Serve a lane's tasks until the executor stops.
+ *
+ * Every pass runs each task once, so a busy logger cannot starve the
+ * others on its thread. The thread parks on its bell until the earliest
+ * time a task asked to be run again.
+ *
+ * @param lane  Lane to serve.
+ * @param index Position of the lane, used in the thread name.
+ * @param name  Thread name prefix.
+ */
+void LogExecutor::laneLoop(Lane &lane, size_t index, std::string name)
+{
+    runningExecutor = this;
+    if (!name.empty())
+    {
+        pthread_setname_np(pthread_self(), indexedThreadName(name, index).c_str());
+    }
+
+    std::vector<Task *> tasks; // Copy of lane.tasks, refreshed when its version moves
+    uint64_t seen = 0;
+    while (!stop_.load(std::memory_order_relaxed))
+    {
+        if (lane.version.load(std::memory_order_relaxed) != seen)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            tasks = lane.tasks;
+            seen = lane.version.load(std::memory_order_relaxed);
+        }
+
+        std::chrono::nanoseconds wait = std::chrono::nanoseconds::max();
+        bool retired = false;
+        for (Task *task : tasks)
+        {
+            const std::chrono::nanoseconds next = task->run();
+            if (next.count() < 0)
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                lane.tasks.erase(std::find(lane.tasks.begin(), lane.tasks.end(), task));
+                lane.version.fetch_add(1, std::memory_order_relaxed);
+                retired = true;
+            }
+            else
+            {
+                wait = std::min(wait, next);
+            }
+        }
+        if (retired)
+        {
+            finished_.notify_all();
+            continue;
+        }
+        if (wait.count() == 0)
+        {
+            continue;
+        }
+
+        // Park unless something arrived since the pass
+        const uint32_t armed = lane.bell.arm();
+        if (stop_.load(std::memory_order_relaxed) || lane.version.load(std::memory_order_relaxed) != seen ||
+            std::any_of(tasks.begin(), tasks.end(), [](Task *task) { return task->ready(); }))
+        {
+            lane.bell.disarm();
+            continue;
+        }
+        lane.bell.park(armed, wait);
+    }
+}
+
+/**
+ * @brief Create a limiter.
+ *
+ * @param perSecond Sustained messages allowed per second.
+ * @param burst     Messages allowed at once after a quiet period.
+ * @throws std::invalid_argument if perSecond is not positive or burst is 0.
+ */
+LogRateLimit::LogRateLimit(double perSecond, size_t burst)
+    : interval_(perSecond > 0 ? std::max<int64_t>(static_cast<int64_t>(1e9 / perSecond), 1) : 0),
+      tolerance_(interval_ * static_cast<int64_t>(burst > 0 ? burst - 1 : 0))
+{
+    if (!(perSecond > 0))
+    {
+        throw std::invalid_argument("LogRateLimit: perSecond must be positive");
+    }
+    if (burst == 0)
+    {
+        throw std::invalid_argument("LogRateLimit: burst must be at least 1");
+    }
+}
+
+/**
+ * @brief Take a token if one is available.
+ *
+ * due_ is when the bucket would be empty again if nothing more arrived.
+ * A message is allowed unless that lies more than the burst allowance in
+ * the future; allowing it pushes due_ back by one interval.
+ *
+ * @return True if the message may be logged; false counts it as suppressed.
+ */
+bool LogRateLimit::allow()
+{
+    const int64_t now = LogRateLimit::now();
+    int64_t due = due_.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        const int64_t start = std::max(due, now);
+        if (start - now > tolerance_)
+        {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (due_.compare_exchange_weak(due, start + interval_, std::memory_order_relaxed))
+        {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Return and reset the number of messages refused since the last call.
+ *
+ * @return Messages suppressed.
+ */
+uint64_t LogRateLimit::takeSuppressed()
+{
+    if (suppressed_.load(std::memory_order_relaxed) == 0)
+    {
+        return 0;
+    }
+    return suppressed_.exchange(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Check without taking a token whether allow() would succeed now.
+ *
+ * @return True once the limit window after the last refusal has passed.
+ */
+bool LogRateLimit::wouldAllow() const
+{
+    const int64_t now = LogRateLimit::now();
+    return std::max(due_.load(std::memory_order_relaxed), now) - now <= tolerance_;
+}
+
+/**
+ * @brief Read the coarse monotonic clock.
+ *
+ * The coarse clock is enough for limits of a few hundred per second and
+ * costs no system call.
+ *
+ * @return Current time in nanoseconds.
+ */
+int64_t LogRateLimit::now()
+{
+    clockid_t id = CLOCK_MONOTONIC;
+#ifdef CLOCK_MONOTONIC_COARSE
+    id = CLOCK_MONOTONIC_COARSE;
+#endif
+    timespec ts{};
+    clock_gettime(id, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * @brief Hand any refusals still held to the logger watching this limiter.
+ *
+ * A limiter may outlive its logger, for example as a function static;
+ * the logger clears watcher_ when it goes first.
+ */
+LogRateLimit::~LogRateLimit()
+{
+    if (LCBLog *logger = watcher_.load(std::memory_order_acquire))
+    {
+        logger->unwatchLimit(*this);
+    }
+}
+
+/**
+ * @brief Constructs the logger and starts asynchronous worker threads.
+ *
+ * Initializes the log level and binds the output streams.
+ * Then spawns two worker threads—one for standard output and one for error output—
+ * each processing its own message queue.
+ *
+ * @param outStream Reference to the std::ostream for INFO/WARN/DEBUG logs.
+ * @param errStream Reference to the std::ostream for ERROR/FATAL logs.
+ * @param config    Queue, batching, and overflow settings.
+ * @throws std::invalid_argument if config fails validation.
+ */
+LCBLog::LCBLog(std::ostream &outStream, std::ostream &errStream,
+               const LCBLogConfig &config)
+    : LCBLog(std::make_shared<StreamSink>(outStream),
+             // One sink for a shared stream keeps the workers from interleaving
+             &errStream == &outStream ? nullptr : std::make_shared<StreamSink>(errStream),
+             config)
+{
+}
+
+/**
+ * @brief Construct a logger that writes to sinks.
+ *
+ * @param outSink Sink for informational and debug messages.
+ * @param errSink Sink for error and fatal messages, or nullptr to share
+ * outSink.
+ * @param config  Queue, batching, and overflow settings.
+ * @throws std::invalid_argument if config fails validation or outSink
+ * is null.
+ */
+LCBLog::LCBLog(std::shared_ptr<LogSink> outSink, std::shared_ptr<LogSink> errSink,
+               const LCBLogConfig &config)
+    : LCBLog({LogRoute{outSink, DEBUG, WARN},
+              LogRoute{errSink ? errSink : outSink, ERROR, FATAL}},
+             config)
+{
+}
+
+/**
+ * @brief Back off for one iteration of a polling loop.
+ *
+ * Issues the CPU's spin-wait hint, and every 64th call yields so that a
+ * producer sharing the core can run.
+ *
+ * @param spins Iterations polled so far.
+ */
+static void cpuRelax(unsigned spins)
+{
+    if (spins % 64 == 0)
+    {
+        std::this_thread::yield();
+        return;
+    }
+#if defined(__SSE2__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/**
+ * @struct LCBLog::Drain
+ * @brief State of one route's worker between wakeups.
+ *
+ * Collects up to batchSize_ messages, then hands the batch to the sink
+ * when it is full, the flush interval has elapsed, or it holds an ERROR
+ * or FATAL entry. Packed entries are formatted here, off the logging
+ * thread, or encoded as binary records when binary output is enabled.
+ * Once the queue drains after overflow, it adds a WARN line with the
+ * number of messages dropped. Per-thread queues are merged on their
+ * entries' enqueue times. Runs on the route's own worker thread, or as a
+ * task of a LogExecutor shared with other loggers.
+ */
+struct LCBLog::Drain : LogExecutor::Task
+{
+    // Rings drained by this worker: the route queue, then thread queues
+    struct Source
+    {
+        LogRing *ring;
+        std::shared_ptr<ThreadQueue> owner; // Null for the route queue
+        LogEntry head;                      // Entry popped ahead for merging
+        bool staged;                        // head holds an entry
+        uint64_t watermark;                 // Pushes a pending flush() waits for
+    };
+
+    LCBLog &owner;
+    Route &route;
+    LogRing &queue;
+    LogSink &sink;
+    std::vector<LogEntry> batch; // Entries keep their buffers so slot strings circulate
+    std::string scratch;         // Output bytes for the entry being finished
+    size_t pending = 0;
+    bool urgent = false;
+    bool unflushed = false;      // Sink holds bytes written since its last flush
+    bool headerWritten = false;  // Binary output opens with a header record
+    size_t formatsWritten = 0;   // Format IDs already defined in binary output
+    int64_t spinBudget;          // Current idle poll, in ns
+    std::chrono::steady_clock::time_point lastFlush = std::chrono::steady_clock::now();
+
+    std::vector<Source> sources;
+    uint64_t threadsSeen = 0;
+    uint64_t flushTicket = 0;  // Latest flush() request seen
+    bool flushOpen = false;    // flushTicket is not answered yet
+    const std::function<bool()> wake = [this] { return ready(); };
+
+    // Repeat folding: the last message kept, without its timestamp
+    std::string lastKey;
+    LogLevel lastLevel = INFO;
+    bool haveLast = false;
+    uint64_t repeats = 0;
+    std::chrono::steady_clock::time_point repeatSince = std::chrono::steady_clock::now();
+
+    Drain(LCBLog &logger, Route &served)
+        : owner(logger), route(served), queue(served.queue), sink(*served.spec.sink),
+          spinBudget(logger.workerSpinNs_.load(std::memory_order_relaxed))
+    {
+        sources.push_back(Source{&queue, nullptr, LogEntry{}, false, 0});
+    }
+
+    // Turn an entry into the exact bytes the sink should write
+    void finish(LogEntry &e)
+    {
+        if (owner.hot().binary)
+        {
+            scratch.clear();
+            if (!headerWritten)
+            {
+                LogPack::putU32(scratch, static_cast<uint32_t>(1 + LogPack::magic.size() + 1));
+                scratch.push_back(LogPack::RecordHeader);
+                scratch.append(LogPack::magic);
+                scratch.push_back(static_cast<char>(LogPack::version));
+                headerWritten = true;
+            }
+            appendBinaryRecord(scratch, e.level, e.text(), e.packed, formatsWritten);
+        }
+        else if (e.packed)
+        {
+            scratch.clear();
+            if (!formatPacked(scratch, e.level, e.text()))
+            {
+                scratch.assign(owner.format(ERROR, "Malformed packed log entry"));
+            }
+        }
+        else
+        {
+            return;
+        }
+        e.msg.swap(scratch);
+        e.shared.reset();
+        e.packed = false;
+    }
+
+    // Pick up thread queues registered since the last call
+    void syncSources()
+    {
+        const uint64_t added = route.threadsAdded.load(std::memory_order_acquire);
+        if (added == threadsSeen)
+        {
+            return;
+        }
+        threadsSeen = added;
+        std::lock_guard<std::mutex> lk(route.threadsMtx);
+        for (const auto &q : route.threads)
+        {
+            if (std::none_of(sources.begin(), sources.end(), [&](const Source &s) { return s.owner == q; }))
+            {
+                sources.push_back(Source{&q->ring, q, LogEntry{}, false, 0});
+            }
+        }
+    }
+
+    bool idle() const
+    {
+        for (const Source &s : sources)
+        {
+            if (s.staged || !s.ring->empty())
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ready() override
+    {
+        return route.threadsAdded.load(std::memory_order_relaxed) != threadsSeen ||
+               route.flushRequested.load(std::memory_order_relaxed) != flushTicket || !idle() ||
+               owner.done_.load(std::memory_order_acquire);
+    }
+
+    // Everything pushed before the watermark has left the queues
+    bool reachedWatermark() const
+    {
+        return std::all_of(sources.begin(), sources.end(), [](const Source &s)
+                           { return s.ring->poppedTotal() - (s.staged ? 1 : 0) >= s.watermark; });
+    }
+
+    // Shutdown drains only until the destructor's deadline
+    bool overdue() const
+    {
+        const int64_t deadline = owner.shutdownDeadline_.load(std::memory_order_relaxed);
+        return deadline != 0 && std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch())
+                                        .count() >= deadline;
+    }
+
+    // Release flush() callers up to the given ticket
+    void answerFlush(uint64_t ticket)
+    {
+        {
+            std::lock_guard<std::mutex> lk(route.flushMtx);
+            route.flushDone.store(ticket, std::memory_order_release);
+        }
+        route.flushCv.notify_all();
+    }
+
+    // Pop the next entry; thread queues are merged on enqueue time
+    bool pop(LogEntry &e)
+    {
+        if (sources.size() == 1 && !sources.front().staged)
+        {
+            return queue.tryPop(e);
+        }
+        Source *earliest = nullptr;
+        for (Source &s : sources)
+        {
+            if (!s.staged)
+            {
+                s.staged = s.ring->tryPop(s.head);
+            }
+            if (s.staged && (earliest == nullptr || s.head.stamp < earliest->head.stamp))
+            {
+                earliest = &s;
+            }
+        }
+        if (earliest == nullptr)
+        {
+            return false;
+        }
+        std::swap(e, earliest->head);
+        earliest->staged = false;
+        return true;
+    }
+
+    // Collect overflow losses and retire drained queues of exited threads
+    uint64_t takeDropped()
+    {
+        uint64_t dropped = 0;
+        for (size_t i = 0; i < sources.size();)
+        {
+            Source &s = sources[i];
+            dropped += s.ring->takeDropped();
+            if (!s.owner || s.staged || !s.owner->exited.load(std::memory_order_acquire) || !s.ring->empty())
+            {
+                ++i;
+                continue;
+            }
+            {
+                std::lock_guard<std::mutex> lk(route.threadsMtx);
+                route.retiredDrops += s.ring->droppedTotal();
+                route.retiredPushed += s.ring->pushedTotal();
+                route.threads.erase(std::find(route.threads.begin(), route.threads.end(), s.owner));
+            }
+            sources.erase(sources.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+        return dropped;
+    }
+
+    LogEntry &nextSlot()
+    {
+        if (pending == batch.size())
+        {
+            // Slots get this buffer back in exchange for a reserved one
+            batch.emplace_back();
+            batch.back().msg.reserve(queue.slotReserve());
+        }
+        return batch[pending];
+    }
+
+    static std::string_view keyOf(const LogEntry &e)
+    {
+        std::string_view text = e.text();
+        if (e.packed)
+        {
+            LogStyle style;
+            LogPack::getHeader(text, style);
+            return text;
+        }
+        // Text lines start with the tag, or with a timestamp and then the tag
+        size_t tag = text.find('[');
+        return tag == std::string_view::npos ? text : text.substr(tag);
+    }
+
+    // Report how often the last message repeated
+    void addRepeated(LogLevel level)
+    {
+        LogEntry &e = nextSlot();
+        e.level = level;
+        e.shared.reset();
+        e.msg.clear();
+        LogPack::putHeader(e.msg, owner.currentStyle());
+        ::packLogArg(e.msg, "last message repeated");
+        ::packLogArg(e.msg, repeats);
+        ::packLogArg(e.msg, "times");
+        e.packed = true;
+        finish(e);
+        ++pending;
+        repeats = 0;
+    }
+
+    bool take()
+    {
+        LogEntry &e = nextSlot();
+        if (!pop(e))
+        {
+            return false;
+        }
+        if (owner.hot().collapse)
+        {
+            std::string_view key = keyOf(e);
+            if (haveLast && e.level == lastLevel && key == lastKey)
+            {
+                // Leave the slot for the next entry
+                if (repeats++ == 0)
+                {
+                    repeatSince = std::chrono::steady_clock::now();
+                }
+                e.shared.reset();
+                return true;
+            }
+            const LogLevel repeatedLevel = lastLevel;
+            lastKey.assign(key.data(), key.size());
+            lastLevel = e.level;
+            haveLast = true;
+            if (repeats > 0)
+            {
+                // The count goes before the new message; move it one slot on
+                const size_t at = pending++;
+                LogEntry &next = nextSlot();
+                std::swap(next, batch[at]);
+                pending = at;
+                addRepeated(repeatedLevel);
+            }
+        }
+        LogEntry &kept = batch[pending];
+        finish(kept);
+        urgent = urgent || kept.level >= ERROR;
+        ++pending;
+        return true;
+    }
+
+    void addDropped(uint64_t dropped)
+    {
+        LogEntry &e = nextSlot();
+        e.level = WARN;
+        e.shared.reset();
+        e.msg.clear();
+        LogPack::putHeader(e.msg, owner.currentStyle());
+        ::packLogArg(e.msg, dropped);
+        ::packLogArg(e.msg, "messages dropped");
+        e.packed = true;
+        finish(e);
+        ++pending;
+    }
+
+    void addWriteTime(std::chrono::steady_clock::time_point start)
+    {
+        auto spent = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        route.writeNs.fetch_add(spent.count(), std::memory_order_relaxed);
+    }
+
+    void flushBatch(std::chrono::steady_clock::time_point now)
+    {
+        if (pending > 0)
+        {
+            uint64_t bytes = 0;
+            for (size_t i = 0; i < pending; ++i)
+            {
+                bytes += batch[i].text().size();
+            }
+            auto start = std::chrono::steady_clock::now();
+            sink.write(LogEntrySpan{batch.data(), pending});
+            addWriteTime(start);
+            unflushed = true;
+            route.written.fetch_add(pending, std::memory_order_relaxed);
+            route.bytes.fetch_add(bytes, std::memory_order_relaxed);
+            route.batches.fetch_add(1, std::memory_order_relaxed);
+            // Release shared buffers now rather than when the slot is reused
+            for (size_t i = 0; i < pending; ++i)
+            {
+                batch[i].shared.reset();
+            }
+        }
+        // Let buffering sinks hold output only while more is on the way
+        if (unflushed && (urgent || idle()))
+        {
+            auto start = std::chrono::steady_clock::now();
+            sink.flush();
+            addWriteTime(start);
+            unflushed = false;
+        }
+        pending = 0;
+        urgent = false;
+        lastFlush = now;
+    }
+
+    // Continue until shutdown is signaled and queue is empty, or the shutdown deadline passes
+    bool running() const
+    {
+        return !owner.done_.load(std::memory_order_acquire) || (!idle() && !overdue());
+    }
+
+    // Longest wait before new data or a pending batch comes due
+    std::chrono::milliseconds timeout() const
+    {
+        const std::chrono::milliseconds flushInterval(owner.flushIntervalMs_.load(std::memory_order_relaxed));
+        if (pending == 0)
+        {
+            return flushInterval;
+        }
+        auto due = std::chrono::duration_cast<std::chrono::milliseconds>(
+            lastFlush + flushInterval - std::chrono::steady_clock::now());
+        return std::max(due, std::chrono::milliseconds(0));
+    }
+
+    // Wait on the route queue, polling first when configured
+    void park()
+    {
+        const std::chrono::milliseconds limit = timeout();
+
+        // Poll before parking while polls keep finding work; halve the
+        // poll each time it comes up empty and restore it once work
+        // arrives right after a park
+        const int64_t spinLimit = owner.workerSpinNs_.load(std::memory_order_relaxed);
+        bool found = false;
+        spinBudget = std::min(spinBudget, spinLimit);
+        if (spinBudget > 0)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const auto until = start + std::min<std::chrono::nanoseconds>(
+                                           std::chrono::nanoseconds(spinBudget), limit);
+            for (unsigned spins = 1;; ++spins)
+            {
+                found = ready();
+                if (found || std::chrono::steady_clock::now() >= until)
+                {
+                    break;
+                }
+                cpuRelax(spins);
+            }
+            spinBudget = found ? spinLimit : spinBudget / 2;
+        }
+        if (!found)
+        {
+            const auto parked = std::chrono::steady_clock::now();
+            queue.wait(limit, owner.done_, wake);
+            if (spinLimit > 0 && ready() && std::chrono::steady_clock::now() - parked < limit)
+            {
+                spinBudget = spinLimit;
+            }
+        }
+    }
+
+    // One pass over the queues after a wakeup
+    void step()
+    {
+        // Pick up any retuning from setConfig()
+        const size_t batchSize = owner.batchSize_.load(std::memory_order_relaxed);
+        const std::chrono::milliseconds flushInterval(owner.flushIntervalMs_.load(std::memory_order_relaxed));
+
+        // Track the deepest backlog
+        uint64_t depth = 0;
+        for (const Source &s : sources)
+        {
+            depth += s.ring->size() + (s.staged ? 1 : 0);
+        }
+        if (depth > route.highWater.load(std::memory_order_relaxed))
+        {
+            route.highWater.store(depth, std::memory_order_relaxed);
+        }
+
+        // Mark how far a new flush() request must wait
+        const uint64_t requested = route.flushRequested.load(std::memory_order_acquire);
+        if (requested != flushTicket)
+        {
+            flushTicket = requested;
+            syncSources();
+            for (Source &s : sources)
+            {
+                s.watermark = s.ring->pushedTotal();
+            }
+            flushOpen = true;
+        }
+
+        // Collect up to batchSize messages
+        while (pending < batchSize && take())
+        {
+        }
+
+        // Report a run of repeats once it has lasted a flush interval
+        if (repeats > 0 && std::chrono::steady_clock::now() - repeatSince >= flushInterval)
+        {
+            addRepeated(lastLevel);
+        }
+
+        // Report overflow losses once the backlog has cleared
+        if (idle())
+        {
+            uint64_t dropped = takeDropped();
+            if (dropped > 0)
+            {
+                addDropped(dropped);
+            }
+        }
+
+        // Report rate-limit refusals no later message carried
+        if (&route == owner.routes_.front().get())
+        {
+            owner.reportSuppressed(false);
+        }
+
+        // Write and flush the sink as soon as a pending flush() is covered
+        auto now = std::chrono::steady_clock::now();
+        if (flushOpen && reachedWatermark())
+        {
+            if (repeats > 0)
+            {
+                addRepeated(lastLevel);
+            }
+            urgent = true;
+            flushBatch(now);
+            flushOpen = false;
+            answerFlush(flushTicket);
+        }
+
+        // Write if the batch is full, urgent, or the flush interval has elapsed
+        if (pending >= batchSize || urgent || now - lastFlush >= flushInterval)
+        {
+            flushBatch(now);
+        }
+    }
+
+    // Drain any remaining messages after shutdown
+    void close()
+    {
+        syncSources();
+        const size_t batchSize = owner.batchSize_.load(std::memory_order_relaxed);
+        bool expired = false;
+        for (;;)
+        {
+            expired = overdue();
+            if (expired || !take())
+            {
+                break;
+            }
+            if (pending >= batchSize)
+            {
+                flushBatch(std::chrono::steady_clock::now());
+            }
+        }
+
+        // Past the deadline, count what is left as dropped instead of writing it
+        if (expired)
+        {
+            LogEntry discarded;
+            for (Source &s : sources)
+            {
+                if (s.staged)
+                {
+                    s.staged = false;
+                    s.ring->recordDrop();
+                }
+                while (s.ring->tryPop(discarded))
+                {
+                    s.ring->recordDrop();
+                }
+            }
+        }
+        if (repeats > 0)
+        {
+            addRepeated(lastLevel);
+        }
+        uint64_t dropped = takeDropped();
+        if (dropped > 0)
+        {
+            addDropped(dropped);
+        }
+        flushBatch(std::chrono::steady_clock::now());
+        if (unflushed)
+        {
+            auto start = std::chrono::steady_clock::now();
+            sink.flush();
+            addWriteTime(start);
+        }
+        answerFlush(route.flushRequested.load(std::memory_order_acquire));
+    }
+
+    // Executor entry point: one pass, then the time until the next is due
+    std::chrono::nanoseconds run() override
+    {
+        if (!running())
+        {
+            close();
+            return std::chrono::nanoseconds(-1);
+        }
+        syncSources();
+        step();
+        return idle() ? std::chrono::nanoseconds(timeout()) : std::chrono::nanoseconds(0);
+    }
+};
+
+/**
+ * @brief Create a route with an empty queue.
+ *
+ * @param r        Sink and level range.
+ * @param capacity Queue size in entries.
+ * @param reserve  Bytes preallocated per queue slot.
+ */
+LCBLog::Route::Route(const LogRoute &r, size_t capacity, size_t reserve) : spec(r), queue(capacity, reserve)
+{
+}
+
+LCBLog::Route::~Route() = default;
+
+/**
+ * @brief Hand out a process-wide unique logger ID.
+ *
+ * Unlike addresses, IDs are never reused, so thread-local queues of a
+ * destroyed logger cannot be mistaken for those of a new one.
+ *
+ * @return An ID no other logger has had.
+ */
+static uint64_t nextInstanceId()
+{
+    static std::atomic<uint64_t> counter{0};
+    return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+/**
+ * @brief Construct a logger that fans messages out through a routing table.
+ *
+ * Builds one queue and worker per route and indexes the routes by level
+ * so that log() finds its targets without scanning the table.
+ *
+ * @param routes Sinks and the levels each one receives.
+ * @param config Queue, batching, and overflow settings; each route
+ * gets a queue of config.queueCapacity.
+ * @throws std::invalid_argument if config fails validation, routes is
+ * empty, a sink is null, or a route's levels are reversed.
+ */
+LCBLog::LCBLog(const std::vector<LogRoute> &routes, const LCBLogConfig &config)
+    : config_((config.validate(), config)) // Reject bad settings before sizing queues
+      ,
+      instanceId_(nextInstanceId()), executor_(config.executor)
+{
+    if (routes.empty())
+    {
+        throw std::invalid_argument("LCBLog needs at least one route");
+    }
+    for (const LogRoute &route : routes)
+    {
+        if (!route.sink)
+        {
+            throw std::invalid_argument("LCBLog route has no sink");
+        }
+        if (route.minLevel > route.maxLevel)
+        {
+            throw std::invalid_argument("LCBLog route minLevel is above maxLevel");
+        }
+        routes_.push_back(std::make_unique<Route>(route, config_.queueCapacity, config_.slotReserve));
+    }
+
+    for (const auto &route : routes_)
+    {
+        for (int level = route->spec.minLevel; level <= route->spec.maxLevel; ++level)
+        {
+            if (level >= DEBUG && level <= FATAL)
+            {
+                routesByLevel_[level].push_back(route.get());
+            }
+        }
+    }
+
+    // Messages for several routes share one buffer; recycle those buffers
+    if (std::any_of(std::begin(routesByLevel_), std::end(routesByLevel_),
+                    [](const std::vector<Route *> &targets) { return targets.size() > 1; }))
+    {
+        sharedPoolSize_ = 2 * (config_.queueCapacity + config_.batchSize);
+        sharedPool_.reset(new SharedSlot[sharedPoolSize_]);
+    }
+    applyConfig();
+
+    // Launch one worker per route to drain its queue into its sink, or
+    // hand the routes to the shared executor
+    for (const auto &route : routes_)
+    {
+        route->drain = std::make_unique<Drain>(*this, *route);
+        if (executor_)
+        {
+            route->queue.setDoorbell(&executor_->add(*route->drain));
+        }
+        else
+        {
+            route->worker = std::thread(&LCBLog::workerLoop, this, std::ref(*route));
+        }
+    }
+    startReporter();
+}
+
+/**
+ * @brief Cleans up the logger, ensuring remaining entries are processed.
+ *
+ * Signals worker threads to stop, wakes them if they are waiting,
+ * and joins them so that all queued log messages are flushed before
+ * destruction completes. A positive config.shutdownTimeout bounds the
+ * drain: once it expires the workers discard what is left, counting it
+ * as dropped. A sink blocked inside write() is still waited for.
+ */
+LCBLog::~LCBLog()
+{
+    // A crash from here on must not read a logger being torn down
+    registerCrashDump(false);
+
+    // Start the drain limit before anything else can take time
+    if (config_.shutdownTimeout.count() > 0)
+    {
+        auto deadline = std::chrono::steady_clock::now() + config_.shutdownTimeout;
+        shutdownDeadline_.store(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count(),
+            std::memory_order_relaxed);
+    }
+
+    // Stop the reporter while the workers can still take its last record
+    {
+        std::lock_guard<std::mutex> lk(reporterMtx_);
+        reporterStop_ = true;
+    }
+    reporterCv_.notify_all();
+    if (reporter_.joinable())
+    {
+        reporter_.join();
+    }
+
+    // Report refusals still waiting for their limit window to pass
+    reportSuppressed(true);
+
+    // Tell workers to exit their processing loops
+    done_.store(true, std::memory_order_release);
+
+    // Wake up any workers that are parked on their queues
+    for (const auto &route : routes_)
+    {
+        route->queue.notifyAll();
+    }
+
+    // Wait for each worker to finish draining its queue
+    for (const auto &route : routes_)
+    {
+        if (route->worker.joinable())
+        {
+            route->worker.join();
+        }
+        else if (executor_)
+        {
+            executor_->wait(*route->drain);
+        }
+    }
+
+    // Let threads that outlive the logger release its queues
+    for (const auto &route : routes_)
+    {
+        std::lock_guard<std::mutex> lk(route->threadsMtx);
+        for (const auto &q : route->threads)
+        {
+            q->detached.store(true, std::memory_order_release);
+        }
+    }
+
+    // Limiters that refused during shutdown must not point at this logger
+    std::lock_guard<std::mutex> lk(limitsMtx_);
+    for (const WatchedLimit &w : limits_)
+    {
+        LCBLog *self = this;
+        w.limit->watcher_.compare_exchange_strong(self, nullptr);
+    }
+}
+
+/**
+ * @brief Returns the singleton logger instance.
+ *
+ * Constructs the LCBLog instance on first invocation using the given
+ * streams and settings. Subsequent calls ignore their parameters and
+ * return the same instance.
+ *
+ * @param out    The output stream for standard logs
+ * @param err    The output stream for error logs
+ * @param config Queue, batching, and overflow settings
+ * @return Reference to the global LCBLog singleton instance
+ */
+LCBLog &getLogger(std::ostream &out, std::ostream &err, const LCBLogConfig &config)
+{
+    // This static is constructed exactly once, on the first call.
+    static LCBLog instance{out, err, config};
+    return instance;
+}
+
+/**
+ * @brief Returns the singleton logger instance built with given settings.
+ *
+ * @param config Queue, batching, and overflow settings
+ * @return Reference to the global LCBLog singleton instance
+ */
+LCBLog &getLogger(const LCBLogConfig &config)
+{
+    return getLogger(std::cout, std::cerr, config);
+}
+
+/**
+ * @brief Returns the singleton logger instance.
+ *
+ * Constructs the LCBLog instance on first invocation using default
+ * output and error streams. Subsequent calls ignore their parameters
+ * and return the same instance.
+ *
+ * @return Reference to the global LCBLog singleton instance
+ */
+LCBLog& getLogger() {
+    return getLogger(std::cout, std::cerr);
+}
+
+/**
+ * @brief Queue a formatted message, applying the overflow policy.
+ *
+ * The fast path is a single push into the ring. When the ring is full,
+ * or entries are still waiting in the overflow list, the configured
+ * policy decides whether to evict, discard, wait, or spill. Every lost
+ * message is counted on the queue. The route's worker parks on the
+ * route queue, so that is the ring notified even when the message goes
+ * to a thread queue.
+ *
+ * @param route  Route the message belongs to; its worker is woken.
+ * @param queue  Ring that receives the message: the route queue or a
+ * thread queue of that route.
+ * @param policy Overflow policy loaded by the caller.
+ * @param dest   Destination recorded with the entry.
+ * @param level  Severity recorded with the entry.
+ * @param text   Formatted message text or packed arguments.
+ * @param packed True if text is a LogPack encoding.
+ * @param shared Buffer holding text for several queues, or nullptr.
+ * @param stamp  Enqueue time recorded with the entry.
+ */
+void LCBLog::enqueue(Route &route, LogRing &queue, OverflowPolicy policy, LogEntry::Destination dest, LogLevel level,
+                     std::string_view text, bool packed, const std::shared_ptr<const std::string> &shared,
+                     int64_t stamp)
+{
+    if (!queue.spilling() && queue.tryPush(dest, level, text, packed, shared, stamp))
+    {
+        route.queue.notify();
+        return;
+    }
+
+    switch (policy)
+    {
+    case DropOldest:
+        // Drop oldest if we're at capacity
+        while (!queue.tryPush(dest, level, text, packed, shared, stamp))
+        {
+            if (queue.discardOldest())
+            {
+                queue.recordDrop();
+            }
+        }
+        break;
+
+    case DropNewest:
+        queue.recordDrop();
+        return;
+
+    case BlockWithTimeout:
+    {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(blockTimeoutMs_.load(std::memory_order_relaxed));
+        route.queue.notify();
+        while (!queue.tryPush(dest, level, text, packed, shared, stamp))
+        {
+            if (!queue.waitForSpace(deadline))
+            {
+                queue.recordDrop();
+                return;
+            }
+        }
+        break;
+    }
+
+    case GrowToCap:
+        if (!queue.trySpill(dest, level, text, overflowByteCap_.load(std::memory_order_relaxed), packed, shared,
+                            stamp))
+        {
+            queue.recordDrop();
+            return;
+        }
+        break;
+    }
+    route.queue.notify();
+}
+
+/**
+ * @brief Queue a formatted message on every route that takes its level.
+ *
+ * A message for a single route is copied into that queue's slot as
+ * before. When several routes match, the text is copied once into a
+ * reference-counted buffer and each queue holds a reference to it.
+ * With per-thread queues enabled, each message goes to the calling
+ * thread's queue for the route, stamped with the monotonic time the
+ * worker merges on.
+ *
+ * @param settings Hot settings loaded by the caller.
+ * @param level    Severity of the message.
+ * @param text     Formatted message text or packed arguments.
+ * @param packed   True if text is a LogPack encoding.
+ */
+void LCBLog::dispatch(const HotConfig &settings, LogLevel level, std::string_view text, bool packed)
+{
+    const auto dest = (level >= ERROR ? LogEntry::Err : LogEntry::Out);
+    const std::vector<Route *> &targets = routesFor(level);
+    const OverflowPolicy policy = settings.overflowPolicy;
+    const bool perThread = settings.perThread;
+    const int64_t stamp = perThread ? std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count()
+                                    : 0;
+    if (targets.size() == 1)
+    {
+        Route &route = *targets.front();
+        enqueue(route, perThread ? threadQueue(route) : route.queue, policy, dest, level, text, packed, nullptr,
+                stamp);
+        return;
+    }
+
+    auto shared = sharedText(text);
+    for (Route *route : targets)
+    {
+        enqueue(*route, perThread ? threadQueue(*route) : route->queue, policy, dest, level, *shared, packed,
+                shared, stamp);
+    }
+}
+
+/**
+ * @brief Copy text into a recycled shared buffer.
+ *
+ * Slots are tried round-robin from a shared cursor. Queues release
+ * buffers in roughly the order they were filled, so the slot under the
+ * cursor is normally free again by the time the cursor wraps. A slot is
+ * free when the pool holds the only reference; the acquire fence pairs
+ * with the release of the last queue's reference, so its reads of the
+ * old text finish before the buffer is overwritten.
+ *
+ * @param text Message content.
+ * @return Buffer holding text; freshly allocated if no pooled one is
+ * free within a few probes.
+ */
+std::shared_ptr<const std::string> LCBLog::sharedText(std::string_view text)
+{
+    constexpr size_t probes = 4;
+    const size_t start = sharedCursor_.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < probes && i < sharedPoolSize_; ++i)
+    {
+        SharedSlot &slot = sharedPool_[(start + i) % sharedPoolSize_];
+        if (slot.busy.exchange(true, std::memory_order_acquire))
+        {
+            continue;
+        }
+        if (!slot.buffer)
+        {
+            slot.buffer = std::make_shared<std::string>();
+        }
+        else if (slot.buffer.use_count() != 1)
+        {
+            slot.busy.store(false, std::memory_order_release);
+            continue;
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        slot.buffer->assign(text.data(), text.size());
+        std::shared_ptr<const std::string> out = slot.buffer;
+        slot.busy.store(false, std::memory_order_release);
+        return out;
+    }
+    return std::make_shared<const std::string>(text);
+}
+
+/**
+ * @brief Return the calling thread's queue for a route, creating and
+ * registering it on first use.
+ *
+ * The thread keeps its queues in thread-local storage and marks them
+ * exited when it ends; the route keeps its own reference, so the worker
+ * drains whatever the thread left behind before retiring the queue.
+ * Queues of destroyed loggers are forgotten the next time a queue is
+ * added.
+ *
+ * @param route Route the queue feeds.
+ * @return Queue with the calling thread as its only producer.
+ */
+LogRing &LCBLog::threadQueue(Route &route)
+{
+    struct Local
+    {
+        std::vector<std::shared_ptr<ThreadQueue>> queues;
+
+        ~Local()
+        {
+            // Hand the remaining entries to the workers
+            for (const auto &q : queues)
+            {
+                q->exited.store(true, std::memory_order_release);
+            }
+        }
+    };
+    static thread_local Local local;
+
+    for (const auto &q : local.queues)
+    {
+        if (q->route == &route && q->owner == instanceId_)
+        {
+            return q->ring;
+        }
+    }
+
+    local.queues.erase(std::remove_if(local.queues.begin(), local.queues.end(),
+                                      [](const std::shared_ptr<ThreadQueue> &q)
+                                      { return q->detached.load(std::memory_order_acquire); }),
+                       local.queues.end());
+
+    size_t capacity;
+    {
+        std::lock_guard<std::mutex> lk(logMutex);
+        capacity = config_.threadQueueCapacity;
+    }
+    auto q = std::make_shared<ThreadQueue>(capacity, route.queue.slotReserve(), instanceId_, &route);
+    {
+        std::lock_guard<std::mutex> lk(route.threadsMtx);
+        route.threads.push_back(q);
+    }
+    route.threadsAdded.fetch_add(1, std::memory_order_release);
+    local.queues.push_back(q);
+    return q->ring;
+}
+
+/**
+ * @brief Apply the thread settings to the calling worker.
+ *
+ * Names the thread, pins it to config.workerCpus, and sets its nice
+ * value and real-time priority. Settings the host refuses, usually for
+ * lack of privileges, are reported once as a WARN line and the worker
+ * runs on with the defaults.
+ *
+ * @param index Position of the worker's route, used in its name.
+ */
+void LCBLog::tuneWorker(size_t index)
+{
+    LCBLogConfig settings;
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        settings = config_;
+    }
+
+    std::string refused;
+    auto refuse = [&](const char *what, int err)
+    {
+        refused.append(refused.empty() ? "" : ", ").append(what).append(": ").append(std::strerror(err));
+    };
+
+    if (!settings.threadName.empty())
+    {
+        const int err = pthread_setname_np(pthread_self(), indexedThreadName(settings.threadName, index).c_str());
+        if (err != 0)
+        {
+            refuse("name", err);
+        }
+    }
+    if (!settings.workerCpus.empty())
+    {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu : settings.workerCpus)
+        {
+            CPU_SET(cpu, &cpus);
+        }
+        const int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (err != 0)
+        {
+            refuse("affinity", err);
+        }
+    }
+    if (settings.workerNice != 0)
+    {
+        // On Linux the nice value belongs to the thread named by its ID
+        const id_t tid = static_cast<id_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, tid, settings.workerNice) != 0)
+        {
+            refuse("nice", errno);
+        }
+    }
+    if (settings.workerRealtimePriority > 0)
+    {
+        sched_param param{};
+        param.sched_priority = settings.workerRealtimePriority;
+        const int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0)
+        {
+            refuse("real-time priority", err);
+        }
+    }
+
+    if (!refused.empty())
+    {
+        logS(WARN, "Worker", index, "kept default thread settings for", refused);
+    }
+}
+
+/**
+ * @brief Processes queued log entries in batches on a background thread.
+ *
+ * Applies the worker thread settings, then alternates between waiting
+ * for new entries or a timeout and one pass of the route's Drain, and
+ * drains what is left once the logger shuts down.
+ *
+ * @param route Route whose queues and sink the loop serves.
+ */
+void LCBLog::workerLoop(Route &route)
+{
+    tuneWorker(static_cast<size_t>(std::find_if(routes_.begin(), routes_.end(),
+                                                [&](const std::unique_ptr<Route> &r) { return r.get() == &route; }) -
+                                   routes_.begin()));
+
+    Drain &drain = *route.drain;
+    while (drain.running())
+    {
+        drain.syncSources();
+
+        // Wake when new data arrives or a pending batch comes due
+        if (drain.idle())
+        {
+            drain.park();
+            drain.syncSources();
+        }
+        drain.step();
+    }
+    drain.close();
+}
+
+/**
+ * @brief Set the minimum log level for filtering messages.
+ *
+ * This method updates the internal log level threshold in a thread-safe manner,
+ * ensuring that subsequent log calls respect the new level.
+ * Tags that have no level of their own change with it.
+ *
+ * @param level New log level threshold.
+ */
+void LCBLog::setLogLevel(LogLevel level)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    updateHot([&](HotConfig &settings) { settings.level = level; });
+
+    // Tags without a level of their own follow the logger's
+    for (auto &entry : tags_)
+    {
+        if (!entry.second.pinned)
+        {
+            entry.second.level.store(level, std::memory_order_relaxed);
+        }
+    }
+}
+
+/**
+ * @brief Find a tag by name, creating it with the logger's level.
+ *
+ * Caller must hold logMutex.
+ *
+ * @param name Tag name.
+ * @return The tag's state, stable for the logger's lifetime.
+ */
+LogTagState &LCBLog::findTag(std::string_view name)
+{
+    auto it = tags_.find(name);
+    if (it == tags_.end())
+    {
+        it = tags_.try_emplace(std::string(name)).first;
+        it->second.label.assign(name.data(), name.size());
+        it->second.label.push_back(':');
+        it->second.level.store(hot().level, std::memory_order_relaxed);
+    }
+    return it->second;
+}
+
+/**
+ * @brief Return a handle for logging under a named tag.
+ *
+ * @param name Subsystem name, written before each of its messages.
+ * @return Handle whose level check is one atomic load.
+ */
+LogTag LCBLog::tag(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    return LogTag(*this, findTag(name));
+}
+
+/**
+ * @brief Give a tag its own threshold, creating it if needed.
+ *
+ * @param name  Tag name.
+ * @param level New threshold for the tag.
+ */
+void LCBLog::setTagLevel(std::string_view name, LogLevel level)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    LogTagState &state = findTag(name);
+    state.pinned = true;
+    state.level.store(level, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Make a tag follow the logger's level again.
+ *
+ * @param name Tag name; unknown names are ignored.
+ */
+void LCBLog::resetTagLevel(std::string_view name)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    auto it = tags_.find(name);
+    if (it != tags_.end())
+    {
+        it->second.pinned = false;
+        it->second.level.store(hot().level, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Enable or disable timestamping for log messages.
+ *
+ * This method updates the setting that determines whether each log
+ * line is prefixed with a timestamp. It acquires a lock to ensure
+ * thread safety when modifying the flag.
+ *
+ * @param enable True to include timestamps in logs, false to omit them.
+ */
+void LCBLog::enableTimestamps(bool enable)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    updateHot([&](HotConfig &settings) { settings.timestamps = enable; });
+}
+
+/**
+ * @brief Enable or disable whitespace normalization of log lines.
+ *
+ * When disabled, each line is written exactly as formatted and crush()
+ * is skipped, which saves work for callers that send clean text.
+ *
+ * @param enable True to normalize lines, false to emit them verbatim.
+ */
+void LCBLog::enableNormalization(bool enable)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    updateHot([&](HotConfig &settings) { settings.normalize = enable; });
+}
+
+/**
+ * @brief Choose how log() behaves when a queue is full.
+ *
+ * The new policy applies to messages logged after the call returns.
+ * The settings are validated as setConfig() would, and nothing changes
+ * if they are rejected.
+ *
+ * @param policy       Overflow policy to apply.
+ * @param blockTimeout Longest wait for room under BlockWithTimeout.
+ * @param byteCap      Overflow list limit in bytes under GrowToCap.
+ * @throws std::invalid_argument if the resulting settings fail validation.
+ */
+void LCBLog::setOverflowPolicy(OverflowPolicy policy,
+                               std::chrono::milliseconds blockTimeout,
+                               size_t byteCap)
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    LCBLogConfig next = config_;
+    next.overflowPolicy = policy;
+    next.blockTimeout = blockTimeout;
+    next.overflowByteCap = byteCap;
+    next.validate();
+    config_ = next;
+    applyConfig();
+}
+
+/**
+ * @brief Retune a running logger.
+ *
+ * Validates the new settings, then publishes them to the atomics read
+ * by producers and workers. Parked workers are woken so that a shorter
+ * flush interval takes effect immediately.
+ *
+ * @param config New settings.
+ * @throws std::invalid_argument if config fails validation or asks for
+ * more queue capacity than was allocated.
+ */
+void LCBLog::setConfig(const LCBLogConfig &config)
+{
+    config.validate();
+    if (config.queueCapacity > routes_.front()->queue.capacity())
+    {
+        throw std::invalid_argument("LCBLogConfig: queueCapacity cannot exceed the capacity the logger was constructed with");
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(logMutex);
+        config_ = config;
+        applyConfig();
+        startReporter();
+    }
+    for (const auto &route : routes_)
+    {
+        route->queue.notifyAll();
+    }
+    {
+        // Under reporterMtx_ so the reporter cannot miss the change
+        std::lock_guard<std::mutex> lk(reporterMtx_);
+        ++reporterGeneration_;
+    }
+    reporterCv_.notify_all();
+}
+
+/**
+ * @brief Return the settings currently in effect.
+ *
+ * @return Copy of the active configuration.
+ */
+LCBLogConfig LCBLog::getConfig() const
+{
+    std::lock_guard<std::mutex> lock(logMutex);
+    return config_;
+}
+
+/**
+ * @brief Publish config_ fields to the atomics read on the hot path.
+ *
+ * Caller must hold logMutex or be the constructor.
+ */
+void LCBLog::applyConfig()
+{
+    batchSize_.store(config_.batchSize, std::memory_order_relaxed);
+    flushIntervalMs_.store(config_.flushInterval.count(), std::memory_order_relaxed);
+    blockTimeoutMs_.store(config_.blockTimeout.count(), std::memory_order_relaxed);
+    workerSpinNs_.store(std::chrono::duration_cast<std::chrono::nanoseconds>(config_.workerSpin).count(),
+                        std::memory_order_relaxed);
+    overflowByteCap_.store(config_.overflowByteCap, std::memory_order_relaxed);
+    updateHot([&](HotConfig &settings)
+              {
+                  settings.overflowPolicy = config_.overflowPolicy;
+                  settings.precision = config_.timestampPrecision;
+                  settings.clock = config_.timestampClock;
+                  settings.deferred = config_.deferredFormatting;
+                  settings.binary = config_.binaryFormat;
+                  settings.kvFormat = config_.kvFormat;
+                  settings.perThread = config_.perThreadQueues;
+                  settings.collapse = config_.collapseRepeats;
+              });
+    for (const auto &route : routes_)
+    {
+        route->queue.setLimit(config_.queueCapacity);
+    }
+    registerCrashDump(config_.crashHandler);
+}
+
+namespace
+{
+const int crashSignals[] = {SIGSEGV, SIGABRT, SIGBUS};
+constexpr size_t crashSignalCount = sizeof(crashSignals) / sizeof(crashSignals[0]);
+struct sigaction previousActions[crashSignalCount]; // Restored before re-raising
+constexpr size_t maxCrashLoggers = 8;
+std::atomic<LCBLog *> crashLoggers[maxCrashLoggers]; // Registered loggers; null slots are free
+std::atomic<bool> crashDumped{false};                // Only the first crashing thread dumps
+} // namespace (anonymous)
+
+/**
+ * @brief Add this logger to, or remove it from, the loggers dumped
+ * by the crash handler, installing the handler on first use.
+ *
+ * The handler stays installed for the life of the process; it simply
+ * finds no loggers once they are all unregistered. Up to maxCrashLoggers
+ * loggers can be registered at once; later ones are not dumped.
+ *
+ * @param enable True to register, false to unregister.
+ */
+void LCBLog::registerCrashDump(bool enable)
+{
+    if (!enable)
+    {
+        for (auto &slot : crashLoggers)
+        {
+            LCBLog *self = this;
+            slot.compare_exchange_strong(self, nullptr, std::memory_order_acq_rel);
+        }
+        return;
+    }
+
+    static std::once_flag installed;
+    std::call_once(installed, []()
+                   {
+                       struct sigaction action{};
+                       action.sa_handler = &LCBLog::onCrashSignal;
+                       sigemptyset(&action.sa_mask);
+                       action.sa_flags = SA_ONSTACK; // Use an alternate stack where a thread set one
+                       for (size_t i = 0; i < crashSignalCount; ++i)
+                       {
+                           sigaction(crashSignals[i], &action, &previousActions[i]);
+                       }
+                   });
+
+    for (const auto &slot : crashLoggers)
+    {
+        if (slot.load(std::memory_order_acquire) == this)
+        {
+            return;
+        }
+    }
+    for (auto &slot : crashLoggers)
+    {
+        LCBLog *empty = nullptr;
+        if (slot.compare_exchange_strong(empty, this, std::memory_order_acq_rel))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Write queued entries of every route whose sink has a crash
+ * descriptor.
+ *
+ * Each such sink gets a FATAL notice naming the signal, then the text
+ * entries still in its route queue, then a count of deferred entries
+ * that could not be formatted here. Binary output is left alone, and
+ * per-thread queues are not reached because their list is locked.
+ *
+ * @param sig Signal being handled, named in the notice line.
+ */
+void LCBLog::dumpQueued(int sig) const
+{
+    if (hot().binary)
+    {
+        return;
+    }
+    for (const auto &route : routes_)
+    {
+        const int fd = route->spec.sink->crashFd();
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        // Numbers go through a stack buffer; to_chars neither allocates nor locks
+        char digits[24];
+        auto writeNumber = [&](uint64_t value)
+        {
+            const char *end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+            writeFully(fd, digits, static_cast<size_t>(end - digits));
+        };
+        auto writeText = [&](std::string_view text) { writeFully(fd, text.data(), text.size()); };
+
+        writeText("[FATAL] Caught signal ");
+        writeNumber(static_cast<uint64_t>(sig));
+        writeText(", writing queued log entries\n");
+        const size_t skipped = route->queue.dumpPending(fd);
+        if (skipped > 0)
+        {
+            writeText("[FATAL] ");
+            writeNumber(skipped);
+            writeText(" deferred log entries not written\n");
+        }
+    }
+}
+
+/**
+ * @brief Handler for SIGSEGV, SIGABRT, and SIGBUS.
+ *
+ * The previous action is restored first, so a fault while dumping, or
+ * the re-raised signal, gets the behavior the process had before.
+ *
+ * @param sig Signal being handled.
+ */
+void LCBLog::onCrashSignal(int sig)
+{
+    const int savedErrno = errno;
+    for (size_t i = 0; i < crashSignalCount; ++i)
+    {
+        if (crashSignals[i] == sig)
+        {
+            sigaction(sig, &previousActions[i], nullptr);
+        }
+    }
+    if (!crashDumped.exchange(true, std::memory_order_acq_rel))
+    {
+        for (const auto &slot : crashLoggers)
+        {
+            if (const LCBLog *logger = slot.load(std::memory_order_acquire))
+            {
+                logger->dumpQueued(sig);
+            }
+        }
+    }
+    errno = savedErrno;
+    raise(sig);
+}
+
+/**
+ * @brief Return the number of messages lost to queue overflow.
+ *
+ * @return Total dropped messages across all route and thread queues,
+ * including thread queues already retired.
+ */
+uint64_t LCBLog::droppedCount() const
+{
+    uint64_t total = 0;
+    for (const auto &route : routes_)
+    {
+        total += route->queue.droppedTotal();
+        std::lock_guard<std::mutex> lk(route->threadsMtx);
+        total += route->retiredDrops;
+        for (const auto &q : route->threads)
+        {
+            total += q->ring.droppedTotal();
+        }
+    }
+    return total;
+}
+
+/**
+ * @brief Wait until every message logged before the call is written
+ * and the sinks are flushed.
+ *
+ * Messages logged afterwards do not hold it up: each worker compares
+ * its queue positions against a watermark taken when it sees the
+ * request. Returns at once when called from a worker.
+ */
+void LCBLog::flush()
+{
+    awaitFlush(false, std::chrono::steady_clock::time_point());
+}
+
+/**
+ * @brief Like flush(), but give up after timeout.
+ *
+ * @param timeout Longest time to wait.
+ * @return True if everything logged before the call was written.
+ */
+bool LCBLog::flushFor(std::chrono::milliseconds timeout)
+{
+    return awaitFlush(true, std::chrono::steady_clock::now() + timeout);
+}
+
+/**
+ * @brief Request a flush on every route and wait for the workers.
+ *
+ * All routes are asked first so their workers flush in parallel. A
+ * worker never waits here: its own route could not answer, and waiting
+ * on another route could deadlock against that route's sink.
+ *
+ * @param bounded  False to wait without a limit.
+ * @param deadline Latest time to wait when bounded.
+ * @return True if every route answered, false on timeout or when
+ * called from a worker.
+ */
+bool LCBLog::awaitFlush(bool bounded, std::chrono::steady_clock::time_point deadline)
+{
+    const std::thread::id self = std::this_thread::get_id();
+    for (const auto &route : routes_)
+    {
+        if (route->worker.get_id() == self)
+        {
+            return false;
+        }
+    }
+    if (executor_ && executor_->onExecutorThread())
+    {
+        return false;
+    }
+
+    std::vector<uint64_t> tickets;
+    tickets.reserve(routes_.size());
+    for (const auto &route : routes_)
+    {
+        tickets.push_back(route->flushRequested.fetch_add(1, std::memory_order_acq_rel) + 1);
+        route->queue.notify();
+    }
+
+    bool flushed = true;
+    for (size_t i = 0; i < routes_.size(); ++i)
+    {
+        Route &route = *routes_[i];
+        auto answered = [&]() { return route.flushDone.load(std::memory_order_acquire) >= tickets[i]; };
+        std::unique_lock<std::mutex> lk(route.flushMtx);
+        if (!bounded)
+        {
+            route.flushCv.wait(lk, answered);
+        }
+        else if (!route.flushCv.wait_until(lk, deadline, answered))
+        {
+            flushed = false;
+        }
+    }
+    return flushed;
+}
+
+/**
+ * @brief Add another set of counters; highWater keeps the larger.
+ *
+ * @param other Counters to add.
+ * @return This object.
+ */
+LogQueueStats &LogQueueStats::operator+=(const LogQueueStats &other)
+{
+    enqueued += other.enqueued;
+    dropped += other.dropped;
+    written += other.written;
+    bytesWritten += other.bytesWritten;
+    batches += other.batches;
+    highWater = std::max(highWater, other.highWater);
+    writeTime += other.writeTime;
+    return *this;
+}
+
+/**
+ * @brief Read the logger's self-instrumentation counters.
+ *
+ * Enqueue and drop counts come from the queues themselves, including
+ * thread queues and those already retired; the rest are kept by each
+ * route's worker.
+ *
+ * @return Per-route counters and their totals.
+ */
+LogStats LCBLog::stats() const
+{
+    LogStats out;
+    for (const auto &route : routes_)
+    {
+        LogQueueStats q;
+        q.enqueued = route->queue.pushedTotal();
+        q.dropped = route->queue.droppedTotal();
+        {
+            std::lock_guard<std::mutex> lk(route->threadsMtx);
+            q.enqueued += route->retiredPushed;
+            q.dropped += route->retiredDrops;
+            for (const auto &t : route->threads)
+            {
+                q.enqueued += t->ring.pushedTotal();
+                q.dropped += t->ring.droppedTotal();
+            }
+        }
+        q.written = route->written.load(std::memory_order_relaxed);
+        q.bytesWritten = route->bytes.load(std::memory_order_relaxed);
+        q.batches = route->batches.load(std::memory_order_relaxed);
+        q.highWater = route->highWater.load(std::memory_order_relaxed);
+        q.writeTime = std::chrono::nanoseconds(route->writeNs.load(std::memory_order_relaxed));
+        out.total += q;
+        out.routes.push_back(q);
+    }
+    return out;
+}
+
+/**
+ * @brief Start the stats reporter if an interval is set and it is not
+ * running.
+ *
+ * Once started, the reporter runs until the logger is destroyed and
+ * idles while the interval is zero.
+ *
+ * Caller must hold logMutex or be the constructor.
+ */
+void LCBLog::startReporter()
+{
+    if (config_.statsInterval.count() > 0 && !reporter_.joinable())
+    {
+        reporter_ = std::thread(&LCBLog::reportLoop, this);
+    }
+}
+
+/**
+ * @brief Write a stats record per route every statsInterval.
+ *
+ * Records are encoded like logKV() ones. They go to statsSink when one
+ * is configured, which must not also be a route's sink since sinks are
+ * not shared between threads; otherwise they are logged at INFO.
+ */
+void LCBLog::reportLoop()
+{
+    std::unique_lock<std::mutex> lk(reporterMtx_);
+    while (!reporterStop_)
+    {
+        // Settings read after the generation; a later setConfig() changes it
+        const uint64_t generation = reporterGeneration_;
+        std::chrono::milliseconds interval;
+        std::shared_ptr<LogSink> sink;
+        {
+            std::lock_guard<std::mutex> lock(logMutex);
+            interval = config_.statsInterval;
+            sink = config_.statsSink;
+        }
+        auto interrupted = [&] { return reporterStop_ || reporterGeneration_ != generation; };
+        if (interval.count() == 0)
+        {
+            // Disabled by setConfig(); wait to be re-enabled or stopped
+            reporterCv_.wait(lk, interrupted);
+            continue;
+        }
+        if (reporterCv_.wait_for(lk, interval, interrupted))
+        {
+            // Stopped, or retuned: start over with the new settings
+            continue;
+        }
+        lk.unlock();
+
+        const LogStats snapshot = stats();
+        const HotConfig settings = hot();
+        const KVFormat fmt = settings.kvFormat;
+        std::vector<LogEntry> records(snapshot.routes.size());
+        for (size_t i = 0; i < snapshot.routes.size(); ++i)
+        {
+            const LogQueueStats &q = snapshot.routes[i];
+            std::string &text = records[i].msg;
+            beginRecord(text, settings, INFO, "lcblog stats");
+            appendKey(text, fmt, "route");
+            appendKVValue(text, fmt, i);
+            appendKey(text, fmt, "enqueued");
+            appendKVValue(text, fmt, q.enqueued);
+            appendKey(text, fmt, "dropped");
+            appendKVValue(text, fmt, q.dropped);
+            appendKey(text, fmt, "written");
+            appendKVValue(text, fmt, q.written);
+            appendKey(text, fmt, "bytes");
+            appendKVValue(text, fmt, q.bytesWritten);
+            appendKey(text, fmt, "batches");
+            appendKVValue(text, fmt, q.batches);
+            appendKey(text, fmt, "high_water");
+            appendKVValue(text, fmt, q.highWater);
+            appendKey(text, fmt, "write_us");
+            appendKVValue(text, fmt, static_cast<int64_t>(q.writeTime.count() / 1000));
+            endRecord(text, fmt);
+            records[i].dest = LogEntry::Out;
+            records[i].level = INFO;
+        }
+
+        if (sink)
+        {
+            sink->write(LogEntrySpan{records.data(), records.size()});
+            sink->flush();
+        }
+        else if (INFO >= settings.level)
+        {
+            for (const LogEntry &record : records)
+            {
+                dispatch(settings, INFO, record.msg, false);
+            }
+        }
+        lk.lock();
+    }
+}
+
+/**
+ * @brief Remember a limiter that refused a message, so its count is
+ * reported even if the call site never logs again.
+ *
+ * Only the first refusal of a run takes the lock; later ones see the
+ * limiter already watched. A limiter watched by another logger is left
+ * to that logger.
+ *
+ * @param limit Limiter that refused the message.
+ * @param level Level of the refused message.
+ * @param tag   Tag the message was logged under, or nullptr.
+ */
+void LCBLog::watchLimit(LogRateLimit &limit, LogLevel level, const LogTagState *tag)
+{
+    if (limit.watcher_.load(std::memory_order_relaxed) != nullptr)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lk(limitsMtx_);
+    LCBLog *expected = nullptr;
+    if (!limit.watcher_.compare_exchange_strong(expected, this))
+    {
+        return;
+    }
+    limits_.push_back(WatchedLimit{&limit, level, tag});
+    limitsWatched_.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Forget a limiter that is being destroyed, logging the refusals
+ * it still holds.
+ *
+ * @param limit Limiter to forget.
+ */
+void LCBLog::unwatchLimit(LogRateLimit &limit)
+{
+    WatchedLimit found{nullptr, INFO, nullptr};
+    {
+        std::lock_guard<std::mutex> lk(limitsMtx_);
+        auto it = std::find_if(limits_.begin(), limits_.end(),
+                               [&](const WatchedLimit &w) { return w.limit == &limit; });
+        if (it != limits_.end())
+        {
+            found = *it;
+            limits_.erase(it);
+        }
+        LCBLog *self = this;
+        limit.watcher_.compare_exchange_strong(self, nullptr);
+        limitsWatched_.store(!limits_.empty(), std::memory_order_release);
+    }
+    if (found.limit != nullptr)
+    {
+        reportCount(found.level, found.tag, limit.takeSuppressed());
+    }
+}
+
+/**
+ * @brief Log the refusals of watched limiters whose window has passed.
+ *
+ * Called by the first route's worker on every pass and by the
+ * destructor. A limiter is unwatched before its count is taken, so a
+ * refusal racing with the report watches it again rather than being
+ * lost.
+ *
+ * @param all Report every watched limiter, as at shutdown.
+ */
+void LCBLog::reportSuppressed(bool all)
+{
+    if (!limitsWatched_.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    struct Report
+    {
+        LogLevel level;
+        const LogTagState *tag;
+        uint64_t count;
+    };
+    std::vector<Report> reports;
+    {
+        std::lock_guard<std::mutex> lk(limitsMtx_);
+        for (auto it = limits_.begin(); it != limits_.end();)
+        {
+            if (!all && !it->limit->wouldAllow())
+            {
+                ++it;
+                continue;
+            }
+            LCBLog *self = this;
+            it->limit->watcher_.compare_exchange_strong(self, nullptr);
+            if (uint64_t count = it->limit->takeSuppressed())
+            {
+                reports.push_back(Report{it->level, it->tag, count});
+            }
+            it = limits_.erase(it);
+        }
+        limitsWatched_.store(!limits_.empty(), std::memory_order_release);
+    }
+
+    for (const Report &r : reports)
+    {
+        reportCount(r.level, r.tag, r.count);
+    }
+}
+
+/**
+ * @brief Log one limiter's refusal count.
+ *
+ * Never blocks: a full queue under BlockWithTimeout drops the report
+ * instead, since the caller may be the worker that drains it.
+ *
+ * @param level Level of the refused messages.
+ * @param tag   Tag they were logged under, or nullptr.
+ * @param count Number of refused messages; nothing is logged for zero.
+ */
+void LCBLog::reportCount(LogLevel level, const LogTagState *tag, uint64_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    HotConfig settings = hot();
+    if (settings.overflowPolicy == BlockWithTimeout)
+    {
+        settings.overflowPolicy = DropNewest;
+    }
+    settings.perThread = false;
+    if (tag != nullptr)
+    {
+        emit(settings, level, BorrowedArg{tag->label}, count, "similar messages suppressed");
+    }
+    else
+    {
+        emit(settings, level, count, "similar messages suppressed");
+    }
+}
+
+/**
+ * @brief Read the clock selected for timestamps.
+ *
+ * Falls back to CLOCK_REALTIME where the coarse clock is not available.
+ *
+ * @param clock Clock to sample.
+ * @return The current wall-clock time.
+ */
+LogStamp LCBLog::captureStamp(TimestampClock clock)
+{
+    clockid_t id = CLOCK_REALTIME;
+#ifdef CLOCK_REALTIME_COARSE
+    if (clock == ClockRealtimeCoarse)
+    {
+        id = CLOCK_REALTIME_COARSE;
+    }
+#else
+    (void)clock;
+#endif
+
+    timespec ts{};
+    clock_gettime(id, &ts);
+
+    LogStamp stamp;
+    stamp.sec = static_cast<int64_t>(ts.tv_sec);
+    stamp.nsec = static_cast<int32_t>(ts.tv_nsec);
+    return stamp;
+}
+
+/**
+ * @brief Append a UTC timestamp for a captured time.
+ *
+ * Formats the time as YYYY-MM-DD HH:MM:SS, appends three or six
+ * fractional digits, and tags the result with "UTC". gmtime_r() and
+ * strftime() run only when the second differs from the last stamp made
+ * on this thread; otherwise only the fractional digits are written.
+ *
+ * @param buffer    Destination for the timestamp text.
+ * @param stamp     Time to format.
+ * @param precision Number of fractional digits to print.
+ */
+void LCBLog::appendStamp(std::string &buffer, const LogStamp &stamp, TimestampPrecision precision)
+{
+    // Date and time text for the most recent second seen by this thread
+    static thread_local int64_t cachedSec = INT64_MIN;
+    static thread_local char cachedText[32];
+    static thread_local size_t cachedLen = 0;
+
+    if (stamp.sec != cachedSec)
+    {
+        // Convert to UTC broken-down time
+        time_t now_time_t = static_cast<time_t>(stamp.sec);
+        std::tm tm{};
+        gmtime_r(&now_time_t, &tm);
+        cachedLen = std::strftime(cachedText, sizeof(cachedText), "%F %T", &tm);
+        cachedSec = stamp.sec;
+    }
+
+    // Patch in the fractional digits, most significant first
+    char frac[8];
+    int digits = (precision == StampMicros) ? 6 : 3;
+    int value = (precision == StampMicros) ? stamp.nsec / 1000 : stamp.nsec / 1000000;
+    frac[0] = '.';
+    for (int i = digits; i > 0; --i)
+    {
+        frac[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+
+    buffer.append(cachedText, cachedLen);
+    buffer.append(frac, static_cast<size_t>(digits + 1));
+    buffer.append(" UTC");
+}
+
+/**
+ * @brief Determine if a space should be omitted between two tokens.
+ *
+ * This free function returns true when the next token is empty or
+ * starts with punctuation, or when the previous token ends with
+ * whitespace. It returns false if a space is required before a word.
+ *
+ * @param prev Previous token text.
+ * @param curr Next token text.
+ * @return True if no space should be added, false otherwise.
+ */
+bool shouldSkipSpace(std::string_view prev, std::string_view curr)
+{
+    // Skip if next token is empty or begins with punctuation
+    if (curr.empty() || std::ispunct(static_cast<unsigned char>(curr.front())))
+    {
+        return true;
+    }
+
+    // Require space if this is the first token
+    if (prev.empty())
+    {
+        return false;
+    }
+
+    // Skip if previous ends in whitespace
+    if (std::isspace(static_cast<unsigned char>(prev.back())))
+    {
+        return true;
+    }
+
+    // Otherwise, add a space
+    return false;
+}
 
 /**
- * @brief Converts a log level to its string representation.
+ * @brief Insert a separating space before the newest message part.
  *
- * @param level The log level to convert.
- * @return A string representing the log level.
+ * Applies shouldSkipSpace() to the previous part and the part that
+ * starts at start, inserts a space between them when needed, and
+ * advances prevStart to the newest part.
+ *
+ * @param combined  Buffer holding all parts appended so far.
+ * @param prevStart Offset of the previous part; updated on return.
+ * @param start     Offset of the newest part.
  */
-std::string logLevelToString(LogLevel level)
+void LCBLog::joinPart(std::string &combined, size_t &prevStart, size_t start)
 {
-    switch (level)
+    std::string_view all(combined);
+    if (!::shouldSkipSpace(all.substr(prevStart, start - prevStart), all.substr(start)))
     {
-    case DEBUG:
-        return "DEBUG";
-    case INFO:
-        return "INFO";
-    case WARN:
-        return "WARN";
-    case ERROR:
-        return "ERROR";
-    case FATAL:
-        return "FATAL";
-    default:
-        return "UNKNOWN";
+        combined.insert(start, 1, ' ');
+        ++start;
     }
+    prevStart = start;
 }
 
 /**
- * @brief Constructs the logger and starts asynchronous worker threads.
+ * @brief Capture the current line options and, if needed, the time.
  *
- * Initializes the log level and binds the output streams for immediate flushing.
- * Then spawns two worker threads—one for standard output and one for error output—
- * each processing its own message queue.
+ * The clock is read once here, so every line of a message carries the
+ * same timestamp.
  *
- * @param outStream Reference to the std::ostream for INFO/WARN/DEBUG logs.
- * @param errStream Reference to the std::ostream for ERROR/FATAL logs.
+ * @return Style to format the next message with.
  */
-LCBLog::LCBLog(std::ostream &outStream, std::ostream &errStream)
-    : logLevel(INFO) // Default threshold to INFO level
-      ,
-      out(outStream) // Stream for non-error messages
-      ,
-      err(errStream) // Stream for error messages
+LogStyle LCBLog::currentStyle() const
 {
-    // Ensure both streams flush on every insertion
-    out << std::unitbuf;
-    err << std::unitbuf;
-
-    // Launch worker thread to drain the stdout queue
-    outWorker_ = std::thread(
-        &LCBLog::workerLoop, this,
-        std::ref(outQueue_), std::ref(outMtx_),
-        std::ref(outCv_), std::ref(std::cout));
+    return currentStyle(hot());
+}
 
-    // Launch worker thread to drain the stderr queue
-    errWorker_ = std::thread(
-        &LCBLog::workerLoop, this,
-        std::ref(errQueue_), std::ref(errMtx_),
-        std::ref(errCv_), std::ref(std::cerr));
+/**
+ * @brief Capture the line options from loaded settings and, if needed, the time.
+ *
+ * Lets a log call reuse the settings it already loaded for its level
+ * check instead of reading them again.
+ *
+ * @param settings Hot settings loaded by the caller.
+ * @return Style to format the next message with.
+ */
+LogStyle LCBLog::currentStyle(const HotConfig &settings) const
+{
+    LogStyle style;
+    style.timestamps = settings.timestamps;
+    style.normalize = settings.normalize;
+    if (style.timestamps)
+    {
+        style.stamp = captureStamp(settings.clock);
+        style.precision = settings.precision;
+    }
+    return style;
 }
 
 /**
- * @brief Cleans up the logger, ensuring remaining entries are processed.
+ * @brief Split combined text into tagged and optionally stamped lines.
  *
- * Signals worker threads to stop, wakes them if they are waiting,
- * and joins them so that all queued log messages are flushed before
- * destruction completes.
+ * Lines are split on '\n' with the same rules as std::getline: a trailing
+ * line break does not start an extra line, and empty text still produces
+ * one tagged empty entry. Each line is normalized in place when enabled.
+ * Every line of a message carries the same timestamp from style.
+ *
+ * @param buffer   Destination for the formatted lines.
+ * @param level    Severity level used for the tag.
+ * @param combined Joined message text, possibly spanning several lines.
+ * @param style    Timestamp and normalization options.
  */
-LCBLog::~LCBLog()
+void LCBLog::appendLines(std::string &buffer, LogLevel level, std::string_view combined,
+                         const LogStyle &style)
 {
-    // Tell workers to exit their processing loops
-    done_.store(true, std::memory_order_release);
+    // Build padded level tag
+    std::string_view levelStr = levelTag(level);
 
-    // Wake up any workers that are waiting on the condition variables
-    outCv_.notify_all();
-    errCv_.notify_all();
+    const bool stamped = style.timestamps;
+    const LogStamp &stamp = style.stamp;
+    const TimestampPrecision precision = style.precision;
+
+    size_t pos = 0;
+    bool firstLine = true;
+    do
+    {
+        size_t nl = combined.find('\n', pos);
+        std::string_view line = combined.substr(pos, nl == std::string_view::npos ? std::string_view::npos : nl - pos);
+        pos = (nl == std::string_view::npos) ? combined.size() : nl + 1;
+
+        if (!firstLine)
+        {
+            buffer.push_back('\n');
+        }
+        if (stamped)
+        {
+            appendStamp(buffer, stamp, precision);
+            buffer.push_back('\t');
+        }
+        buffer.push_back('[');
+        buffer.append(levelStr);
+        buffer.append("] ");
+
+        size_t start = buffer.size();
+        buffer.append(line);
+        if (style.normalize)
+        {
+            buffer.resize(start + crushInPlace(&buffer[start], line.size()));
+        }
+        firstLine = false;
+    } while (pos < combined.size());
+
+    // Write final newline
+    buffer.push_back('\n');
+}
+
+/**
+ * @brief Start a logKV() record with its timestamp, level and message.
+ *
+ * @param buffer   Destination buffer.
+ * @param settings Hot settings giving the encoding and timestamp options.
+ * @param level    Severity level of the record.
+ * @param msg      Human-readable message.
+ */
+void LCBLog::beginRecord(std::string &buffer, const HotConfig &settings, LogLevel level, std::string_view msg) const
+{
+    const KVFormat format = settings.kvFormat;
+    std::string_view levelStr = levelTag(level);
+    levelStr = levelStr.substr(0, levelStr.find(' '));
 
-    // Wait for the stdout worker to finish draining its queue
-    if (outWorker_.joinable())
+    if (format == KVJson)
     {
-        outWorker_.join();
+        buffer.push_back('{');
     }
 
-    // Wait for the stderr worker to finish draining its queue
-    if (errWorker_.joinable())
+    if (settings.timestamps)
     {
-        errWorker_.join();
+        // Stamp into the parts buffer so it can be quoted like any value
+        std::string &stamp = combineBuffer();
+        stamp.clear();
+        appendStamp(stamp, captureStamp(settings.clock), settings.precision);
+        appendKey(buffer, format, "ts");
+        appendQuoted(buffer, format, stamp);
     }
+
+    appendKey(buffer, format, "level");
+    appendQuoted(buffer, format, levelStr);
+    appendKey(buffer, format, "msg");
+    appendQuoted(buffer, format, msg);
 }
 
 /**
- * @brief Returns the singleton logger instance.
- *
- * Constructs the LCBLog instance on first invocation using the given
- * output and error streams. Subsequent calls ignore their parameters
- * and return the same instance.
+ * @brief Finish a logKV() record.
  *
- * @param out The output stream for standard logs (default: std::cout)
- * @param err The output stream for error logs (default: std::cerr)
- * @return Reference to the global LCBLog singleton instance
+ * @param buffer Destination buffer.
+ * @param format Record encoding.
  */
-LCBLog &getLogger(std::ostream &out, std::ostream &err)
+void LCBLog::endRecord(std::string &buffer, KVFormat format)
 {
-    // This static is constructed exactly once, on the first call.
-    static LCBLog instance{out, err};
-    return instance;
+    if (format == KVJson)
+    {
+        buffer.push_back('}');
+    }
+    buffer.push_back('\n');
 }
 
 /**
- * @brief Returns the singleton logger instance.
+ * @brief Append the separator and key of the next field.
  *
- * Constructs the LCBLog instance on first invocation using default
- * output and error streams. Subsequent calls ignore their parameters
- * and return the same instance.
+ * No separator is written before the first field of a record. JSON keys
+ * are escaped like strings. logfmt keys cannot be quoted, so spaces, '=',
+ * '"' and control characters in them become '_'.
  *
- * @return Reference to the global LCBLog singleton instance
+ * @param buffer Destination buffer.
+ * @param format Record encoding.
+ * @param key    Field name.
  */
-LCBLog& getLogger() {
-    return getLogger(std::cout, std::cerr);
+void LCBLog::appendKey(std::string &buffer, KVFormat format, std::string_view key)
+{
+    if (format == KVJson)
+    {
+        if (buffer.back() != '{')
+        {
+            buffer.push_back(',');
+        }
+        appendQuoted(buffer, format, key);
+        buffer.push_back(':');
+        return;
+    }
+
+    if (!buffer.empty())
+    {
+        buffer.push_back(' ');
+    }
+    if (key.empty())
+    {
+        buffer.push_back('_');
+    }
+    for (char c : key)
+    {
+        const bool invalid = static_cast<unsigned char>(c) <= ' ' || c == '=' || c == '"' || c == 0x7f;
+        buffer.push_back(invalid ? '_' : c);
+    }
+    buffer.push_back('=');
 }
 
 /**
- * @brief Processes queued log entries in batches on a background thread.
+ * @brief Append a string value, quoted and escaped as the format needs.
  *
- * This loop waits for new entries or a timeout, moves up to batchSize_
- * messages into a local buffer, writes them to the output stream, and
- * flushes when the batch is full or the flush interval has elapsed.
+ * JSON strings are always quoted, with '"', '\\' and control characters
+ * escaped. logfmt values are left bare unless they are empty or contain
+ * a space, '=', '"', '\\' or a control character.
  *
- * @param queue Reference to the deque holding pending log entries.
- * @param mtx Reference to the mutex protecting the queue.
- * @param cv Reference to the condition variable for queue notifications.
- * @param stream Reference to the output stream where log messages are written.
+ * @param buffer Destination buffer.
+ * @param format Record encoding.
+ * @param text   Value to encode.
  */
-void LCBLog::workerLoop(std::deque<std::unique_ptr<LogEntry>> &queue,
-                        std::mutex &mtx,
-                        std::condition_variable &cv,
-                        std::ostream &stream)
+void LCBLog::appendQuoted(std::string &buffer, KVFormat format, std::string_view text)
 {
-    std::vector<std::string> batch;
-    batch.reserve(batchSize_); // Allocate buffer for batch of log messages
-
-    auto lastFlush = std::chrono::steady_clock::now(); // Initialize last flush time
-
-    // Continue until shutdown is signaled and queue is empty
-    while (!done_.load(std::memory_order_acquire) || !queue.empty())
+    if (format == KVLogfmt)
     {
+        bool plain = !text.empty();
+        for (char c : text)
         {
-            std::unique_lock<std::mutex> lk(mtx);
-            // Wake when new data arrives or flush interval elapses
-            cv.wait_for(lk, flushInterval_, [&]
-                        { return done_.load(std::memory_order_acquire) || !queue.empty(); });
-
-            // Move up to batchSize_ messages into the local buffer
-            while (!queue.empty() && batch.size() < batchSize_)
+            if (static_cast<unsigned char>(c) <= ' ' || c == '=' || c == '"' || c == '\\' || c == 0x7f)
             {
-                batch.emplace_back(std::move(queue.front()->msg));
-                queue.pop_front();
+                plain = false;
+                break;
             }
         }
+        if (plain)
+        {
+            buffer.append(text);
+            return;
+        }
+    }
 
-        // Write batched messages to the output stream
-        for (auto &msg : batch)
+    static const char hex[] = "0123456789abcdef";
+    buffer.push_back('"');
+    size_t run = 0;
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\')
         {
-            stream << msg;
+            continue;
         }
 
-        // Flush if the batch is full or the flush interval has elapsed
-        auto now = std::chrono::steady_clock::now();
-        if (batch.size() >= batchSize_ || now - lastFlush >= flushInterval_)
+        // Copy the unescaped run before this character in one append
+        buffer.append(text.data() + run, i - run);
+        run = i + 1;
+        buffer.push_back('\\');
+        switch (c)
         {
-            stream << std::flush;
-            lastFlush = now;
+        case '"':
+        case '\\':
+            buffer.push_back(static_cast<char>(c));
+            break;
+        case '\n':
+            buffer.push_back('n');
+            break;
+        case '\t':
+            buffer.push_back('t');
+            break;
+        case '\r':
+            buffer.push_back('r');
+            break;
+        case '\b':
+            buffer.push_back('b');
+            break;
+        case '\f':
+            buffer.push_back('f');
+            break;
+        default:
+            buffer.append("u00");
+            buffer.push_back(hex[c >> 4]);
+            buffer.push_back(hex[c & 0xf]);
+            break;
         }
+    }
+    buffer.append(text.data() + run, text.size() - run);
+    buffer.push_back('"');
+}
 
-        batch.clear(); // Clear the buffer for the next batch
+/**
+ * @brief Turn a LogPack encoding into log text.
+ *
+ * Each argument is decoded back to its original kind and converted with
+ * appendLogArg(), then joined and split into lines exactly as formatTo()
+ * does, so the result matches eager formatting byte for byte.
+ *
+ * @param buffer  Destination for the formatted lines.
+ * @param level   Severity level used for the tag.
+ * @param packed  Encoded style and arguments.
+ * @param formats Format table read from a binary file, or nullptr to
+ * use this process's registered formats. Borrowed arguments are only
+ * accepted with nullptr.
+ * @return False if the encoding is malformed; buffer may then hold a
+ * partial message.
+ */
+bool LCBLog::formatPacked(std::string &buffer, LogLevel level, std::string_view packed,
+                          const std::vector<std::string> *formats)
+{
+    LogStyle style;
+    if (!LogPack::getHeader(packed, style))
+    {
+        return false;
     }
 
-    // Drain any remaining messages after shutdown
+    std::string &combined = combineBuffer();
+    combined.clear();
+    size_t prevStart = 0;
+    bool first = true;
+    LogPack::Arg arg;
+    while (!packed.empty())
     {
-        std::lock_guard<std::mutex> lk(mtx);
-        while (!queue.empty())
+        if (!LogPack::nextArg(packed, arg))
+        {
+            return false;
+        }
+        const size_t start = combined.size();
+
+        switch (arg.tag)
+        {
+        case LogPack::Int:
+            appendLogArg(combined, static_cast<int64_t>(arg.raw));
+            break;
+        case LogPack::Uint:
+            appendLogArg(combined, arg.raw);
+            break;
+        case LogPack::Float:
+        {
+            double value;
+            std::memcpy(&value, &arg.raw, sizeof(value));
+            appendLogArg(combined, value);
+            break;
+        }
+        case LogPack::Char:
+            appendLogArg(combined, static_cast<char>(arg.raw));
+            break;
+        case LogPack::Bool:
+            appendLogArg(combined, arg.raw != 0);
+            break;
+        case LogPack::Null:
+            appendLogArg(combined, nullptr);
+            break;
+        case LogPack::Pointer:
+            // Any object pointer type prints the same address form
+            appendLogArg(combined, reinterpret_cast<const std::uintptr_t *>(static_cast<std::uintptr_t>(arg.raw)));
+            break;
+        case LogPack::Borrowed:
+            if (formats != nullptr)
+            {
+                return false;
+            }
+            combined.append(arg.text);
+            break;
+        case LogPack::Text:
+            combined.append(arg.text);
+            break;
+        case LogPack::Format:
+            if (formats != nullptr)
+            {
+                if (arg.raw >= formats->size())
+                {
+                    return false;
+                }
+                combined.append((*formats)[arg.raw]);
+            }
+            else if (!appendRegisteredFormat(combined, static_cast<uint32_t>(arg.raw)))
+            {
+                return false;
+            }
+            break;
+        }
+
+        if (!first)
         {
-            stream << queue.front()->msg;
-            queue.pop_front();
+            joinPart(combined, prevStart, start);
         }
-        stream << std::flush;
+        first = false;
     }
+
+    appendLines(buffer, level, combined, style);
+    return true;
 }
 
 /**
- * @brief Set the minimum log level for filtering messages.
+ * @brief Register constant message text and assign it an ID.
  *
- * This method updates the internal log level threshold in a thread-safe manner,
- * ensuring that subsequent log calls respect the new level.
+ * IDs are dense and start at zero, so a binary writer only needs to
+ * remember how many it has written.
  *
- * @param level New log level threshold.
+ * @param text Message text; copied into the process-wide table.
+ * @return Handle to pass as a message component.
  */
-void LCBLog::setLogLevel(LogLevel level)
+LogFormat LCBLog::registerFormat(std::string_view text)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    logLevel = level;
+    FormatRegistry &registry = formatRegistry();
+    std::lock_guard<std::mutex> lk(registry.mtx);
+    registry.texts.emplace_back(text);
+    LogFormat fmt;
+    fmt.id = static_cast<uint32_t>(registry.texts.size() - 1);
+    fmt.text = registry.texts.back();
+    return fmt;
 }
 
 /**
- * @brief Enable or disable timestamping for log messages.
+ * @brief Append one queued entry as binary records.
  *
- * This method updates the setting that determines whether each log
- * line is prefixed with a timestamp. It acquires a lock to ensure
- * thread safety when modifying the flag.
+ * Writes format records for any IDs not yet written to this stream,
+ * then the message record. Borrowed strings are copied, since their
+ * addresses mean nothing outside this process. Entries formatted as text
+ * before binary output was enabled become text records.
  *
- * @param enable True to include timestamps in logs, false to omit them.
+ * @param out            Destination buffer.
+ * @param level          Severity of the entry.
+ * @param body           Packed arguments, or formatted text.
+ * @param packed         True if body is a LogPack encoding.
+ * @param formatsWritten Number of format IDs already written; updated.
  */
-void LCBLog::enableTimestamps(bool enable)
+void LCBLog::appendBinaryRecord(std::string &out, LogLevel level, std::string_view body, bool packed,
+                                size_t &formatsWritten)
 {
-    std::lock_guard<std::mutex> lock(logMutex);
-    printTimestamps = enable;
+    const size_t recordStart = out.size();
+    size_t lengthAt = recordStart;
+    out.append(4, '\0');
+
+    if (!packed)
+    {
+        out.push_back(LogPack::RecordText);
+        out.append(body.data(), body.size());
+    }
+    else
+    {
+        out.push_back(LogPack::RecordMessage);
+        out.push_back(static_cast<char>(level));
+        out.append(body.data(), std::min(body.size(), LogPack::headerSize));
+        body.remove_prefix(std::min(body.size(), LogPack::headerSize));
+
+        // Copy arguments, resolving borrowed text and noting format IDs
+        size_t neededFormats = 0;
+        LogPack::Arg arg;
+        std::string_view rest = body;
+        while (!rest.empty())
+        {
+            std::string_view at = rest;
+            if (!LogPack::nextArg(rest, arg))
+            {
+                // Keep the bytes; the decoder reports the record as malformed
+                out.append(at.data(), at.size());
+                break;
+            }
+            if (arg.tag == LogPack::Borrowed)
+            {
+                LogPack::putText(out, arg.text);
+                continue;
+            }
+            if (arg.tag == LogPack::Format)
+            {
+                neededFormats = std::max(neededFormats, static_cast<size_t>(arg.raw) + 1);
+            }
+            out.append(at.data(), at.size() - rest.size());
+        }
+
+        // Define new formats ahead of their first use
+        if (neededFormats > formatsWritten)
+        {
+            std::string defs;
+            FormatRegistry &registry = formatRegistry();
+            std::lock_guard<std::mutex> lk(registry.mtx);
+            for (; formatsWritten < neededFormats && formatsWritten < registry.texts.size(); ++formatsWritten)
+            {
+                const std::string &text = registry.texts[formatsWritten];
+                LogPack::putU32(defs, static_cast<uint32_t>(1 + 4 + text.size()));
+                defs.push_back(LogPack::RecordFormat);
+                LogPack::putU32(defs, static_cast<uint32_t>(formatsWritten));
+                defs.append(text);
+            }
+            out.insert(recordStart, defs);
+            lengthAt += defs.size();
+        }
+    }
+
+    // Fill in the length now that the record is complete
+    const uint32_t len = static_cast<uint32_t>(out.size() - lengthAt - 4);
+    for (int i = 0; i < 4; ++i)
+    {
+        out[lengthAt + i] = static_cast<char>(len >> (8 * i));
+    }
 }
 
 /**
- * @brief Determine if a message meets the current log level threshold.
+ * @brief Decode the record at the front of in.
  *
- * This method compares the provided level against the internally stored
- * threshold to decide whether the message should be emitted.
+ * Format records extend the table used by later messages; one whose ID
+ * skips ahead of the table is malformed, since writers number formats
+ * in order. Message
+ * records are formatted with LCBLog::formatPacked(), so the text matches
+ * what the logger would have written.
  *
- * @param level Log level of the message to evaluate.
- * @return True if the message level is equal to or higher than the threshold.
+ * @param in  Binary input; advanced past the record when Decoded.
+ * @param out Receives the text of message records.
+ * @return Outcome; in is left unchanged unless Decoded.
  */
-bool LCBLog::shouldLog(LogLevel level) const
+LogBinaryDecoder::Result LogBinaryDecoder::next(std::string_view &in, std::string &out)
 {
-    return level >= logLevel;
+    std::string_view rest = in;
+    uint32_t len = 0;
+    if (!LogPack::getU32(rest, len) || rest.size() < len)
+    {
+        return NeedMore;
+    }
+    std::string_view record = rest.substr(0, len);
+    if (record.empty())
+    {
+        return Malformed;
+    }
+    const char type = record[0];
+    record.remove_prefix(1);
+
+    if (!sawHeader_ && type != LogPack::RecordHeader)
+    {
+        return Malformed;
+    }
+
+    switch (type)
+    {
+    case LogPack::RecordHeader:
+        // Repeated when several writers share one file
+        if (record.size() != LogPack::magic.size() + 1 ||
+            record.substr(0, LogPack::magic.size()) != LogPack::magic ||
+            static_cast<uint8_t>(record.back()) != LogPack::version)
+        {
+            return Malformed;
+        }
+        sawHeader_ = true;
+        break;
+
+    case LogPack::RecordFormat:
+    {
+        uint32_t id = 0;
+        if (!LogPack::getU32(record, id))
+        {
+            return Malformed;
+        }
+        // IDs are written in order, so an ID may only redefine or append one
+        if (id > formats_.size())
+        {
+            return Malformed;
+        }
+        if (id == formats_.size())
+        {
+            formats_.emplace_back();
+        }
+        formats_[id].assign(record.data(), record.size());
+        break;
+    }
+
+    case LogPack::RecordMessage:
+    {
+        if (record.empty() || static_cast<unsigned char>(record[0]) > FATAL)
+        {
+            return Malformed;
+        }
+        LogLevel level = static_cast<LogLevel>(record[0]);
+        record.remove_prefix(1);
+        const size_t mark = out.size();
+        if (!LCBLog::formatPacked(out, level, record, &formats_))
+        {
+            out.resize(mark);
+            return Malformed;
+        }
+        break;
+    }
+
+    case LogPack::RecordText:
+        out.append(record.data(), record.size());
+        break;
+
+    default:
+        return Malformed;
+    }
+
+    in = rest.substr(len);
+    return Decoded;
 }
 
 /**
- * @brief Generate a UTC timestamp string with millisecond precision.
- *
- * This function retrieves the current system time in UTC, formats it as
- * YYYY-MM-DD HH:MM:SS, appends a three-digit millisecond component, and
- * tags the result with "UTC".
+ * @brief Access the calling thread's reusable output buffer.
  *
- * @return A formatted timestamp string in UTC with millisecond precision.
+ * @return Reference to the thread-local buffer used by format().
  */
-std::string LCBLog::getStamp()
+std::string &LCBLog::formatBuffer()
 {
-    using namespace std::chrono;
-
-    // Retrieve current time point and convert to time_t
-    auto now = system_clock::now();
-    auto now_time_t = system_clock::to_time_t(now);
+    static thread_local std::string buffer;
+    return buffer;
+}
 
-    // Compute milliseconds past the current second
-    auto now_ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
+/**
+ * @brief Access the calling thread's reusable part-joining buffer.
+ *
+ * @return Reference to the thread-local buffer used by formatTo().
+ */
+std::string &LCBLog::combineBuffer()
+{
+    static thread_local std::string buffer;
+    return buffer;
+}
 
-    // Convert to UTC broken-down time
-    std::tm tm{};
-    gmtime_r(&now_time_t, &tm);
+namespace
+{
+    /**
+     * @brief Test for a character matched by the regex class `\s`.
+     *
+     * @param c Character to test.
+     * @return True for space, tab, newline, vertical tab, form feed or
+     * carriage return.
+     */
+    inline bool isCrushSpace(unsigned char c)
+    {
+        return c == ' ' || (c >= '\t' && c <= '\r');
+    }
 
-    // Format date and time, then append milliseconds and UTC label
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%F %T");
-    oss << '.' << std::setfill('0') << std::setw(3) << now_ms.count() << " UTC";
+    /**
+     * @brief Test for a character that absorbs a preceding space.
+     *
+     * @param c Character to test.
+     * @return True for ",.!?:;" and the closing parenthesis.
+     */
+    inline bool isCrushPunct(char c)
+    {
+        switch (c)
+        {
+        case ',':
+        case '.':
+        case '!':
+        case '?':
+        case ':':
+        case ';':
+        case ')':
+            return true;
+        default:
+            return false;
+        }
+    }
 
-    return oss.str();
-}
+    /**
+     * @brief Find the next whitespace character in a range.
+     *
+     * Scans sixteen bytes at a time with SSE2 or NEON when available and
+     * finishes with a scalar loop.
+     *
+     * @param data Pointer to the text.
+     * @param pos  Index to start searching from.
+     * @param len  Length of the text.
+     * @return Index of the first whitespace character, or len if none.
+     */
+    inline size_t findCrushSpace(const char *data, size_t pos, size_t len)
+    {
+#if defined(__SSE2__)
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i tab = _mm_set1_epi8('\t');
+        const __m128i four = _mm_set1_epi8(4);
+        while (pos + 16 <= len)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+            // Bytes in '\t'..'\r' land in 0..4 after subtracting '\t'
+            __m128i ctl = _mm_sub_epi8(v, tab);
+            __m128i isCtl = _mm_cmpeq_epi8(_mm_min_epu8(ctl, four), ctl);
+            __m128i hit = _mm_or_si128(isCtl, _mm_cmpeq_epi8(v, space));
+            int mask = _mm_movemask_epi8(hit);
+            if (mask != 0)
+            {
+                return pos + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+            }
+            pos += 16;
+        }
+#elif defined(__ARM_NEON)
+        const uint8x16_t space = vdupq_n_u8(' ');
+        const uint8x16_t tab = vdupq_n_u8('\t');
+        const uint8x16_t four = vdupq_n_u8(4);
+        while (pos + 16 <= len)
+        {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(data + pos));
+            uint8x16_t hit = vorrq_u8(vceqq_u8(v, space),
+                                      vcleq_u8(vsubq_u8(v, tab), four));
+            // Narrow each byte to a nibble so the mask fits in 64 bits
+            uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(hit), 4);
+            uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+            if (mask != 0)
+            {
+                return pos + static_cast<size_t>(__builtin_ctzll(mask) >> 2);
+            }
+            pos += 16;
+        }
+#endif
+        while (pos < len && !isCrushSpace(static_cast<unsigned char>(data[pos])))
+        {
+            ++pos;
+        }
+        return pos;
+    }
+} // namespace (anonymous)
 
 /**
  * @brief Sanitize a string by normalizing whitespace and punctuation spacing.
@@ -314,25 +5532,63 @@ std::string LCBLog::getStamp()
  */
 void LCBLog::crush(std::string &s)
 {
-    // Trim whitespace from both ends
-    static const std::regex trimRe(R"(^\s+|\s+$)");
-    s = std::regex_replace(s, trimRe, "");
+    s.resize(crushInPlace(&s[0], s.size()));
+}
+
+/**
+ * @brief Normalize a character range in place in a single pass.
+ *
+ * Applies the same rules as crush() without allocating: leading and
+ * trailing whitespace is dropped, each interior whitespace run becomes
+ * one space, and that space is omitted when it follows '(' or precedes
+ * one of ",.!?:;)". Runs without whitespace are copied in bulk.
+ *
+ * @param data Pointer to the first character of the range.
+ * @param len  Number of characters in the range.
+ * @return The length of the normalized text, which starts at data.
+ */
+size_t LCBLog::crushInPlace(char *data, size_t len)
+{
+    size_t r = 0; // Read position
+    size_t w = 0; // Write position
+
+    // Trim leading whitespace
+    while (r < len && isCrushSpace(static_cast<unsigned char>(data[r])))
+    {
+        ++r;
+    }
+
+    while (r < len)
+    {
+        // Copy everything up to the next whitespace character in one move
+        size_t next = findCrushSpace(data, r, len);
+        if (w != r)
+        {
+            std::memmove(data + w, data + r, next - r);
+        }
+        w += next - r;
+        r = next;
 
-    // Collapse multiple whitespace characters into one space
-    static const std::regex wsRe(R"(\s+)");
-    s = std::regex_replace(s, wsRe, " ");
+        // Consume the whole whitespace run
+        while (r < len && isCrushSpace(static_cast<unsigned char>(data[r])))
+        {
+            ++r;
+        }
 
-    // Remove spaces before punctuation characters
-    static const std::regex prePunctRe(R"(\s+([,\.!?:;]))");
-    s = std::regex_replace(s, prePunctRe, "$1");
+        // A run at the end is trailing whitespace; drop it
+        if (r == len)
+        {
+            break;
+        }
 
-    // Remove spaces immediately after an opening parenthesis
-    static const std::regex parenOpenRe(R"(\(\s+)");
-    s = std::regex_replace(s, parenOpenRe, "(");
+        // Keep one space unless punctuation or parentheses absorb it
+        if (data[w - 1] != '(' && !isCrushPunct(data[r]))
+        {
+            data[w++] = ' ';
+        }
+    }
 
-    // Remove spaces immediately before a closing parenthesis
-    static const std::regex parenCloseRe(R"(\s+\))");
-    s = std::regex_replace(s, parenCloseRe, ")");
+    return w;
 }
 
 /**
@@ -354,6 +5610,11 @@ namespace
     {
         (void)&LCBLog::setLogLevel;
         (void)&LCBLog::enableTimestamps;
+        (void)&LCBLog::enableNormalization;
+        (void)&LCBLog::setOverflowPolicy;
+        (void)&LCBLog::droppedCount;
+        (void)&LCBLog::setConfig;
+        (void)&LCBLog::getConfig;
     }
 
     /**
@@ -40,14 +40,40 @@
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <cstdint>
 #include <deque>
+#include <functional>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+/**
+ * @enum LogLevel
+ * @brief Define severity levels for logging.
+ *
+ * This enumeration determines the threshold for message importance
+ * and controls which messages are emitted based on their level.
+ */
+enum LogLevel
+{
+    DEBUG = 0, /**< Debug-level messages for detailed troubleshooting. */
+    INFO,      /**< Informational messages describing normal operation. */
+    WARN,      /**< Warning messages indicating potential issues. */
+    ERROR,     /**< Error messages requiring attention but allowing continued execution. */
+    FATAL      /**< Fatal messages indicating critical errors that terminate the program. */
+};
 
 /**
  * @struct LogEntry
@@ -69,258 +95,2922 @@ struct LogEntry
         Err  /**< Write message to error output. */
     } dest;  /**< Selected destination for this log entry. */
 
-    std::string msg; /**< Formatted text content of the log entry. */
+    LogLevel level = INFO; /**< Severity the message was logged at. */
+    bool packed = false;   /**< Content is a LogPack encoding rather than text. */
+    std::string msg;       /**< Formatted text content of the log entry. */
+    std::shared_ptr<const std::string> shared; /**< Content shared with other sinks' queues; overrides msg. */
+    int64_t stamp = 0;     /**< Monotonic enqueue time in nanoseconds; orders per-thread queues. */
+
+    /**
+     * @brief Return the entry's content, wherever it is held.
+     *
+     * @return View of shared if set, otherwise of msg.
+     */
+    std::string_view text() const
+    {
+        return shared ? std::string_view(*shared) : std::string_view(msg);
+    }
 };
 
 /**
- * @enum LogLevel
- * @brief Define severity levels for logging.
- *
- * This enumeration determines the threshold for message importance
- * and controls which messages are emitted based on their level.
+ * @enum OverflowPolicy
+ * @brief Define what happens when a message arrives at a full queue.
  */
-enum LogLevel
+enum OverflowPolicy
 {
-    DEBUG = 0, /**< Debug-level messages for detailed troubleshooting. */
-    INFO,      /**< Informational messages describing normal operation. */
-    WARN,      /**< Warning messages indicating potential issues. */
-    ERROR,     /**< Error messages requiring attention but allowing continued execution. */
-    FATAL      /**< Fatal messages indicating critical errors that terminate the program. */
+    DropOldest,       /**< Evict the oldest queued message to make room. */
+    DropNewest,       /**< Discard the incoming message. */
+    BlockWithTimeout, /**< Wait for room, then discard the message on timeout. */
+    GrowToCap         /**< Spill into an overflow list bounded by a byte cap. */
 };
 
 /**
- * @brief Converts a log level to its string representation.
+ * @class LogDoorbell
+ * @brief One wakeup shared by every queue that a LogExecutor thread serves.
  *
- * @param level The log level to convert.
- * @return A string representing the log level.
+ * The thread arms the bell, checks its queues once more, and parks on a
+ * futex. Producers ring it after publishing an entry, which costs a
+ * single atomic load unless the thread is parked, so one wakeup covers
+ * any number of queues.
  */
-std::string logLevelToString(LogLevel level);
+class LogDoorbell
+{
+public:
+    /**
+     * @brief Announce that the consumer is about to park.
+     *
+     * The consumer must check for work after arming, then call park() or
+     * disarm().
+     *
+     * @return Ring count to hand to park().
+     */
+    uint32_t arm();
+
+    /**
+     * @brief Sleep until the bell rings after arm() or the timeout elapses.
+     *
+     * @param armed   Value returned by arm().
+     * @param timeout Longest sleep; nanoseconds::max() waits without a limit.
+     */
+    void park(uint32_t armed, std::chrono::nanoseconds timeout);
+
+    /**
+     * @brief Withdraw arm() when work turned up before parking.
+     */
+    void disarm();
+
+    /**
+     * @brief Wake the consumer if it is armed or parked.
+     *
+     * Callers publish their work and issue a sequentially consistent fence
+     * first, as LogRing::notify() does.
+     */
+    void ring();
+
+private:
+    std::atomic<uint32_t> rings_{0};   /**< Futex word; bumped by ring(). */
+    std::atomic<uint32_t> waiters_{0}; /**< Consumers between arm() and the end of park(). */
+};
 
 /**
- * @class LCBLog
- * @brief Provide asynchronous, thread-safe logging with severity filtering.
+ * @class LogRing
+ * @brief Bounded lock-free multi-producer queue of pre-sized log slots.
  *
- * LCBLog manages separate queues and worker threads for standard and error
- * output streams. It supports configurable log levels, optional timestamps,
- * and non-blocking message emission in batch mode.
+ * Each slot carries a sequence number that tells producers and consumers
+ * whose turn it is, so pushing and popping never take a lock. Slot
+ * strings are swapped rather than freed on pop, which lets their
+ * capacity circulate between producers and the worker. Popping is safe
+ * from any thread, so a producer may evict the oldest entry when full.
+ *
+ * The consumer parks on a condition variable only after announcing it is
+ * idle; producers skip the notification entirely while it is running.
+ * A ring served by a LogExecutor rings the executor thread's LogDoorbell
+ * instead.
+ *
+ * An optional overflow list holds entries that arrive while the ring is
+ * full under the GrowToCap policy. It is drained after the ring, and
+ * new entries keep going to it until it is empty so order is preserved.
  */
-class LCBLog
+class LogRing
 {
 public:
     /**
-     * @brief Construct a logger with specified output streams.
+     * @brief Construct a ring holding up to capacity entries.
      *
-     * @param outStream Stream for informational and debug messages.
-     * @param errStream Stream for error and fatal messages.
+     * @param capacity Number of slots; values below one are raised to one.
+     * @param reserve  Bytes preallocated in each slot's message buffer.
      */
-    explicit LCBLog(std::ostream &outStream = std::cout,
-                    std::ostream &errStream = std::cerr);
+    explicit LogRing(size_t capacity, size_t reserve = 0);
+
+    LogRing(const LogRing &) = delete;
+    LogRing &operator=(const LogRing &) = delete;
 
     /**
-     * @brief Destroy the logger, flushing all pending messages.
+     * @brief Copy a message into the next free slot.
      *
-     * Signals worker threads to stop, drains their queues, and joins them
-     * before object destruction.
+     * @param dest   Destination recorded with the entry.
+     * @param level  Severity recorded with the entry.
+     * @param text   Formatted message text or packed arguments.
+     * @param packed True if text is a LogPack encoding.
+     * @param shared Buffer holding text for several queues; when set it is
+     * referenced instead of copying text.
+     * @param stamp  Enqueue time recorded with the entry.
+     * @return True if the entry was queued, false if the ring is full.
      */
-    ~LCBLog();
+    bool tryPush(LogEntry::Destination dest, LogLevel level, std::string_view text, bool packed = false,
+                 const std::shared_ptr<const std::string> &shared = nullptr, int64_t stamp = 0);
 
     /**
-     * @brief Returns the singleton logger instance.
+     * @brief Remove the oldest entry, swapping its contents into out.
      *
-     * Constructs the LCBLog instance on first invocation using the given
-     * output and error streams. Subsequent calls ignore their parameters
-     * and return the same instance.
+     * The overflow list is served only once the ring is empty.
      *
-     * @param out The output stream for standard logs (default: std::cout)
-     * @param err The output stream for error logs (default: std::cerr)
-     * @return Reference to the global LCBLog singleton instance
+     * @param out Receives the entry; its previous buffer returns to the slot.
+     * @return True if an entry was removed, false if the ring is empty.
      */
-    LCBLog &getLogger(std::ostream &out = std::cout,
-                      std::ostream &err = std::cerr);
+    bool tryPop(LogEntry &out);
 
     /**
-     * @brief Returns the singleton logger instance.
-     *
-     * Constructs the LCBLog instance on first invocation using default
-     * output and error streams. Subsequent calls ignore their parameters
-     * and return the same instance.
+     * @brief Discard the oldest entry to make room for a new one.
      *
-     * @param out The output stream for standard logs (default: std::cout)
-     * @param err The output stream for error logs (default: std::cerr)
-     * @return Reference to the global LCBLog singleton instance
+     * @return True if an entry was discarded.
      */
-    LCBLog &getLogger();
+    bool discardOldest();
 
     /**
-     * @brief Set the minimum log level for message output.
+     * @brief Append a message to the overflow list if it fits the byte cap.
      *
-     * Messages below this level are discarded.
+     * @param dest    Destination recorded with the entry.
+     * @param level   Severity recorded with the entry.
+     * @param text    Formatted message text or packed arguments.
+     * @param byteCap Maximum total bytes held in the overflow list.
+     * @param packed  True if text is a LogPack encoding.
+     * @param shared  Buffer holding text for several queues; when set it
+     * is referenced instead of copying text.
+     * @param stamp   Enqueue time recorded with the entry.
+     * @return True if the entry was queued, false if it would exceed the cap.
+     */
+    bool trySpill(LogEntry::Destination dest, LogLevel level, std::string_view text, size_t byteCap,
+                  bool packed = false, const std::shared_ptr<const std::string> &shared = nullptr,
+                  int64_t stamp = 0);
+
+    /**
+     * @brief Check whether the overflow list holds entries.
      *
-     * @param level New threshold for log message severity.
+     * @return True while entries are waiting in the overflow list.
      */
-    void setLogLevel(LogLevel level);
+    bool spilling() const;
 
     /**
-     * @brief Determine if a message meets the current log level threshold.
+     * @brief Wait until a slot may be free or the deadline passes.
      *
-     * @param level Severity level of the message to evaluate.
-     * @return true if the message level is equal to or higher than the threshold.
+     * @param deadline Latest time to keep waiting.
+     * @return False if the deadline passed, true otherwise.
      */
-    bool shouldLog(LogLevel level) const;
+    bool waitForSpace(std::chrono::steady_clock::time_point deadline);
 
     /**
-     * @brief Enable or disable timestamping for each log line.
+     * @brief Count one message lost to overflow.
+     */
+    void recordDrop();
+
+    /**
+     * @brief Return and reset the drops not yet reported by the worker.
      *
-     * When enabled, each line is prefixed with a UTC timestamp.
+     * @return Messages dropped since the previous call.
+     */
+    uint64_t takeDropped();
+
+    /**
+     * @brief Return the total number of messages dropped by this queue.
      *
-     * @param enable True to include timestamps, false to omit them.
+     * @return Cumulative drop count.
      */
-    void enableTimestamps(bool enable);
+    uint64_t droppedTotal() const;
 
     /**
-     * @brief Enqueue a formatted log message.
+     * @brief Check whether any published entry is waiting.
      *
-     * This template formats the provided arguments into a single message
-     * and dispatches it to the appropriate worker queue without blocking.
+     * @return True if neither the ring nor the overflow list holds an entry
+     * that tryPop() can take.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Return the approximate number of queued entries.
      *
-     * @tparam Args Types of the components to format.
-     * @param level Severity level of the message.
-     * @param args Components of the message to log.
+     * @return Entries claimed by producers and not yet popped.
      */
-    template <typename... Args>
-    void log(LogLevel level, Args &&...args);
+    size_t size() const;
 
     /**
-     * @brief Log a message to the info/output queue.
+     * @brief Return the number of entries ever accepted by the ring and
+     * its overflow list.
      *
-     * Convenience wrapper for log() targeting standard output.
+     * Read from the push position, so counting costs producers nothing.
      *
-     * @tparam T Type of the first argument.
-     * @tparam Args Types of any additional arguments.
-     * @param level Severity level of the message.
-     * @param t First part of the message.
-     * @param args Remaining parts of the message.
+     * @return Cumulative accepted entries, including ones later evicted.
      */
-    template <typename T, typename... Args>
-    void logS(LogLevel level, T &&t, Args &&...args);
+    uint64_t pushedTotal() const;
 
     /**
-     * @brief Log a message to the error queue.
+     * @brief Return the number of entries ever removed from the ring and
+     * its overflow list, by the consumer or by eviction.
      *
-     * Convenience wrapper for log() targeting error output.
+     * May briefly lag a concurrent spill, never lead it, so it is safe to
+     * compare against an earlier pushedTotal().
      *
-     * @tparam T Type of the first argument.
-     * @tparam Args Types of any additional arguments.
-     * @param level Severity level of the message.
-     * @param t First part of the message.
-     * @param args Remaining parts of the message.
+     * @return Cumulative removed entries.
      */
-    template <typename T, typename... Args>
-    void logE(LogLevel level, T &&t, Args &&...args);
-
-private:
-    LogLevel logLevel;            /**< Threshold for message filtering. */
-    std::ostream &out;            /**< Stream for non-error messages. */
-    std::ostream &err;            /**< Stream for error messages. */
-    bool printTimestamps = false; /**< Flag to include timestamps. */
-    std::mutex logMutex;          /**< Protects configuration changes. */
+    uint64_t poppedTotal() const;
 
     /**
-     * @brief Sanitize a string by normalizing whitespace and punctuation spacing.
+     * @brief Write every published, unpopped text entry to fd.
      *
-     * This method trims leading and trailing whitespace, collapses consecutive
-     * whitespace runs into a single space, removes spaces before common
-     * punctuation characters (comma, period, exclamation, question, semicolon,
-     * colon), and eliminates spaces immediately after '(' or immediately before ')'.
+     * Async-signal-safe: it takes no locks, allocates nothing, and uses
+     * only write(2), so a crash handler may call it. Entries in the
+     * overflow list are not reached.
      *
-     * @param s Reference to the string to be cleaned.
+     * @param fd Destination descriptor.
+     * @return Packed entries skipped because they need formatting.
      */
-    static void crush(std::string &s); /**< Clean up whitespace and punctuation. */
+    size_t dumpPending(int fd) const;
 
     /**
-     * @brief Generate a UTC timestamp string with millisecond precision.
-     *
-     * This function retrieves the current system time in UTC, formats it as
-     * YYYY-MM-DD HH:MM:SS, appends a three-digit millisecond component, and
-     * tags the result with "UTC".
+     * @brief Return the fixed slot count.
      *
-     * @return A formatted timestamp string in UTC with millisecond precision.
+     * @return Maximum number of entries the ring can hold.
      */
-    std::string getStamp(); /**< Generate a UTC timestamp string. */
+    size_t capacity() const { return capacity_; }
 
     /**
-     * @brief Format log message components and write to an output stream.
+     * @brief Return the bytes preallocated in each slot.
      *
-     * This template converts each argument to a string, applies spacing logic,
-     * splits on line breaks, applies optional timestamps and log level tags,
-     * and writes each line to the provided stream.
+     * @return Reserve given at construction.
+     */
+    size_t slotReserve() const { return reserve_; }
+
+    /**
+     * @brief Lower the number of entries accepted before the ring is full.
      *
-     * @tparam T   Type of the first message component.
-     * @tparam Args Types of any additional components.
-     * @param stream Output stream for formatted log text.
-     * @param level Severity level of the message.
-     * @param t     First component of the message.
-     * @param args  Remaining components of the message.
+     * @param limit Entry limit, clamped to the range 1..capacity().
      */
-    template <typename T, typename... Args>
-    void logToStream(std::ostream &stream,
-                     LogLevel level,
-                     T &&t,
-                     Args &&...args);
+    void setLimit(size_t limit);
 
-    std::deque<std::unique_ptr<LogEntry>> outQueue_; /**< Queue for standard output. */
-    std::deque<std::unique_ptr<LogEntry>> errQueue_; /**< Queue for error output. */
-    std::mutex outMtx_;                              /**< Protects outQueue_. */
-    std::mutex errMtx_;                              /**< Protects errQueue_. */
-    std::condition_variable outCv_;                  /**< Notifies outWorker_. */
-    std::condition_variable errCv_;                  /**< Notifies errWorker_. */
+    /**
+     * @brief Route wakeups to a shared bell instead of the ring's own
+     * condition variable.
+     *
+     * Must be set before producers start.
+     *
+     * @param bell Bell of the executor thread consuming this ring.
+     */
+    void setDoorbell(LogDoorbell *bell) { doorbell_ = bell; }
 
-    std::thread outWorker_;         /**< Worker for standard output. */
-    std::thread errWorker_;         /**< Worker for error output. */
-    std::atomic<bool> done_{false}; /**< Signal to stop worker loops. */
+    /**
+     * @brief Wake the consumer if it is parked.
+     *
+     * Costs a single atomic load when the consumer is already running.
+     */
+    void notify();
 
-    const size_t maxQueueSize_ = 1024;                   /**< Max messages in queue (discards oldest). */
-    const size_t batchSize_ = 16;                        /**< Messages per flush. */
-    const std::chrono::milliseconds flushInterval_{200}; /**< Flush interval. */
+    /**
+     * @brief Wake the consumer unconditionally, for example on shutdown.
+     */
+    void notifyAll();
 
     /**
-     * @brief Processes queued log entries in batches on a background thread.
+     * @brief Park the consumer until an entry arrives, stop is set, or the
+     * timeout elapses.
      *
-     * This loop waits for new entries or a timeout, moves up to batchSize_
-     * messages into a local buffer, writes them to the output stream, and
-     * flushes when the batch is full or the flush interval has elapsed.
-     *
-     * @param queue Reference to the deque holding pending log entries.
-     * @param mtx Reference to the mutex protecting the queue.
-     * @param cv Reference to the condition variable for queue notifications.
-     * @param stream Reference to the output stream where log messages are written.
+     * @param timeout Maximum time to wait.
+     * @param stop    Flag that ends the wait early when set.
+     * @param ready   Extra wake condition, such as work in other queues
+     * whose producers call notify() on this ring; may be empty.
+     */
+    void wait(std::chrono::milliseconds timeout, const std::atomic<bool> &stop,
+              const std::function<bool()> &ready = nullptr);
+
+private:
+    /**
+     * @struct Slot
+     * @brief One queue cell, aligned to keep neighbours off its cache line.
      */
-    void workerLoop(std::deque<std::unique_ptr<LogEntry>> &queue,
-                    std::mutex &mtx,
-                    std::condition_variable &cv,
-                    std::ostream &stream);
+    struct alignas(64) Slot
+    {
+        std::atomic<size_t> seq; /**< Turn marker for producers and consumers. */
+        LogEntry entry;          /**< Payload stored in this cell. */
+    };
+
+    const size_t capacity_;         /**< Number of slots. */
+    const size_t reserve_;          /**< Bytes preallocated per slot. */
+    std::unique_ptr<Slot[]> slots_; /**< Slot storage. */
+    std::atomic<size_t> limit_;     /**< Entries accepted before full. */
+
+    alignas(64) std::atomic<size_t> head_{0}; /**< Next position to push. */
+    alignas(64) std::atomic<size_t> tail_{0}; /**< Next position to pop. */
+
+    alignas(64) std::atomic<bool> sleeping_{false}; /**< Consumer is parked. */
+    std::mutex waitMtx_;                            /**< Pairs with waitCv_. */
+    std::condition_variable waitCv_;                /**< Parks the consumer. */
+    LogDoorbell *doorbell_ = nullptr;               /**< Replaces waitCv_ when set. */
+
+    std::atomic<int> blocked_{0};     /**< Producers waiting for space. */
+    std::mutex spaceMtx_;             /**< Pairs with spaceCv_. */
+    std::condition_variable spaceCv_; /**< Parks blocked producers. */
+
+    std::atomic<size_t> spillCount_{0}; /**< Entries in the overflow list. */
+    std::mutex spillMtx_;               /**< Protects spill_ and spillBytes_. */
+    std::deque<LogEntry> spill_;        /**< Overflow list for GrowToCap. */
+    size_t spillBytes_ = 0;             /**< Bytes held in spill_. */
+    std::atomic<uint64_t> spilledTotal_{0}; /**< Entries ever added to spill_. */
+
+    std::atomic<uint64_t> dropped_{0};      /**< Drops not yet reported. */
+    std::atomic<uint64_t> droppedTotal_{0}; /**< Drops since construction. */
 };
 
 /**
- * @brief Determine if a space should be omitted between two tokens.
+ * @def LCBLOG_MIN_LEVEL
+ * @brief Lowest level compiled into the program (0 = DEBUG ... 4 = FATAL).
  *
- * This free function returns true when the next token is empty or
- * starts with punctuation, or when the previous token ends with
- * whitespace. It returns false if a space is required before a word.
+ * Messages below this level are rejected at compile time and never
+ * reach setLogLevel() filtering. Set it with -DLCBLOG_MIN_LEVEL=1 (or a
+ * level name such as INFO) to strip DEBUG logging from a build.
+ */
+#ifndef LCBLOG_MIN_LEVEL
+#define LCBLOG_MIN_LEVEL 0
+#endif
+
+/**
+ * @brief Compile-time floor derived from LCBLOG_MIN_LEVEL.
+ */
+constexpr LogLevel lcblogMinLevel = static_cast<LogLevel>(LCBLOG_MIN_LEVEL);
+
+/**
+ * @brief Check at compile time whether a level survives LCBLOG_MIN_LEVEL.
  *
- * @tparam PrevT Type of the previous token.
- * @tparam T     Type of the next token.
- * @param prevArg Previous token string.
- * @param arg     Next token string.
- * @return True if no space should be added, false otherwise.
+ * @param level Level to test.
+ * @return True if messages at level are compiled in.
  */
-template <typename PrevT, typename T>
-bool shouldSkipSpace(const PrevT &prev, const T &curr);
+constexpr bool lcblogCompiledIn(LogLevel level)
+{
+    return level >= lcblogMinLevel;
+}
 
-#include "lcblog.tpp"
+/**
+ * @brief Converts a log level to its string representation.
+ *
+ * @param level The log level to convert.
+ * @return A string representing the log level.
+ */
+std::string logLevelToString(LogLevel level);
 
-LCBLog &getLogger();
+/**
+ * @enum TimestampPrecision
+ * @brief Define the sub-second resolution printed in timestamps.
+ */
+enum TimestampPrecision
+{
+    StampMillis, /**< Three fractional digits, e.g. 12:00:00.123. */
+    StampMicros  /**< Six fractional digits, e.g. 12:00:00.123456. */
+};
 
-#define llog getLogger()
+/**
+ * @enum TimestampClock
+ * @brief Define the clock sampled for timestamps.
+ */
+enum TimestampClock
+{
+    ClockRealtime,      /**< CLOCK_REALTIME: precise wall-clock time. */
+    ClockRealtimeCoarse /**< CLOCK_REALTIME_COARSE: cheaper, tick resolution. */
+};
+
+/**
+ * @enum KVFormat
+ * @brief Encoding used by LCBLog::logKV().
+ */
+enum KVFormat
+{
+    KVLogfmt, /**< key=value pairs separated by spaces. */
+    KVJson    /**< One JSON object per line (JSON Lines). */
+};
+
+/**
+ * @struct LogStamp
+ * @brief Wall-clock time captured once for a message.
+ */
+struct LogStamp
+{
+    int64_t sec = 0;  /**< Seconds since the Unix epoch. */
+    int32_t nsec = 0; /**< Nanoseconds past sec. */
+};
+
+/**
+ * @struct LogStyle
+ * @brief Line formatting options fixed at the moment a message is logged.
+ *
+ * Captured on the calling thread so that a message formatted later, on
+ * the worker or by a decoder, looks exactly as if it had been formatted
+ * immediately.
+ */
+struct LogStyle
+{
+    LogStamp stamp;                             /**< Time the message was logged. */
+    bool timestamps = false;                    /**< Prefix each line with stamp. */
+    bool normalize = true;                      /**< Apply crush() to each line. */
+    TimestampPrecision precision = StampMillis; /**< Fractional digits in stamp. */
+};
+
+/**
+ * @struct BorrowedArg
+ * @brief String component whose storage the caller keeps alive.
+ *
+ * In deferred mode only the pointer and length are queued, so the text
+ * must outlive the write to the sink. Create with borrow().
+ */
+struct BorrowedArg
+{
+    std::string_view text; /**< Borrowed characters. */
+};
+
+/**
+ * @brief Pass a string to the logger without copying it in deferred mode.
+ *
+ * @param text Characters that stay valid until the message is written,
+ * such as a string literal or a long-lived table entry.
+ * @return Wrapper recognized by the formatter.
+ */
+inline BorrowedArg borrow(std::string_view text)
+{
+    return BorrowedArg{text};
+}
+
+/**
+ * @struct LogFormat
+ * @brief Constant message text registered once and referred to by ID.
+ *
+ * Obtained from LCBLog::registerFormat(), normally through LCBLOG_F. In
+ * text output it prints as its text; in packed and binary output only
+ * the ID is stored.
+ */
+struct LogFormat
+{
+    uint32_t id = 0;       /**< Index in the process-wide format table. */
+    std::string_view text; /**< Registered text; valid for the process lifetime. */
+};
+
+/**
+ * @struct LogPack
+ * @brief Compact encoding of a message's style and raw arguments.
+ *
+ * Layout: one style byte, the timestamp (8-byte seconds, 4-byte
+ * nanoseconds), then one tagged value per argument. Integers are stored
+ * little-endian. Deferred formatting queues this encoding and the worker
+ * turns it into text with LCBLog::formatPacked().
+ */
+struct LogPack
+{
+    /**
+     * @enum Tag
+     * @brief Leading byte that identifies each packed argument.
+     */
+    enum Tag : char
+    {
+        Int = 'i',      /**< Signed integer, 8 bytes. */
+        Uint = 'u',     /**< Unsigned integer, 8 bytes. */
+        Float = 'd',    /**< IEEE double, 8 bytes. */
+        Char = 'c',     /**< Single character, 1 byte. */
+        Bool = 'b',     /**< Boolean, 1 byte. */
+        Null = 'n',     /**< nullptr, no payload. */
+        Pointer = 'p',  /**< Address, 8 bytes. */
+        Text = 's',     /**< 4-byte length, then the characters. */
+        Borrowed = 'v', /**< 8-byte address and 8-byte length of borrowed text. */
+        Format = 'f'    /**< 4-byte LogFormat ID. */
+    };
+
+    /**
+     * @enum RecordType
+     * @brief Leading byte of each record in the binary file format.
+     *
+     * Every record is a 4-byte little-endian length followed by that many
+     * bytes, starting with the record type.
+     */
+    enum RecordType : char
+    {
+        RecordHeader = 'H',  /**< Magic text and format version. */
+        RecordFormat = 'F',  /**< 4-byte ID, then the format text. */
+        RecordMessage = 'M', /**< 1-byte level, then a LogPack encoding. */
+        RecordText = 'T'     /**< Already formatted text, written verbatim. */
+    };
+
+    /**
+     * @struct Arg
+     * @brief One decoded argument.
+     */
+    struct Arg
+    {
+        Tag tag = Null;        /**< Kind of value. */
+        uint64_t raw = 0;      /**< Numeric payload, address, or format ID. */
+        std::string_view text; /**< Payload of Text arguments. */
+    };
+
+    /**
+     * @enum StyleBits
+     * @brief Flags stored in the leading style byte.
+     */
+    enum StyleBits : uint8_t
+    {
+        Stamped = 1,    /**< Lines carry a timestamp. */
+        Normalized = 2, /**< Lines pass through crush(). */
+        Micros = 4      /**< Timestamps print microseconds. */
+    };
+
+    static constexpr size_t headerSize = 1 + 8 + 4; /**< Bytes before the first argument. */
+    static constexpr std::string_view magic = "LCBLOG";  /**< Payload of the header record. */
+    static constexpr uint8_t version = 1;                /**< Binary format version. */
+
+    /**
+     * @brief Append a 32-bit value in little-endian order.
+     *
+     * @param buffer Destination buffer.
+     * @param value  Value to append.
+     */
+    static void putU32(std::string &buffer, uint32_t value);
+
+    /**
+     * @brief Append a 64-bit value in little-endian order.
+     *
+     * @param buffer Destination buffer.
+     * @param value  Value to append.
+     */
+    static void putU64(std::string &buffer, uint64_t value);
+
+    /**
+     * @brief Consume a little-endian 32-bit value.
+     *
+     * @param in    Encoded bytes; advanced on success.
+     * @param value Receives the decoded value.
+     * @return False if in is too short.
+     */
+    static bool getU32(std::string_view &in, uint32_t &value);
+
+    /**
+     * @brief Consume a little-endian 64-bit value.
+     *
+     * @param in    Encoded bytes; advanced on success.
+     * @param value Receives the decoded value.
+     * @return False if in is too short.
+     */
+    static bool getU64(std::string_view &in, uint64_t &value);
+
+    /**
+     * @brief Append the style byte and timestamp.
+     *
+     * @param buffer Destination buffer.
+     * @param style  Style to encode.
+     */
+    static void putHeader(std::string &buffer, const LogStyle &style);
+
+    /**
+     * @brief Consume the style byte and timestamp.
+     *
+     * @param in    Encoded bytes; advanced past the header on success.
+     * @param style Receives the decoded style.
+     * @return False if in is too short.
+     */
+    static bool getHeader(std::string_view &in, LogStyle &style);
+
+    /**
+     * @brief Append a Text argument.
+     *
+     * @param buffer Destination buffer.
+     * @param text   Characters to copy.
+     */
+    static void putText(std::string &buffer, std::string_view text);
+
+    /**
+     * @brief Consume one argument.
+     *
+     * @param in  Encoded arguments; advanced past the argument on success.
+     * @param arg Receives the decoded argument.
+     * @return False if the tag is unknown or in is too short.
+     */
+    static bool nextArg(std::string_view &in, Arg &arg);
+};
+
+class LogSink;
+
+/**
+ * @class LogExecutor
+ * @brief A small pool of worker threads shared by any number of loggers.
+ *
+ * By default every logger starts one worker per route. Loggers given the
+ * same executor through LCBLogConfig::executor instead have their routes
+ * served by its threads, each route by one thread for its whole life,
+ * so threads and wakeups no longer grow with the number of loggers. A
+ * thread parks on one LogDoorbell for all the queues it serves.
+ *
+ * @code
+ * auto workers = std::make_shared<LogExecutor>(2);
+ * LCBLogConfig config;
+ * config.executor = workers;
+ * LCBLog net(std::cout, std::cerr, config), disk(std::cout, std::cerr, config);
+ * @endcode
+ */
+class LogExecutor
+{
+public:
+    /**
+     * @struct Task
+     * @brief Work an executor thread services between wakeups.
+     */
+    struct Task
+    {
+        virtual ~Task() = default;
+
+        /**
+         * @brief Do one pass of work.
+         *
+         * @return Longest time before the next pass is due, zero to run
+         * again at once, or negative once the task has finished for good.
+         */
+        virtual std::chrono::nanoseconds run() = 0;
+
+        /**
+         * @brief Check for work without doing it.
+         *
+         * @return True if run() has something to do now.
+         */
+        virtual bool ready() = 0;
+    };
+
+    /**
+     * @brief Start the executor's threads.
+     *
+     * @param threads Number of threads, at least 1.
+     * @param name    Thread name prefix; each thread adds its index.
+     * @throws std::invalid_argument if threads is 0.
+     */
+    explicit LogExecutor(size_t threads = 1, const std::string &name = "lcblog-exec");
+
+    /**
+     * @brief Stop and join the threads.
+     *
+     * Loggers hold a reference to their executor, so none is attached by
+     * the time it is destroyed.
+     */
+    ~LogExecutor();
+
+    LogExecutor(const LogExecutor &) = delete;
+    LogExecutor &operator=(const LogExecutor &) = delete;
+
+    /**
+     * @brief Return the number of threads.
+     *
+     * @return Thread count given at construction.
+     */
+    size_t threads() const { return lanes_.size(); }
+
+    /**
+     * @brief Check whether the caller is one of this executor's threads.
+     *
+     * @return True on an executor thread.
+     */
+    bool onExecutorThread() const;
+
+    /**
+     * @brief Hand a task to the thread serving the fewest tasks.
+     *
+     * The task runs until run() reports that it has finished.
+     *
+     * @param task Task to serve; must outlive its run.
+     * @return Bell of the thread now serving the task.
+     */
+    LogDoorbell &add(Task &task);
+
+    /**
+     * @brief Block until a task has finished and no thread refers to it.
+     *
+     * @param task Task passed to add().
+     */
+    void wait(Task &task);
+
+private:
+    /**
+     * @struct Lane
+     * @brief One executor thread with the tasks it serves.
+     */
+    struct Lane
+    {
+        std::thread thread;                /**< Runs laneLoop(). */
+        LogDoorbell bell;                  /**< Wakes the thread. */
+        std::vector<Task *> tasks;         /**< Tasks served; guarded by mtx_. */
+        std::atomic<uint64_t> version{0};  /**< Bumped whenever tasks changes. */
+    };
+
+    /**
+     * @brief Serve a lane's tasks until the executor stops.
+     *
+     * @param lane  Lane to serve.
+     * @param index Position of the lane, used in the thread name.
+     * @param name  Thread name prefix.
+     */
+    void laneLoop(Lane &lane, size_t index, std::string name);
+
+    std::vector<std::unique_ptr<Lane>> lanes_; /**< Fixed at construction. */
+    std::mutex mtx_;                           /**< Guards every lane's tasks. */
+    std::condition_variable finished_;         /**< Signaled when a task is removed. */
+    std::atomic<bool> stop_{false};            /**< Ends laneLoop(). */
+};
+
+/**
+ * @struct LCBLogConfig
+ * @brief Tuning parameters for queueing, batching, and overflow handling.
+ *
+ * Pass to the LCBLog constructor or getLogger() to size a logger, and to
+ * LCBLog::setConfig() to retune a live one. Defaults match the original
+ * fixed values.
+ */
+struct LCBLogConfig
+{
+    size_t queueCapacity = 1024;                       /**< Max messages per queue. */
+    size_t batchSize = 16;                             /**< Messages written per flush. */
+    std::chrono::milliseconds flushInterval{200};      /**< Longest wait before a flush. */
+    OverflowPolicy overflowPolicy = DropOldest;        /**< Behavior when a queue is full. */
+    std::chrono::milliseconds blockTimeout{100};       /**< Wait limit for BlockWithTimeout. */
+    size_t overflowByteCap = 16 * 1024 * 1024;         /**< Spill limit for GrowToCap. */
+    TimestampPrecision timestampPrecision = StampMillis; /**< Sub-second digits in stamps. */
+    TimestampClock timestampClock = ClockRealtime;       /**< Clock sampled for stamps. */
+    bool deferredFormatting = false;                     /**< Queue raw arguments; format on the worker. */
+    bool binaryFormat = false;                           /**< Write binary records instead of text. */
+    KVFormat kvFormat = KVLogfmt;                        /**< Encoding for logKV() records. */
+    bool perThreadQueues = false;                        /**< Give each producer thread its own queue. */
+    size_t threadQueueCapacity = 256;                    /**< Max messages per producer thread queue. */
+    bool collapseRepeats = false;                        /**< Fold runs of identical messages into a count. */
+    std::chrono::milliseconds statsInterval{0};          /**< Period of the stats self-report; 0 disables it. */
+    std::shared_ptr<LogSink> statsSink;                  /**< Sink for the self-report; null logs it at INFO. */
+    std::chrono::milliseconds shutdownTimeout{0};        /**< Drain limit in the destructor; 0 waits for all. */
+    bool crashHandler = false;                           /**< Dump queued entries on SIGSEGV, SIGABRT, SIGBUS. */
+    size_t slotReserve = 128;                            /**< Bytes preallocated per queue slot; fixed at construction. */
+    std::vector<int> workerCpus;                         /**< Cores workers may run on; empty leaves affinity alone. */
+    int workerNice = 0;                                  /**< Nice value for workers; 0 leaves it alone. */
+    int workerRealtimePriority = 0;                      /**< SCHED_FIFO priority 1-99 for workers; 0 keeps the default policy. */
+    std::string threadName;                              /**< Prefix of worker thread names; empty (the default) leaves them unnamed. */
+    std::chrono::microseconds workerSpin{0};             /**< Longest poll of an idle worker before it parks; 0 parks at once. */
+    std::shared_ptr<LogExecutor> executor;               /**< Shared threads serving the routes; null starts one per route. Fixed at construction. */
+
+    /**
+     * @brief Check that every field holds a usable value.
+     *
+     * @throws std::invalid_argument naming the first offending field.
+     */
+    void validate() const;
+};
+
+/**
+ * @struct LazyArg
+ * @brief Wrap a callable whose result is formatted only if the message is kept.
+ *
+ * Create with lazy(). The callable runs after the level check passes,
+ * while the message is formatted, so filtered-out messages never pay for
+ * building their payload. The callable is held mutable, so a mutable
+ * lambda can be called even though the formatter only sees the wrapper
+ * through a const reference.
+ *
+ * @tparam F Callable type taking no arguments.
+ */
+template <typename F>
+struct LazyArg
+{
+    mutable F fn; /**< Producer of the value to format. */
+};
+
+/**
+ * @brief Defer evaluation of an expensive message component.
+ *
+ * @code
+ * llog.logS(DEBUG, "state:", lazy([&] { return dumpState(); }));
+ * @endcode
+ *
+ * @tparam F Callable type taking no arguments.
+ * @param fn Callable returning any type logS() accepts.
+ * @return Wrapper recognized by the formatter.
+ */
+template <typename F>
+LazyArg<std::decay_t<F>> lazy(F &&fn)
+{
+    return LazyArg<std::decay_t<F>>{std::forward<F>(fn)};
+}
+
+/**
+ * @struct KV
+ * @brief One named field of a structured log record.
+ *
+ * Create with kv(). Holds a reference to the value, so it must be used
+ * within the statement that creates it, as logKV() calls are.
+ *
+ * @tparam T Type of the value.
+ */
+template <typename T>
+struct KV
+{
+    std::string_view key; /**< Field name. */
+    const T &value;       /**< Field value. */
+};
+
+/**
+ * @brief Name a value for logKV().
+ *
+ * @code
+ * llog.logKV(INFO, "request done", kv("user", id), kv("latency_us", t));
+ * @endcode
+ *
+ * @tparam T Type of the value.
+ * @param key   Field name.
+ * @param value Field value: a string, number, bool, nullptr, lazy(), or
+ * anything logS() accepts (written as a string).
+ * @return Field recognized by logKV().
+ */
+template <typename T>
+KV<T> kv(std::string_view key, const T &value)
+{
+    return KV<T>{key, value};
+}
+
+/**
+ * @struct LogEntrySpan
+ * @brief Read-only view of consecutive log entries.
+ *
+ * Stands in for std::span<const LogEntry>, which needs C++20.
+ */
+struct LogEntrySpan
+{
+    const LogEntry *data = nullptr; /**< First entry. */
+    size_t count = 0;               /**< Number of entries. */
+
+    const LogEntry *begin() const { return data; }
+    const LogEntry *end() const { return data + count; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const LogEntry &operator[](size_t i) const { return data[i]; }
+};
+
+/**
+ * @class LogSink
+ * @brief Destination for batches of finished log output.
+ *
+ * Each worker hands its sink one batch at a time. By then every entry's
+ * text() is the exact bytes to write: formatted text, or binary records
+ * when binary output is enabled. Sinks may be shared by several loggers
+ * or workers, so implementations serialize their own writes.
+ */
+class LogSink
+{
+public:
+    virtual ~LogSink() = default;
+
+    /**
+     * @brief Write a batch of entries.
+     *
+     * Called on a worker thread, never by producers, so blocking here only
+     * delays this sink's queue.
+     *
+     * @param entries Entries to write, oldest first.
+     */
+    virtual void write(LogEntrySpan entries) = 0;
+
+    /**
+     * @brief Push out anything the sink is holding back.
+     *
+     * Called when the queue goes idle, after urgent entries, and at
+     * shutdown.
+     */
+    virtual void flush() {}
+
+    /**
+     * @brief Return a descriptor the crash handler may write raw text to.
+     *
+     * Only sinks whose output is unbuffered bytes on a descriptor should
+     * return one, so dumped entries land after everything already written.
+     *
+     * @return Descriptor, or -1 if queued entries cannot be dumped here.
+     */
+    virtual int crashFd() const { return -1; }
+};
+
+/**
+ * @class StreamSink
+ * @brief Sink that writes to a std::ostream.
+ *
+ * For std::cout, std::cerr and std::clog the batch goes straight to the
+ * underlying file descriptor in one writev(2); other streams get one
+ * write per entry and a flush per batch.
+ */
+class StreamSink : public LogSink
+{
+public:
+    /**
+     * @brief Wrap a stream.
+     *
+     * @param stream Stream to write; must outlive the sink.
+     */
+    explicit StreamSink(std::ostream &stream);
+
+    void write(LogEntrySpan entries) override;
+    int crashFd() const override { return fd_; }
+
+private:
+    std::ostream &stream_;           /**< Destination stream. */
+    const int fd_;                   /**< Descriptor behind a standard stream, or -1. */
+    std::vector<struct iovec> iov_;  /**< Reused scatter list. */
+    std::mutex mtx_;                 /**< Serializes writers. */
+};
+
+/**
+ * @class FdSink
+ * @brief Sink that writes to a raw file descriptor.
+ *
+ * Each batch is written with writev(2), retrying partial writes and
+ * EINTR.
+ */
+class FdSink : public LogSink
+{
+public:
+    /**
+     * @brief Wrap a file descriptor.
+     *
+     * @param fd    Descriptor open for writing.
+     * @param owned Close fd when the sink is destroyed.
+     */
+    explicit FdSink(int fd, bool owned = false);
+    ~FdSink() override;
+
+    FdSink(const FdSink &) = delete;
+    FdSink &operator=(const FdSink &) = delete;
+
+    void write(LogEntrySpan entries) override;
+    int crashFd() const override { return fd_; }
+
+private:
+    int fd_;                        /**< Destination descriptor. */
+    bool owned_;                    /**< Close fd_ on destruction. */
+    std::vector<struct iovec> iov_; /**< Reused scatter list. */
+    std::mutex mtx_;                /**< Serializes writers. */
+};
+
+/**
+ * @class FileSink
+ * @brief Sink that appends to a file through a user-space buffer.
+ *
+ * Output collects in a buffer and reaches the file when the buffer
+ * fills or flush() is called, so bursts cost few system calls.
+ */
+class FileSink : public LogSink
+{
+public:
+    /**
+     * @brief Open path for appending, creating it if needed.
+     *
+     * @param path       File to write.
+     * @param bufferSize Bytes held before writing to the file.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    explicit FileSink(const std::string &path, size_t bufferSize = 64 * 1024);
+    ~FileSink() override;
+
+    FileSink(const FileSink &) = delete;
+    FileSink &operator=(const FileSink &) = delete;
+
+    void write(LogEntrySpan entries) override;
+    void flush() override;
+
+protected:
+    /**
+     * @brief Buffer bytes, writing the buffer out once it is full.
+     *
+     * Caller must hold mtx_.
+     *
+     * @param bytes Bytes to append.
+     */
+    void append(std::string_view bytes);
+
+    /**
+     * @brief Write the buffer to the file. Caller must hold mtx_.
+     */
+    void writeOut();
+
+    /**
+     * @brief Close the current file and open path_ again. Caller must hold mtx_.
+     *
+     * @return False if the file could not be reopened; output is then
+     * discarded until a later reopen succeeds.
+     */
+    bool reopen();
+
+    const std::string path_;  /**< File being written. */
+    int fd_ = -1;             /**< Open descriptor, or -1. */
+    const size_t bufferSize_; /**< Buffer high-water mark. */
+    std::string buffer_;      /**< Bytes not yet written. */
+    uint64_t fileBytes_ = 0;  /**< Size of the file including buffered bytes. */
+    std::mutex mtx_;          /**< Serializes writers. */
+};
+
+/**
+ * @class RotatingFileSink
+ * @brief File sink that starts a new file by size or age.
+ *
+ * When the next entry would take the file past maxBytes, or the file is
+ * older than maxAge, it is renamed to path.1 (shifting older files up to
+ * path.keep, and removing the oldest) and a fresh file is opened. This
+ * runs on the worker thread inside write(), so producers never wait on
+ * it.
+ *
+ * A rotated file in binary format does not repeat the header and format
+ * records, so binary output should use a plain FileSink.
+ */
+class RotatingFileSink : public FileSink
+{
+public:
+    /**
+     * @brief Open path, rotating by size and optionally by age.
+     *
+     * @param path       File to write.
+     * @param maxBytes   Largest file size before rotating; 0 for no limit.
+     * @param maxAge     Longest time to keep one file; 0 for no limit.
+     * @param keep       Number of rotated files to retain.
+     * @param bufferSize Bytes held before writing to the file.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    RotatingFileSink(const std::string &path, uint64_t maxBytes,
+                     std::chrono::seconds maxAge = std::chrono::seconds(0),
+                     unsigned keep = 5, size_t bufferSize = 64 * 1024);
+
+    void write(LogEntrySpan entries) override;
+
+private:
+    /**
+     * @brief Shift older files up and start a new one. Caller must hold mtx_.
+     */
+    void rotate();
+
+    const uint64_t maxBytes_;                    /**< Size limit, or 0. */
+    const std::chrono::seconds maxAge_;          /**< Age limit, or 0. */
+    const unsigned keep_;                        /**< Rotated files retained. */
+    std::chrono::steady_clock::time_point opened_; /**< When the current file was started. */
+};
+
+/**
+ * @class UringFileSink
+ * @brief File sink that writes through io_uring without waiting on the disk.
+ *
+ * Entries are copied into a small set of registered buffers. A full
+ * buffer, or any buffer at flush(), is submitted as a fixed-buffer write
+ * at an explicit file offset, and the worker goes back to draining its
+ * queue while the kernel completes it. The worker waits only when every
+ * buffer is in flight.
+ *
+ * io_uring support is compiled in with `make IO_URING=1`. Without it, or
+ * when the kernel refuses to set up a ring, the sink writes through an
+ * FdSink instead.
+ */
+class UringFileSink : public LogSink
+{
+public:
+    /**
+     * @brief Open path for appending, creating it if needed.
+     *
+     * @param path       File to write.
+     * @param depth      Number of buffers, and so the most writes in flight.
+     * @param bufferSize Bytes per buffer.
+     * @throws std::runtime_error if the file cannot be opened.
+     * @throws std::invalid_argument if depth or bufferSize is zero.
+     */
+    explicit UringFileSink(const std::string &path, unsigned depth = 8, size_t bufferSize = 64 * 1024);
+
+    /**
+     * @brief Submit buffered bytes, wait for every write, and close the file.
+     */
+    ~UringFileSink() override;
+
+    UringFileSink(const UringFileSink &) = delete;
+    UringFileSink &operator=(const UringFileSink &) = delete;
+
+    void write(LogEntrySpan entries) override;
+
+    /**
+     * @brief Submit the partly filled buffer without waiting for it.
+     */
+    void flush() override;
+
+    /**
+     * @brief Report whether writes go through io_uring.
+     *
+     * @return False if the sink fell back to plain writes.
+     */
+    bool usingUring() const;
+
+private:
+    struct Ring;                       /**< io_uring state; empty without IO_URING=1. */
+    std::unique_ptr<Ring> ring_;       /**< Active ring, or null. */
+    std::unique_ptr<FdSink> fallback_; /**< Plain writes when ring_ is null. */
+    std::mutex mtx_;                   /**< Serializes writers. */
+};
+
+/**
+ * @class GzipSink
+ * @brief Sink that compresses output with gzip before handing it on.
+ *
+ * Entries are deflated on the worker thread into one gzip member (frame)
+ * that shares its dictionary across batches. When the worker flushes,
+ * the deflater is synced and the bytes so far go to the inner sink, so a
+ * reader tailing the file can decompress everything up to the last flush
+ * and a truncated file is recoverable to its last sync point. A member
+ * is closed once it has taken in frameBytes of input, and when the sink
+ * is destroyed; gzip tools read the series of members as one file.
+ *
+ * A RotatingFileSink as the inner sink may rotate inside a member, so
+ * rotated files decompress when concatenated in order, not one by one.
+ *
+ * zlib support is compiled in by default when pkg-config finds it; build
+ * with `make ZLIB=0` to leave it out, in which case the constructor
+ * throws. The crash handler does not dump into this sink, since raw text
+ * would corrupt the stream.
+ */
+class GzipSink : public LogSink
+{
+public:
+    /**
+     * @brief Compress into another sink, usually a file sink.
+     *
+     * @param inner      Sink that receives the compressed members.
+     * @param level      zlib compression level, 0 (stored) to 9, or -1
+     * for zlib's default.
+     * @param frameBytes Input bytes after which a member is closed.
+     * @throws std::invalid_argument if inner is null, level is out of
+     * range, or frameBytes is zero.
+     * @throws std::runtime_error if zlib is not compiled in or cannot be
+     * initialized.
+     */
+    explicit GzipSink(std::shared_ptr<LogSink> inner, int level = 6, size_t frameBytes = 1024 * 1024);
+
+    /**
+     * @brief Close the open member and flush the inner sink.
+     */
+    ~GzipSink() override;
+
+    GzipSink(const GzipSink &) = delete;
+    GzipSink &operator=(const GzipSink &) = delete;
+
+    void write(LogEntrySpan entries) override;
+
+    /**
+     * @brief Sync the deflater, hand on the bytes so far, and flush the
+     * inner sink.
+     */
+    void flush() override;
+
+private:
+    /**
+     * @enum Flush
+     * @brief How far compress() pushes out the input it was given.
+     */
+    enum Flush
+    {
+        NoFlush,   /**< Let zlib hold input back for better compression. */
+        SyncFlush, /**< End on a byte boundary a reader can decode up to. */
+        Finish     /**< Close the member with its trailer. */
+    };
+
+    /**
+     * @brief Deflate bytes into the open member. Caller must hold mtx_.
+     *
+     * @param bytes Input to compress.
+     * @param mode  Flush to apply after the input.
+     */
+    void compress(std::string_view bytes, Flush mode);
+
+    /**
+     * @brief Pass the compressed bytes held so far to the inner sink.
+     * Caller must hold mtx_.
+     */
+    void handOn();
+
+    /**
+     * @brief Close the open member and pass it to the inner sink. Caller
+     * must hold mtx_.
+     */
+    void endFrame();
+
+    struct Deflater;                       /**< zlib state; empty without zlib. */
+    std::unique_ptr<Deflater> deflater_;   /**< Compressor for the open member. */
+    const std::shared_ptr<LogSink> inner_; /**< Receives compressed members. */
+    const size_t frameBytes_;              /**< Input limit per member. */
+    size_t frameInput_ = 0;                /**< Input taken into the open member. */
+    bool unsynced_ = false;                /**< Input taken since the last sync. */
+    LogEntry frame_;                       /**< Compressed bytes not yet handed on. */
+    std::mutex mtx_;                       /**< Serializes writers. */
+};
+
+/**
+ * @class MappedRingSink
+ * @brief Flight-recorder sink that keeps the newest output in a mapped file.
+ *
+ * The file holds a fixed-size ring of length-prefixed entries. Writing is
+ * a memory copy into a shared mapping, with no system call, and the page
+ * cache keeps the data when the process is killed. recover() reads the
+ * surviving entries back in order; older entries are overwritten once the
+ * ring is full.
+ *
+ * Reopening an existing ring of the same size continues after its last
+ * entry, so the previous run's history is kept until overwritten. Only
+ * process death is covered: the file is not synced, so a kernel crash or
+ * power loss can still lose recent entries.
+ */
+class MappedRingSink : public LogSink
+{
+public:
+    /**
+     * @brief Open or create a ring file.
+     *
+     * @param path     File to map.
+     * @param dataSize Bytes of log data the ring holds.
+     * @throws std::runtime_error if the file cannot be created or mapped.
+     * @throws std::invalid_argument if dataSize is too small to be useful.
+     */
+    MappedRingSink(const std::string &path, size_t dataSize);
+    ~MappedRingSink() override;
+
+    MappedRingSink(const MappedRingSink &) = delete;
+    MappedRingSink &operator=(const MappedRingSink &) = delete;
+
+    /**
+     * @brief Copy a batch into the ring.
+     *
+     * An entry larger than the ring is cut to fit.
+     *
+     * @param entries Entries to write, oldest first.
+     */
+    void write(LogEntrySpan entries) override;
+
+    /**
+     * @brief Read the entries that survive in a ring file.
+     *
+     * @param path  Ring file written by a MappedRingSink.
+     * @param out   Receives the entries, oldest first.
+     * @param error Receives a description when recovery fails; may be null.
+     * @return False if the file is missing or not a valid ring.
+     */
+    static bool recover(const std::string &path, std::string &out, std::string *error = nullptr);
+
+private:
+    /**
+     * @brief Copy bytes into the ring at an absolute position, wrapping.
+     *
+     * @param pos  Absolute position; reduced modulo the data size.
+     * @param data Bytes to copy.
+     * @param size Number of bytes.
+     */
+    void put(uint64_t pos, const void *data, size_t size);
+
+    /**
+     * @brief Read the length stored at an absolute position.
+     *
+     * @param pos Absolute position of a record.
+     * @return Stored length.
+     */
+    uint32_t lengthAt(uint64_t pos) const;
+
+    void *map_ = nullptr;  /**< Whole-file mapping. */
+    size_t mapSize_ = 0;   /**< Bytes mapped. */
+    char *data_ = nullptr; /**< Start of the ring data. */
+    size_t dataSize_ = 0;  /**< Bytes in the ring. */
+    std::mutex mtx_;       /**< Serializes writers. */
+};
+/**
+ * @struct SocketAddress
+ * @brief A socket peer address and its length.
+ */
+struct SocketAddress
+{
+    struct sockaddr_storage addr{}; /**< Address of any family. */
+    socklen_t size = 0;             /**< Bytes of addr in use. */
+};
+
+/**
+ * @class DatagramSink
+ * @brief Base for sinks that send each entry as one datagram on a
+ * connected socket.
+ *
+ * A batch goes out in as few sendmmsg(2) calls as possible. Subclasses
+ * describe each datagram as a header built in a reused buffer, the
+ * entry's text, and a constant trailer, so message bytes are never
+ * copied in user space. A socket that loses its peer is reconnected and
+ * the send retried once; datagrams that still fail are dropped.
+ */
+class DatagramSink : public LogSink
+{
+public:
+    ~DatagramSink() override;
+
+    DatagramSink(const DatagramSink &) = delete;
+    DatagramSink &operator=(const DatagramSink &) = delete;
+
+    void write(LogEntrySpan entries) override;
+
+protected:
+    /**
+     * @brief Remember the peer and connect to it.
+     *
+     * A peer that is not there yet is retried on every batch.
+     *
+     * @param peer Peer address.
+     */
+    explicit DatagramSink(const SocketAddress &peer);
+
+    /**
+     * @brief Describe the datagram for one entry.
+     *
+     * @param e      Entry being sent.
+     * @param header Buffer to append the bytes sent before the body to.
+     * @param body   The entry's text on entry; may be narrowed.
+     * @return Bytes sent after the body; must have static storage.
+     */
+    virtual std::string_view frame(const LogEntry &e, std::string &header, std::string_view &body) = 0;
+
+private:
+    /**
+     * @brief Open a new socket to the peer, closing the old one.
+     *
+     * @return False if the socket could not be created or connected.
+     */
+    bool reconnect();
+
+    /**
+     * @struct Datagram
+     * @brief Pieces of one datagram, gathered before any are sent.
+     */
+    struct Datagram
+    {
+        size_t headerStart;       /**< Offset of the header in headers_. */
+        size_t headerSize;        /**< Header length. */
+        std::string_view body;    /**< Entry text to send. */
+        std::string_view trailer; /**< Bytes after the body. */
+    };
+
+    int fd_ = -1;                        /**< Connected socket, or -1. */
+    const SocketAddress peer_;           /**< Peer address. */
+    std::string headers_;                /**< Headers of the current batch. */
+    std::vector<Datagram> datagrams_;    /**< Pieces of the current batch. */
+    std::vector<struct iovec> iov_;      /**< Three buffers per datagram. */
+    std::vector<struct mmsghdr> msgs_;   /**< One header per datagram. */
+    std::mutex mtx_;                     /**< Serializes writers. */
+};
+
+/**
+ * @class SyslogSink
+ * @brief Sink that sends RFC 5424 messages to the local syslog socket.
+ *
+ * Each entry becomes one message whose severity comes from its level.
+ * The timestamp is left nil for the daemon to fill in on receipt, and
+ * the trailing newline is dropped.
+ */
+class SyslogSink : public DatagramSink
+{
+public:
+    /**
+     * @brief Connect to a syslog daemon.
+     *
+     * @param appName  APP-NAME field.
+     * @param facility Facility code, 0 to 23; 1 is user-level messages.
+     * @param path     Datagram socket the daemon reads.
+     * @throws std::invalid_argument if facility or path is out of range.
+     */
+    explicit SyslogSink(const std::string &appName = "lcblog", int facility = 1,
+                        const std::string &path = "/dev/log");
+
+protected:
+    std::string_view frame(const LogEntry &e, std::string &header, std::string_view &body) override;
+
+private:
+    std::string prefix_; /**< Fields after the priority, ending in a space. */
+    const int facility_; /**< Facility code. */
+};
+
+/**
+ * @class JournaldSink
+ * @brief Sink that speaks the systemd journal's native protocol.
+ *
+ * Sends PRIORITY, SYSLOG_IDENTIFIER, and MESSAGE fields to the journal
+ * socket, which is what sd_journal_sendv() does, so no libsystemd is
+ * needed. MESSAGE uses the length-prefixed form, so multi-line entries
+ * stay one journal record. Entries larger than the socket allows are
+ * dropped; libsystemd would pass those through a memfd instead.
+ */
+class JournaldSink : public DatagramSink
+{
+public:
+    /**
+     * @brief Connect to the journal.
+     *
+     * @param identifier SYSLOG_IDENTIFIER field.
+     * @param path       Native protocol socket.
+     * @throws std::invalid_argument if path is too long or identifier
+     * contains a newline.
+     */
+    explicit JournaldSink(const std::string &identifier = "lcblog",
+                          const std::string &path = "/run/systemd/journal/socket");
+
+protected:
+    std::string_view frame(const LogEntry &e, std::string &header, std::string_view &body) override;
+
+private:
+    std::string identifier_; /**< SYSLOG_IDENTIFIER value. */
+};
+
+/**
+ * @class UdpSink
+ * @brief Sink that sends each entry as one UDP datagram.
+ *
+ * A batch costs one sendmmsg(2) call. Entries are sent exactly as
+ * formatted; a collector that is down loses them without slowing the
+ * logger.
+ */
+class UdpSink : public DatagramSink
+{
+public:
+    /**
+     * @brief Resolve a collector address.
+     *
+     * @param host Host name or numeric address.
+     * @param port Port number.
+     * @throws std::runtime_error if host cannot be resolved.
+     */
+    UdpSink(const std::string &host, uint16_t port);
+
+protected:
+    std::string_view frame(const LogEntry &e, std::string &header, std::string_view &body) override;
+};
+
+/**
+ * @class TcpSink
+ * @brief Sink that streams entries to a TCP collector.
+ *
+ * A batch is sent with one sendmsg(2) call where possible. If the
+ * connection is down, the sink tries once per batch to reconnect and
+ * drops the batch if that fails, so a dead collector costs one connect
+ * attempt per batch rather than a stalled queue.
+ */
+class TcpSink : public LogSink
+{
+public:
+    /**
+     * @brief Resolve a collector address and try to connect.
+     *
+     * @param host Host name or numeric address.
+     * @param port Port number.
+     * @throws std::runtime_error if host cannot be resolved.
+     */
+    TcpSink(const std::string &host, uint16_t port);
+    ~TcpSink() override;
+
+    TcpSink(const TcpSink &) = delete;
+    TcpSink &operator=(const TcpSink &) = delete;
+
+    void write(LogEntrySpan entries) override;
+
+private:
+    /**
+     * @brief Open a new connection, closing the old one. Caller must hold mtx_.
+     *
+     * @return False if the collector could not be reached.
+     */
+    bool reconnect();
+
+    int fd_ = -1;                   /**< Connected socket, or -1. */
+    const SocketAddress peer_;      /**< Collector address. */
+    std::vector<struct iovec> iov_; /**< Reused scatter list. */
+    std::mutex mtx_;                /**< Serializes writers. */
+};
+
+/**
+ * @struct LogRoute
+ * @brief One entry in a logger's routing table.
+ *
+ * Every message whose level falls within [minLevel, maxLevel] goes to the
+ * sink. Each route has its own queue and worker, so a slow sink delays
+ * only its own messages.
+ */
+struct LogRoute
+{
+    std::shared_ptr<LogSink> sink; /**< Destination for matching messages. */
+    LogLevel minLevel = DEBUG;     /**< Lowest level routed to the sink. */
+    LogLevel maxLevel = FATAL;     /**< Highest level routed to the sink. */
+};
+
+/**
+ * @struct LogQueueStats
+ * @brief Counters for one route, or totals across routes.
+ */
+struct LogQueueStats
+{
+    uint64_t enqueued = 0;                 /**< Messages accepted into queues, including ones later evicted. */
+    uint64_t dropped = 0;                  /**< Messages lost to overflow. */
+    uint64_t written = 0;                  /**< Entries handed to the sink. */
+    uint64_t bytesWritten = 0;             /**< Bytes in those entries. */
+    uint64_t batches = 0;                  /**< Calls to the sink's write(). */
+    uint64_t highWater = 0;                /**< Deepest backlog the worker has seen. */
+    std::chrono::nanoseconds writeTime{0}; /**< Time spent in the sink's write() and flush(). */
+
+    /**
+     * @brief Add another set of counters; highWater keeps the larger.
+     *
+     * @param other Counters to add.
+     * @return This object.
+     */
+    LogQueueStats &operator+=(const LogQueueStats &other);
+};
+
+/**
+ * @struct LogStats
+ * @brief Snapshot returned by LCBLog::stats().
+ */
+struct LogStats
+{
+    std::vector<LogQueueStats> routes; /**< One entry per route, in table order. */
+    LogQueueStats total;               /**< Sum over all routes. */
+};
+
+class LCBLog;
+
+/**
+ * @class LogRateLimit
+ * @brief Token bucket that stops a call site from flooding the queues.
+ *
+ * Implemented as a generic cell rate algorithm: one atomic holds the time
+ * the bucket will next be full, so allow() costs a coarse clock read
+ * and a compare-and-swap, with no lock. Keep one per call site, usually
+ * through LCBLOG_LIMIT. Refusals that no later message reports are
+ * reported by the logger once the limit lets messages through again.
+ */
+class LogRateLimit
+{
+public:
+    /**
+     * @brief Create a limiter.
+     *
+     * @param perSecond Sustained messages allowed per second.
+     * @param burst     Messages allowed at once after a quiet period.
+     * @throws std::invalid_argument if perSecond is not positive or burst is 0.
+     */
+    explicit LogRateLimit(double perSecond, size_t burst = 1);
+
+    /**
+     * @brief Hand any refusals still held to the logger watching this limiter.
+     */
+    ~LogRateLimit();
+
+    LogRateLimit(const LogRateLimit &) = delete;
+    LogRateLimit &operator=(const LogRateLimit &) = delete;
+
+    /**
+     * @brief Take a token if one is available.
+     *
+     * @return True if the message may be logged; false counts it as suppressed.
+     */
+    bool allow();
+
+    /**
+     * @brief Return and reset the number of messages refused since the last call.
+     *
+     * @return Messages suppressed.
+     */
+    uint64_t takeSuppressed();
+
+    /**
+     * @brief Check without taking a token whether allow() would succeed now.
+     *
+     * @return True once the limit window after the last refusal has passed.
+     */
+    bool wouldAllow() const;
+
+private:
+    friend class LCBLog;
+
+    /**
+     * @brief Read the coarse monotonic clock.
+     *
+     * @return Current time in nanoseconds.
+     */
+    static int64_t now();
+
+    const int64_t interval_;               /**< Nanoseconds per token. */
+    const int64_t tolerance_;              /**< Burst allowance in nanoseconds. */
+    std::atomic<int64_t> due_{INT64_MIN};  /**< Theoretical arrival time of the next message. */
+    std::atomic<uint64_t> suppressed_{0};  /**< Refusals not yet reported. */
+    std::atomic<LCBLog *> watcher_{nullptr}; /**< Logger holding the refusals for a later report. */
+};
+
+/**
+ * @struct LogTagState
+ * @brief Threshold and prefix shared by every handle to one tag.
+ *
+ * Owned by the logger, which never moves or frees it while running.
+ */
+struct LogTagState
+{
+    std::string label;                   /**< Prefix written before each message. */
+    std::atomic<LogLevel> level{INFO};   /**< Effective threshold for the tag. */
+    bool pinned = false;                 /**< Level set by name rather than inherited; guarded by logMutex. */
+};
+
+/**
+ * @class LogTag
+ * @brief Handle for logging under a named subsystem with its own level.
+ *
+ * Obtain once with LCBLog::tag() and keep it, for example in a static at
+ * the call site; the level check is then a single atomic load. A tag
+ * follows the logger's level until LCBLog::setTagLevel() gives it its
+ * own. Messages are prefixed with the tag name and a colon. A handle
+ * must not outlive its logger.
+ */
+class LogTag
+{
+public:
+    /**
+     * @brief Check if a message at the given level passes the tag's threshold.
+     *
+     * @param level Severity level of the message to evaluate.
+     * @return true if the level is compiled in and at or above the threshold.
+     */
+    bool shouldLog(LogLevel level) const
+    {
+        return ::lcblogCompiledIn(level) && level >= state_->level.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Log a message under this tag.
+     *
+     * @tparam Args Types of the components to format.
+     * @param level Severity level of the message.
+     * @param args  Components of the message.
+     */
+    template <typename... Args>
+    void log(LogLevel level, Args &&...args);
+
+    /**
+     * @brief Log a message under this tag; see LCBLog::logS().
+     *
+     * @tparam T    Type of the first argument.
+     * @tparam Args Types of any additional arguments.
+     * @param level Severity level of the message.
+     * @param t     First part of the message.
+     * @param args  Remaining parts of the message.
+     */
+    template <typename T, typename... Args>
+    void logS(LogLevel level, T &&t, Args &&...args);
+
+    /**
+     * @brief Log a message under this tag; see LCBLog::logE().
+     *
+     * @tparam T    Type of the first argument.
+     * @tparam Args Types of any additional arguments.
+     * @param level Severity level of the message.
+     * @param t     First part of the message.
+     * @param args  Remaining parts of the message.
+     */
+    template <typename T, typename... Args>
+    void logE(LogLevel level, T &&t, Args &&...args);
+
+    /**
+     * @brief Log a message built by a callable, only if the level passes.
+     *
+     * @tparam F Callable type taking no arguments.
+     * @param level Severity level of the message.
+     * @param fn    Callable returning the message or a value to format.
+     */
+    template <typename F>
+    void logLazy(LogLevel level, F &&fn);
+
+    /**
+     * @brief Log with a registered format; used by LCBLOG_F.
+     *
+     * @tparam T    Type of the literal.
+     * @tparam Args Types of the remaining components.
+     * @param level   Severity level of the message.
+     * @param fmt     Registered form of the literal.
+     * @param literal Original text, ignored.
+     * @param args    Remaining components of the message.
+     */
+    template <typename T, typename... Args>
+    void logF(LogLevel level, const LogFormat &fmt, T &&literal, Args &&...args);
+
+    /**
+     * @brief Log under this tag with a checked format; used by LCBLOG_FMT.
+     *
+     * @tparam Fmt  Type whose static constexpr text() returns the format.
+     * @tparam T    Type of the literal.
+     * @tparam Args Types of the values.
+     * @param level   Severity level of the message.
+     * @param literal Original text, ignored.
+     * @param args    One value per placeholder; see LCBLog::logFmt().
+     */
+    template <typename Fmt, typename T, typename... Args>
+    void logFmt(LogLevel level, T &&literal, Args &&...args);
+
+    /**
+     * @brief Log under this tag if a limiter allows it; see LCBLog::logLimited().
+     *
+     * @tparam Args Types of the components to format.
+     * @param limit Limiter for the call site.
+     * @param level Severity level of the message.
+     * @param args  Components of the message.
+     */
+    template <typename... Args>
+    void logLimited(LogRateLimit &limit, LogLevel level, Args &&...args);
+
+    /**
+     * @brief Return the tag's name.
+     *
+     * @return View of the name, valid while the logger exists.
+     */
+    std::string_view name() const
+    {
+        return std::string_view(state_->label).substr(0, state_->label.size() - 1);
+    }
+
+private:
+    friend class LCBLog;
+
+    LogTag(LCBLog &owner, LogTagState &state) : owner_(&owner), state_(&state) {}
+
+    LCBLog *owner_;       /**< Logger the messages go to. */
+    LogTagState *state_;  /**< Shared threshold and prefix. */
+};
+
+/**
+ * @class LCBLog
+ * @brief Provide asynchronous, thread-safe logging with severity filtering.
+ *
+ * LCBLog manages separate queues and worker threads for standard and error
+ * output streams. It supports configurable log levels, optional timestamps,
+ * and non-blocking message emission in batch mode.
+ */
+class LCBLog
+{
+public:
+    /**
+     * @brief Construct a logger with specified output streams.
+     *
+     * @param outStream Stream for informational and debug messages.
+     * @param errStream Stream for error and fatal messages.
+     * @param config    Queue, batching, and overflow settings.
+     * @throws std::invalid_argument if config fails validation.
+     */
+    explicit LCBLog(std::ostream &outStream = std::cout,
+                    std::ostream &errStream = std::cerr,
+                    const LCBLogConfig &config = LCBLogConfig());
+
+    /**
+     * @brief Construct a logger that writes to sinks.
+     *
+     * The same sink may be passed for both.
+     *
+     * @param outSink Sink for informational and debug messages.
+     * @param errSink Sink for error and fatal messages, or nullptr to
+     * share outSink.
+     * @param config  Queue, batching, and overflow settings.
+     * @throws std::invalid_argument if config fails validation or outSink
+     * is null.
+     */
+    LCBLog(std::shared_ptr<LogSink> outSink, std::shared_ptr<LogSink> errSink,
+           const LCBLogConfig &config = LCBLogConfig());
+
+    /**
+     * @brief Construct a logger that fans messages out through a routing table.
+     *
+     * A message matching several routes is formatted once into a shared
+     * buffer that every matching queue references.
+     *
+     * @param routes Sinks and the levels each one receives.
+     * @param config Queue, batching, and overflow settings; each route
+     * gets a queue of config.queueCapacity.
+     * @throws std::invalid_argument if config fails validation, routes is
+     * empty, a sink is null, or a route's levels are reversed.
+     */
+    explicit LCBLog(const std::vector<LogRoute> &routes,
+                    const LCBLogConfig &config = LCBLogConfig());
+
+    /**
+     * @brief Destroy the logger, flushing all pending messages.
+     *
+     * Signals worker threads to stop, drains their queues, and joins them
+     * before object destruction. With config.shutdownTimeout set, entries
+     * still queued when it expires are counted as dropped, not written.
+     */
+    ~LCBLog();
+
+    /**
+     * @brief Returns the singleton logger instance.
+     *
+     * Constructs the LCBLog instance on first invocation using the given
+     * output and error streams. Subsequent calls ignore their parameters
+     * and return the same instance.
+     *
+     * @param out The output stream for standard logs (default: std::cout)
+     * @param err The output stream for error logs (default: std::cerr)
+     * @return Reference to the global LCBLog singleton instance
+     */
+    LCBLog &getLogger(std::ostream &out = std::cout,
+                      std::ostream &err = std::cerr);
+
+    /**
+     * @brief Returns the singleton logger instance.
+     *
+     * Constructs the LCBLog instance on first invocation using default
+     * output and error streams. Subsequent calls ignore their parameters
+     * and return the same instance.
+     *
+     * @param out The output stream for standard logs (default: std::cout)
+     * @param err The output stream for error logs (default: std::cerr)
+     * @return Reference to the global LCBLog singleton instance
+     */
+    LCBLog &getLogger();
+
+    /**
+     * @brief Set the minimum log level for message output.
+     *
+     * Messages below this level are discarded.
+     *
+     * @param level New threshold for log message severity.
+     */
+    void setLogLevel(LogLevel level);
+
+    /**
+     * @brief Determine if a message meets the current log level threshold.
+     *
+     * Levels below LCBLOG_MIN_LEVEL always fail, so with a constant level
+     * the check and everything behind it is removed by the compiler.
+     *
+     * @param level Severity level of the message to evaluate.
+     * @return true if the message level is equal to or higher than the threshold.
+     */
+    bool shouldLog(LogLevel level) const
+    {
+        return ::lcblogCompiledIn(level) && level >= hot().level;
+    }
+
+    /**
+     * @brief Enable or disable timestamping for each log line.
+     *
+     * When enabled, each line is prefixed with a UTC timestamp.
+     *
+     * @param enable True to include timestamps, false to omit them.
+     */
+    void enableTimestamps(bool enable);
+
+    /**
+     * @brief Enable or disable whitespace normalization of each log line.
+     *
+     * Normalization is on by default. Callers that already send clean text
+     * can turn it off to skip crush() entirely.
+     *
+     * @param enable True to normalize lines, false to emit them verbatim.
+     */
+    void enableNormalization(bool enable);
+
+    /**
+     * @brief Choose how log() behaves when a queue is full.
+     *
+     * @param policy       Overflow policy to apply.
+     * @param blockTimeout Longest wait for room under BlockWithTimeout.
+     * @param byteCap      Overflow list limit in bytes under GrowToCap.
+     * @throws std::invalid_argument if the resulting settings fail validation.
+     */
+    void setOverflowPolicy(OverflowPolicy policy,
+                           std::chrono::milliseconds blockTimeout = std::chrono::milliseconds(100),
+                           size_t byteCap = 16 * 1024 * 1024);
+
+    /**
+     * @brief Read the logger's self-instrumentation counters.
+     *
+     * The counters are relaxed atomics updated by the workers, or derived
+     * from queue positions, so logging pays nothing extra for them.
+     *
+     * @return Per-route counters and their totals.
+     */
+    LogStats stats() const;
+
+    /**
+     * @brief Retune a running logger.
+     *
+     * Batch size, flush interval, and overflow settings apply to the next
+     * worker iteration. The queue capacity may be changed up to the value
+     * the logger was constructed with, since ring storage is fixed.
+     *
+     * @param config New settings.
+     * @throws std::invalid_argument if config fails validation or asks for
+     * more queue capacity than was allocated.
+     */
+    void setConfig(const LCBLogConfig &config);
+
+    /**
+     * @brief Return the settings currently in effect.
+     *
+     * @return Copy of the active configuration.
+     */
+    LCBLogConfig getConfig() const;
+
+    /**
+     * @brief Return the number of messages lost to queue overflow.
+     *
+     * @return Total dropped messages across both queues.
+     */
+    uint64_t droppedCount() const;
+
+    /**
+     * @brief Wait until every message logged before the call is written
+     * and the sinks are flushed.
+     *
+     * Messages logged afterwards do not hold it up: each worker compares
+     * its queue positions against a watermark taken when it sees the
+     * request. Call before fork(), exec(), or an intentional abort.
+     * Returns at once when called from a worker, for example by a sink.
+     */
+    void flush();
+
+    /**
+     * @brief Like flush(), but give up after timeout.
+     *
+     * @param timeout Longest time to wait.
+     * @return True if everything logged before the call was written.
+     */
+    bool flushFor(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Turn a LogPack encoding into log text.
+     *
+     * Produces exactly what format() would have produced for the original
+     * arguments and style.
+     *
+     * @param buffer  Destination for the formatted lines.
+     * @param level   Severity level used for the tag.
+     * @param packed  Encoded style and arguments.
+     * @param formats Format table read from a binary file, or nullptr to
+     * use this process's registered formats. Borrowed arguments are only
+     * accepted with nullptr.
+     * @return False if the encoding is malformed; buffer may then hold a
+     * partial message.
+     */
+    static bool formatPacked(std::string &buffer, LogLevel level, std::string_view packed,
+                             const std::vector<std::string> *formats = nullptr);
+
+    /**
+     * @brief Register constant message text and assign it an ID.
+     *
+     * Intended to run once per call site, as LCBLOG_F does. Binary output
+     * writes each text once and then refers to it by ID.
+     *
+     * @param text Message text; copied into the process-wide table.
+     * @return Handle to pass as a message component.
+     */
+    static LogFormat registerFormat(std::string_view text);
+
+    /**
+     * @brief Sanitize a string by normalizing whitespace and punctuation spacing.
+     *
+     * This method trims leading and trailing whitespace, collapses consecutive
+     * whitespace runs into a single space, removes spaces before common
+     * punctuation characters (comma, period, exclamation, question, semicolon,
+     * colon), and eliminates spaces immediately after '(' or immediately before ')'.
+     *
+     * @param s Reference to the string to be cleaned.
+     */
+    static void crush(std::string &s);
+
+    /**
+     * @brief Normalize a character range in place in a single pass.
+     *
+     * Applies the crush() rules without allocating.
+     *
+     * @param data Pointer to the first character of the range.
+     * @param len  Number of characters in the range.
+     * @return The length of the normalized text, which starts at data.
+     */
+    static size_t crushInPlace(char *data, size_t len);
+
+    /**
+     * @brief Enqueue a formatted log message.
+     *
+     * This template formats the provided arguments into a single message
+     * and dispatches it to the appropriate worker queue without blocking.
+     *
+     * @tparam Args Types of the components to format.
+     * @param level Severity level of the message.
+     * @param args Components of the message to log.
+     */
+    template <typename... Args>
+    void log(LogLevel level, Args &&...args);
+
+    /**
+     * @brief Return a handle for logging under a named tag.
+     *
+     * Creates the tag on first use, following the logger's level. Look a
+     * tag up once and keep the handle; each call takes a lock.
+     *
+     * @param name Subsystem name, written before each of its messages.
+     * @return Handle whose level check is one atomic load.
+     */
+    LogTag tag(std::string_view name);
+
+    /**
+     * @brief Give a tag its own threshold, creating it if needed.
+     *
+     * Takes effect immediately for every handle to the tag, so a running
+     * program can turn on DEBUG for one subsystem.
+     *
+     * @param name  Tag name.
+     * @param level New threshold for the tag.
+     */
+    void setTagLevel(std::string_view name, LogLevel level);
+
+    /**
+     * @brief Make a tag follow the logger's level again.
+     *
+     * @param name Tag name; unknown names are ignored.
+     */
+    void resetTagLevel(std::string_view name);
+
+    /**
+     * @brief Log a message to the info/output queue.
+     *
+     * Convenience wrapper for log() targeting standard output.
+     *
+     * @tparam T Type of the first argument.
+     * @tparam Args Types of any additional arguments.
+     * @param level Severity level of the message.
+     * @param t First part of the message.
+     * @param args Remaining parts of the message.
+     */
+    template <typename T, typename... Args>
+    void logS(LogLevel level, T &&t, Args &&...args);
+
+    /**
+     * @brief Log a message to the error queue.
+     *
+     * Convenience wrapper for log() targeting error output.
+     *
+     * @tparam T Type of the first argument.
+     * @tparam Args Types of any additional arguments.
+     * @param level Severity level of the message.
+     * @param t First part of the message.
+     * @param args Remaining parts of the message.
+     */
+    template <typename T, typename... Args>
+    void logE(LogLevel level, T &&t, Args &&...args);
+
+    /**
+     * @brief Log a message built by a callable, only if the level passes.
+     *
+     * Equivalent to log(level, lazy(fn)).
+     *
+     * @tparam F Callable type taking no arguments.
+     * @param level Severity level of the message.
+     * @param fn    Callable returning the message or a value to format.
+     */
+    template <typename F>
+    void logLazy(LogLevel level, F &&fn);
+
+    /**
+     * @brief Log a structured record of named fields.
+     *
+     * The record is written as one logfmt or JSON line, chosen by
+     * LCBLogConfig::kvFormat, with the timestamp (if enabled), level, and
+     * message first. Values are encoded straight into the output buffer;
+     * crush() and the spacing rules of logS() are not applied, so values
+     * arrive exactly as given. Records are always formatted on the calling
+     * thread; in binary output they are stored as text records.
+     *
+     * @tparam Fields KV field types.
+     * @param level  Severity level of the record.
+     * @param msg    Human-readable message.
+     * @param fields Fields created with kv().
+     */
+    template <typename... Fields>
+    void logKV(LogLevel level, std::string_view msg, const Fields &...fields);
+
+    /**
+     * @brief Log a message if a limiter allows it.
+     *
+     * The limiter is consulted after the level check and before any
+     * formatting. When a message gets through after others were refused,
+     * it is preceded by a line giving the number suppressed.
+     *
+     * @tparam Args Types of the components to format.
+     * @param limit Limiter for the call site.
+     * @param level Severity level of the message.
+     * @param args  Components of the message.
+     */
+    template <typename... Args>
+    void logLimited(LogRateLimit &limit, LogLevel level, Args &&...args);
+
+    /**
+     * @brief Log with a registered format as the first component.
+     *
+     * Used by LCBLOG_F, which passes the original literal alongside its
+     * registration; the literal is not used again.
+     *
+     * @tparam T    Type of the literal.
+     * @tparam Args Types of the remaining components.
+     * @param level   Severity level of the message.
+     * @param fmt     Registered form of the literal.
+     * @param literal Original text, ignored.
+     * @param args    Remaining components of the message.
+     */
+    template <typename T, typename... Args>
+    void logF(LogLevel level, const LogFormat &fmt, T &&literal, Args &&...args);
+
+    /**
+     * @brief Log with a format string parsed and checked at compile time.
+     *
+     * Used by LCBLOG_FMT, which wraps the literal in a type. Each {} is
+     * replaced by the next argument, converted as logS() converts it, and
+     * {{ and }} stand for literal braces. Literal text is kept exactly, so
+     * no spacing rules run; the result is split into lines, stamped, and
+     * tagged like any other message. It is always formatted on the
+     * calling thread.
+     *
+     * @tparam Fmt  Type whose static constexpr text() returns the format.
+     * @tparam T    Type of the literal.
+     * @tparam Args Types of the values.
+     * @param level   Severity level of the message.
+     * @param literal Original text, ignored.
+     * @param args    One value per placeholder.
+     */
+    template <typename Fmt, typename T, typename... Args>
+    void logFmt(LogLevel level, T &&literal, Args &&...args);
+
+    /**
+     * @brief Format a message exactly as it would be logged.
+     *
+     * The text is built in a buffer owned by the calling thread, which is
+     * reused across calls so that steady-state formatting does not allocate.
+     *
+     * @tparam Args Types of the message components.
+     * @param level Severity level of the message.
+     * @param args  Components of the message.
+     * @return View of the formatted text, valid until the next call to
+     * format() on the same thread.
+     */
+    template <typename... Args>
+    std::string_view format(LogLevel level, Args &&...args);
+
+private:
+    /**
+     * @struct HotConfig
+     * @brief Settings read on every log call, small enough to load and
+     * store as one lock-free word.
+     *
+     * Writers hold logMutex and replace the whole value, so readers see
+     * either the old settings or the new ones, never a mix.
+     */
+    struct HotConfig
+    {
+        HotConfig()
+            : level(INFO), precision(StampMillis), clock(ClockRealtime), kvFormat(KVLogfmt),
+              overflowPolicy(DropOldest), timestamps(false), normalize(true), deferred(false),
+              binary(false), perThread(false), collapse(false)
+        {
+        }
+
+        LogLevel level : 8;                /**< Threshold for message filtering. */
+        TimestampPrecision precision : 8;  /**< Sub-second digits in stamps. */
+        TimestampClock clock : 8;          /**< Clock sampled for stamps. */
+        KVFormat kvFormat : 8;             /**< Encoding for logKV(). */
+        OverflowPolicy overflowPolicy : 8; /**< Behavior when a queue is full. */
+        bool timestamps : 1;               /**< Include timestamps. */
+        bool normalize : 1;                /**< Apply crush() to each line. */
+        bool deferred : 1;                 /**< Queue packed arguments. */
+        bool binary : 1;                   /**< Write binary records. */
+        bool perThread : 1;                /**< Producers use their own queues. */
+        bool collapse : 1;                 /**< Workers fold repeated messages. */
+    };
+
+    static_assert(std::atomic<HotConfig>::is_always_lock_free, "HotConfig must fit in one atomic word");
+
+    alignas(64) std::atomic<HotConfig> hot_{HotConfig()}; /**< Hot-path settings; written under logMutex. */
+    mutable std::mutex logMutex;                          /**< Protects configuration changes. */
+
+    /**
+     * @brief Load the hot-path settings.
+     *
+     * @return Snapshot of the settings in effect.
+     */
+    HotConfig hot() const
+    {
+        return hot_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Replace the hot-path settings after an edit.
+     *
+     * Caller must hold logMutex or be the constructor.
+     *
+     * @param edit Callable that updates a copy of the current settings.
+     */
+    template <typename F>
+    void updateHot(F &&edit)
+    {
+        HotConfig next = hot();
+        edit(next);
+        hot_.store(next, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Read the clock selected for timestamps.
+     *
+     * @param clock Clock to sample.
+     * @return The current wall-clock time.
+     */
+    static LogStamp captureStamp(TimestampClock clock);
+
+    /**
+     * @brief Append a UTC timestamp for a captured time.
+     *
+     * Formats the time as YYYY-MM-DD HH:MM:SS, appends three or six
+     * fractional digits, and tags the result with "UTC". The date and time
+     * part is cached per thread and rebuilt only when the second changes.
+     *
+     * @param buffer    Destination for the timestamp text.
+     * @param stamp     Time to format.
+     * @param precision Number of fractional digits to print.
+     */
+    static void appendStamp(std::string &buffer, const LogStamp &stamp, TimestampPrecision precision);
+
+    /**
+     * @brief Format log message components and append them to a buffer.
+     *
+     * This template converts each argument to text in a reusable per-thread
+     * buffer, applies spacing logic between adjacent components, then splits
+     * on line breaks and appends each line with optional timestamp and level
+     * tag to the destination buffer.
+     *
+     * @tparam T    Type of the first message component.
+     * @tparam Args Types of any additional components.
+     * @param buffer Destination for the formatted log text.
+     * @param style  Timestamp and normalization options.
+     * @param level  Severity level of the message.
+     * @param t      First component of the message.
+     * @param args   Remaining components of the message.
+     */
+    template <typename T, typename... Args>
+    void formatTo(std::string &buffer,
+                  const LogStyle &style,
+                  LogLevel level,
+                  T &&t,
+                  Args &&...args);
+
+    /**
+     * @brief Insert a separating space before the newest message part.
+     *
+     * Applies shouldSkipSpace() to the previous part and the part that
+     * starts at start, inserts a space between them when needed, and
+     * advances prevStart to the newest part.
+     *
+     * @param combined  Buffer holding all parts appended so far.
+     * @param prevStart Offset of the previous part; updated on return.
+     * @param start     Offset of the newest part.
+     */
+    static void joinPart(std::string &combined, size_t &prevStart, size_t start);
+
+    /**
+     * @brief Start a logKV() record with its timestamp, level and message.
+     *
+     * @param buffer   Destination buffer.
+     * @param settings Hot settings giving the encoding and timestamp options.
+     * @param level    Severity level of the record.
+     * @param msg      Human-readable message.
+     */
+    void beginRecord(std::string &buffer, const HotConfig &settings, LogLevel level, std::string_view msg) const;
+
+    /**
+     * @brief Finish a logKV() record.
+     *
+     * @param buffer Destination buffer.
+     * @param format Record encoding.
+     */
+    static void endRecord(std::string &buffer, KVFormat format);
+
+    /**
+     * @brief Append the separator and key of the next field.
+     *
+     * @param buffer Destination buffer.
+     * @param format Record encoding.
+     * @param key    Field name.
+     */
+    static void appendKey(std::string &buffer, KVFormat format, std::string_view key);
+
+    /**
+     * @brief Append a string value, quoted and escaped as the format needs.
+     *
+     * @param buffer Destination buffer.
+     * @param format Record encoding.
+     * @param text   Value to encode.
+     */
+    static void appendQuoted(std::string &buffer, KVFormat format, std::string_view text);
+
+    /**
+     * @brief Append one field value.
+     *
+     * @tparam T Type of the value.
+     * @param buffer Destination buffer.
+     * @param format Record encoding.
+     * @param value  Value to encode.
+     */
+    template <typename T>
+    static void appendKVValue(std::string &buffer, KVFormat format, const T &value);
+
+    /**
+     * @brief Capture the current line options and, if needed, the time.
+     *
+     * @return Style to format the next message with.
+     */
+    LogStyle currentStyle() const;
+
+    /**
+     * @brief Capture the line options from loaded settings and, if needed, the time.
+     *
+     * @param settings Hot settings loaded by the caller.
+     * @return Style to format the next message with.
+     */
+    LogStyle currentStyle(const HotConfig &settings) const;
+
+    /**
+     * @brief Split combined text into tagged and optionally stamped lines.
+     *
+     * Every line of a message carries the same timestamp from style.
+     *
+     * @param buffer   Destination for the formatted lines.
+     * @param level    Severity level used for the tag.
+     * @param combined Joined message text, possibly spanning several lines.
+     * @param style    Timestamp and normalization options.
+     */
+    static void appendLines(std::string &buffer, LogLevel level, std::string_view combined,
+                            const LogStyle &style);
+
+    /**
+     * @brief Access the calling thread's reusable output buffer.
+     *
+     * @return Reference to the thread-local buffer used by format().
+     */
+    static std::string &formatBuffer();
+
+    /**
+     * @brief Access the calling thread's reusable part-joining buffer.
+     *
+     * @return Reference to the thread-local buffer used by formatTo().
+     */
+    static std::string &combineBuffer();
+
+    LCBLogConfig config_; /**< Active settings; guarded by logMutex. */
+
+    std::map<std::string, LogTagState, std::less<>> tags_; /**< Tags by name; guarded by logMutex. */
+
+    friend class LogTag;
+    friend class LogRateLimit;
+
+    /**
+     * @brief Format and queue a message that has passed its level check.
+     *
+     * @tparam Args Types of the components to format.
+     * @param settings Hot settings loaded by the caller.
+     * @param level    Severity level of the message.
+     * @param args     Components of the message.
+     */
+    template <typename... Args>
+    void emit(const HotConfig &settings, LogLevel level, Args &&...args);
+
+    /**
+     * @brief Format and queue a logFmt() message that has passed its level check.
+     *
+     * @tparam Fmt  Type whose static constexpr text() returns the format.
+     * @tparam Args Types of the values.
+     * @param settings Hot settings loaded by the caller.
+     * @param level    Severity level of the message.
+     * @param prefix   Text placed before the formatted message, or empty.
+     * @param args     One value per placeholder.
+     */
+    template <typename Fmt, typename... Args>
+    void emitFmt(const HotConfig &settings, LogLevel level, std::string_view prefix, Args &&...args);
+
+    /**
+     * @brief Find a tag by name, creating it with the logger's level.
+     *
+     * Caller must hold logMutex.
+     *
+     * @param name Tag name.
+     * @return The tag's state, stable for the logger's lifetime.
+     */
+    LogTagState &findTag(std::string_view name);
+
+    /**
+     * @brief Request a flush on every route and wait for the workers.
+     *
+     * @param bounded  False to wait without a limit.
+     * @param deadline Latest time to wait when bounded.
+     * @return True if every route answered, false on timeout or when
+     * called from a worker.
+     */
+    bool awaitFlush(bool bounded, std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief Add this logger to, or remove it from, the loggers dumped
+     * by the crash handler, installing the handler on first use.
+     *
+     * Caller must hold logMutex or be the constructor or destructor.
+     *
+     * @param enable True to register, false to unregister.
+     */
+    void registerCrashDump(bool enable);
+
+    /**
+     * @brief Write queued entries of every route whose sink has a crash
+     * descriptor. Async-signal-safe.
+     *
+     * @param sig Signal being handled, named in the notice line.
+     */
+    void dumpQueued(int sig) const;
+
+    /**
+     * @brief Handler for SIGSEGV, SIGABRT, and SIGBUS.
+     *
+     * Restores the previous action, dumps every registered logger once,
+     * and raises the signal again.
+     *
+     * @param sig Signal being handled.
+     */
+    static void onCrashSignal(int sig);
+
+    std::atomic<size_t> batchSize_;                /**< Messages per flush. */
+    std::atomic<int64_t> flushIntervalMs_;         /**< Flush interval. */
+    std::atomic<int64_t> blockTimeoutMs_;          /**< Wait limit for BlockWithTimeout. */
+    std::atomic<int64_t> workerSpinNs_;            /**< Longest idle poll before a worker parks. */
+    std::atomic<size_t> overflowByteCap_;          /**< Spill limit for GrowToCap. */
+    const uint64_t instanceId_;                    /**< Tells loggers apart in thread-local state. */
+    const std::shared_ptr<LogExecutor> executor_;  /**< Shared threads serving the routes, or null. */
+
+    struct Route;
+    struct Drain;
+
+    /**
+     * @struct ThreadQueue
+     * @brief A queue with a single producer thread, owned jointly by that
+     * thread and its route.
+     *
+     * The route keeps the queue after the thread exits, so entries still
+     * queued are drained rather than lost.
+     */
+    struct ThreadQueue
+    {
+        ThreadQueue(size_t capacity, size_t reserve, uint64_t owner, const Route *route)
+            : ring(capacity, reserve), owner(owner), route(route) {}
+
+        LogRing ring;                      /**< Entries from the producer thread. */
+        const uint64_t owner;              /**< instanceId_ of the logger. */
+        const Route *const route;          /**< Route the queue feeds. */
+        std::atomic<bool> exited{false};   /**< Producer thread has ended. */
+        std::atomic<bool> detached{false}; /**< Logger has been destroyed. */
+    };
+
+    /**
+     * @struct Route
+     * @brief A routing table entry with its queue and worker.
+     */
+    struct Route
+    {
+        Route(const LogRoute &r, size_t capacity, size_t reserve);
+        ~Route(); // Out of line, where Drain is complete
+
+        LogRoute spec;                /**< Sink and level range. */
+        LogRing queue;                /**< Messages waiting for this sink. */
+        std::thread worker;           /**< Drains queue into the sink, unless an executor does. */
+        std::unique_ptr<Drain> drain; /**< Worker state between wakeups. */
+
+        std::mutex threadsMtx;                              /**< Protects threads and the retired counts. */
+        std::vector<std::shared_ptr<ThreadQueue>> threads;  /**< Per-thread queues feeding the worker. */
+        uint64_t retiredDrops = 0;                          /**< Drops of thread queues since retired. */
+        uint64_t retiredPushed = 0;                         /**< Accepted entries of retired thread queues. */
+        std::atomic<uint64_t> threadsAdded{0};              /**< Bumped when a thread queue registers. */
+
+        std::atomic<uint64_t> written{0};   /**< Entries handed to the sink. */
+        std::atomic<uint64_t> bytes{0};     /**< Bytes handed to the sink. */
+        std::atomic<uint64_t> batches{0};   /**< Sink write() calls. */
+        std::atomic<uint64_t> highWater{0}; /**< Deepest backlog seen by the worker. */
+        std::atomic<int64_t> writeNs{0};    /**< Time spent in the sink. */
+
+        std::atomic<uint64_t> flushRequested{0}; /**< Ticket of the latest flush() call. */
+        std::atomic<uint64_t> flushDone{0};      /**< Latest ticket the worker has completed. */
+        std::mutex flushMtx;                     /**< Pairs with flushCv. */
+        std::condition_variable flushCv;         /**< Wakes flush() callers. */
+    };
+
+    std::vector<std::unique_ptr<Route>> routes_;   /**< Routing table; fixed after construction. */
+
+    /**
+     * @struct SharedSlot
+     * @brief A recycled buffer for text fanned out to several queues.
+     */
+    struct SharedSlot
+    {
+        std::atomic<bool> busy{false};       /**< A producer is checking or filling buffer. */
+        std::shared_ptr<std::string> buffer; /**< Created on first use; free while only the pool holds it. */
+    };
+
+    std::unique_ptr<SharedSlot[]> sharedPool_; /**< Buffers for messages with several routes. */
+    size_t sharedPoolSize_ = 0;                /**< Slots in sharedPool_; 0 when one route takes every level. */
+    std::atomic<size_t> sharedCursor_{0};      /**< Next slot to try. */
+
+    /**
+     * @brief Copy text into a recycled shared buffer.
+     *
+     * @param text Message content.
+     * @return Buffer holding text; freshly allocated if no pooled one is
+     * free within a few probes.
+     */
+    std::shared_ptr<const std::string> sharedText(std::string_view text);
+    std::vector<Route *> routesByLevel_[FATAL + 1]; /**< Routes matching each level. */
+    std::atomic<bool> done_{false};                /**< Signal to stop worker loops. */
+    std::atomic<int64_t> shutdownDeadline_{0};     /**< Steady-clock ns when draining stops; 0 for none. */
+
+    /**
+     * @brief Look up the routes that receive a level.
+     *
+     * @param level Severity of the message; out-of-range values are
+     * clamped to DEBUG or FATAL.
+     * @return Routes to enqueue the message on.
+     */
+    const std::vector<Route *> &routesFor(LogLevel level) const
+    {
+        return routesByLevel_[level < DEBUG ? DEBUG : (level > FATAL ? FATAL : level)];
+    }
+
+    /**
+     * @brief Publish config_ fields to the atomics read on the hot path.
+     *
+     * Caller must hold logMutex or be the constructor.
+     */
+    void applyConfig();
+
+    /**
+     * @brief Queue a formatted message, applying the overflow policy.
+     *
+     * @param route  Route the message belongs to; its worker is woken.
+     * @param queue  Ring that receives the message: the route queue or a
+     * thread queue of that route.
+     * @param policy Overflow policy loaded by the caller.
+     * @param dest   Destination recorded with the entry.
+     * @param level  Severity recorded with the entry.
+     * @param text   Formatted message text or packed arguments.
+     * @param packed True if text is a LogPack encoding.
+     * @param shared Buffer holding text for several queues, or nullptr.
+     * @param stamp  Enqueue time recorded with the entry.
+     */
+    void enqueue(Route &route, LogRing &queue, OverflowPolicy policy, LogEntry::Destination dest, LogLevel level,
+                 std::string_view text, bool packed, const std::shared_ptr<const std::string> &shared = nullptr,
+                 int64_t stamp = 0);
+
+    /**
+     * @brief Return the calling thread's queue for a route, creating and
+     * registering it on first use.
+     *
+     * @param route Route the queue feeds.
+     * @return Queue with the calling thread as its only producer.
+     */
+    LogRing &threadQueue(Route &route);
+
+    /**
+     * @brief Queue a formatted message on every route that takes its level.
+     *
+     * @param settings Hot settings loaded by the caller.
+     * @param level    Severity of the message.
+     * @param text     Formatted message text or packed arguments.
+     * @param packed   True if text is a LogPack encoding.
+     */
+    void dispatch(const HotConfig &settings, LogLevel level, std::string_view text, bool packed);
+
+    /**
+     * @brief Processes queued log entries in batches on a background thread.
+     *
+     * Applies the worker thread settings, then alternates between waiting
+     * for new entries or a timeout and one pass of the route's Drain, and
+     * drains what is left once the logger shuts down.
+     *
+     * @param route Route whose queues and sink the loop serves.
+     */
+    void workerLoop(Route &route);
+
+    /**
+     * @brief Apply the thread settings to the calling worker.
+     *
+     * Names the thread, pins it to config.workerCpus, and sets its nice
+     * value and real-time priority. Settings the host refuses, usually
+     * for lack of privileges, are reported once as a WARN line and the
+     * worker runs on with the defaults.
+     *
+     * @param index Position of the worker's route, used in its name.
+     */
+    void tuneWorker(size_t index);
+
+    std::thread reporter_;              /**< Writes the periodic stats report. */
+    std::mutex reporterMtx_;            /**< Pairs with reporterCv_. */
+    std::condition_variable reporterCv_; /**< Wakes the reporter early. */
+    bool reporterStop_ = false;         /**< Tells the reporter to exit; guarded by reporterMtx_. */
+    uint64_t reporterGeneration_ = 0;   /**< Bumped by setConfig(); guarded by reporterMtx_. */
+
+    /**
+     * @brief Start the stats reporter if an interval is set and it is not
+     * running.
+     *
+     * Caller must hold logMutex or be the constructor.
+     */
+    void startReporter();
+
+    /**
+     * @brief Write a stats record per route every statsInterval.
+     */
+    void reportLoop();
+
+    /**
+     * @struct WatchedLimit
+     * @brief Limiter with refusals still to be reported.
+     */
+    struct WatchedLimit
+    {
+        LogRateLimit *limit;     /**< Limiter that refused messages. */
+        LogLevel level;          /**< Level of the refused messages. */
+        const LogTagState *tag;  /**< Tag they were logged under, or nullptr. */
+    };
+
+    std::mutex limitsMtx_;                      /**< Guards limits_ and the limiters' watcher_. */
+    std::vector<WatchedLimit> limits_;          /**< Limiters awaiting a report; guarded by limitsMtx_. */
+    std::atomic<bool> limitsWatched_{false};    /**< limits_ is not empty. */
+
+    /**
+     * @brief Remember a limiter that refused a message, so its count is
+     * reported even if the call site never logs again.
+     *
+     * @param limit Limiter that refused the message.
+     * @param level Level of the refused message.
+     * @param tag   Tag the message was logged under, or nullptr.
+     */
+    void watchLimit(LogRateLimit &limit, LogLevel level, const LogTagState *tag);
+
+    /**
+     * @brief Forget a limiter that is being destroyed, logging the
+     * refusals it still holds.
+     *
+     * @param limit Limiter to forget.
+     */
+    void unwatchLimit(LogRateLimit &limit);
+
+    /**
+     * @brief Log the refusals of watched limiters whose window has passed.
+     *
+     * @param all Report every watched limiter, as at shutdown.
+     */
+    void reportSuppressed(bool all);
+
+    /**
+     * @brief Log one limiter's refusal count.
+     *
+     * @param level Level of the refused messages.
+     * @param tag   Tag they were logged under, or nullptr.
+     * @param count Number of refused messages; nothing is logged for zero.
+     */
+    void reportCount(LogLevel level, const LogTagState *tag, uint64_t count);
+
+    /**
+     * @brief Append one queued entry as binary records.
+     *
+     * Writes format records for any IDs not yet written to this stream,
+     * then the message record. Borrowed strings are copied, since their
+     * addresses mean nothing outside this process.
+     *
+     * @param out            Destination buffer.
+     * @param level          Severity of the entry.
+     * @param body           Packed arguments, or formatted text.
+     * @param packed         True if body is a LogPack encoding.
+     * @param formatsWritten Number of format IDs already written; updated.
+     */
+    static void appendBinaryRecord(std::string &out, LogLevel level, std::string_view body, bool packed,
+                                   size_t &formatsWritten);
+};
+
+/**
+ * @brief Determine if a space should be omitted between two tokens.
+ *
+ * This free function returns true when the next token is empty or
+ * starts with punctuation, or when the previous token ends with
+ * whitespace. It returns false if a space is required before a word.
+ *
+ * @param prev Previous token text.
+ * @param curr Next token text.
+ * @return True if no space should be added, false otherwise.
+ */
+bool shouldSkipSpace(std::string_view prev, std::string_view curr);
+
+/**
+ * @brief Append the text form of one message component to a buffer.
+ *
+ * Strings and characters are copied as-is. Integers and floating-point
+ * values are converted with std::to_chars; a floating-point value with
+ * no fractional part keeps one decimal place (for example "100.0").
+ * Other types fall back to their stream insertion operator.
+ *
+ * @tparam T Type of the component.
+ * @param buffer Destination buffer.
+ * @param value  Component to append.
+ */
+template <typename T>
+void appendLogArg(std::string &buffer, const T &value);
+
+/**
+ * @brief Append the LogPack encoding of one message component.
+ *
+ * Values that appendLogArg() converts directly are stored raw; anything
+ * else is converted to text now and stored as Text.
+ *
+ * @tparam T Type of the component.
+ * @param buffer Destination buffer.
+ * @param value  Component to encode.
+ */
+template <typename T>
+void packLogArg(std::string &buffer, const T &value);
+
+/**
+ * @class LogBinaryDecoder
+ * @brief Turns binary log records back into the text they stand for.
+ *
+ * Records may arrive in pieces; next() reports when it needs more bytes,
+ * so a truncated file decodes up to its last complete record.
+ */
+class LogBinaryDecoder
+{
+public:
+    /**
+     * @enum Result
+     * @brief Outcome of decoding one record.
+     */
+    enum Result
+    {
+        Decoded,  /**< A record was consumed. */
+        NeedMore, /**< in holds only part of a record. */
+        Malformed /**< The record cannot be decoded. */
+    };
+
+    /**
+     * @brief Decode the record at the front of in.
+     *
+     * @param in  Binary input; advanced past the record when Decoded.
+     * @param out Receives the text of message records.
+     * @return Outcome; in is left unchanged unless Decoded.
+     */
+    Result next(std::string_view &in, std::string &out);
+
+private:
+    std::vector<std::string> formats_; /**< Format text by ID. */
+    bool sawHeader_ = false;           /**< Header record has been read. */
+};
+
+/**
+ * @brief Append a value through its stream insertion operator.
+ *
+ * @tparam T Type of the value.
+ * @param buffer Destination buffer.
+ * @param value  Value to insert.
+ */
+template <typename T>
+void appendStreamed(std::string &buffer, const T &value);
+
+#include "lcblog.tpp"
+
+/**
+ * @brief Returns the singleton logger instance.
+ *
+ * Constructs the LCBLog instance on first invocation using the given
+ * streams and settings. Subsequent calls ignore their parameters and
+ * return the same instance.
+ *
+ * @param out    The output stream for standard logs
+ * @param err    The output stream for error logs
+ * @param config Queue, batching, and overflow settings
+ * @return Reference to the global LCBLog singleton instance
+ */
+LCBLog &getLogger(std::ostream &out, std::ostream &err,
+                  const LCBLogConfig &config = LCBLogConfig());
+
+/**
+ * @brief Returns the singleton logger instance built with given settings.
+ *
+ * @param config Queue, batching, and overflow settings
+ * @return Reference to the global LCBLog singleton instance
+ */
+LCBLog &getLogger(const LCBLogConfig &config);
+
+LCBLog &getLogger();
+
+#define llog getLogger()
+
+/** @brief Expand to the first of the macro arguments. */
+#define LCBLOG_FIRST_(first, ...) first
+
+/**
+ * @def LCBLOG_S
+ * @brief Log to the output queue, compiling to nothing below LCBLOG_MIN_LEVEL.
+ *
+ * Unlike logger.logS(), the arguments are not evaluated when the level is
+ * compiled out. The level must be a constant expression.
+ */
+#define LCBLOG_S(logger, level, ...)                  \
+    do                                                \
+    {                                                 \
+        if constexpr (::lcblogCompiledIn(level))      \
+        {                                             \
+            (logger).logS((level), __VA_ARGS__);      \
+        }                                             \
+    } while (0)
+
+/**
+ * @def LCBLOG_E
+ * @brief Log to the error queue, compiling to nothing below LCBLOG_MIN_LEVEL.
+ *
+ * Unlike logger.logE(), the arguments are not evaluated when the level is
+ * compiled out. The level must be a constant expression.
+ */
+#define LCBLOG_E(logger, level, ...)                  \
+    do                                                \
+    {                                                 \
+        if constexpr (::lcblogCompiledIn(level))      \
+        {                                             \
+            (logger).logE((level), __VA_ARGS__);      \
+        }                                             \
+    } while (0)
+
+/**
+ * @def LCBLOG_F
+ * @brief Log with a constant first component registered once per call site.
+ *
+ * The first argument must be a string literal or other constant text. It
+ * is registered on first use, and binary output stores only its ID. Like
+ * LCBLOG_S, nothing is evaluated below LCBLOG_MIN_LEVEL.
+ */
+#define LCBLOG_F(logger, level, ...)                                                      \
+    do                                                                                    \
+    {                                                                                     \
+        if constexpr (::lcblogCompiledIn(level))                                          \
+        {                                                                                 \
+            static const ::LogFormat lcblogFormat_ =                                      \
+                ::LCBLog::registerFormat(LCBLOG_FIRST_(__VA_ARGS__, ~));                  \
+            (logger).logF((level), lcblogFormat_, __VA_ARGS__);                           \
+        }                                                                                 \
+    } while (0)
+
+/**
+ * @def LCBLOG_FMT
+ * @brief Log with a "{}" format string parsed and checked at compile time.
+ *
+ * The first argument must be a string literal. A placeholder count that
+ * does not match the values, or a stray brace, fails to compile. Like
+ * LCBLOG_S, nothing is evaluated below LCBLOG_MIN_LEVEL.
+ */
+#define LCBLOG_FMT(logger, level, ...)                                                    \
+    do                                                                                    \
+    {                                                                                     \
+        if constexpr (::lcblogCompiledIn(level))                                          \
+        {                                                                                 \
+            struct LcblogFmt_                                                             \
+            {                                                                             \
+                static constexpr std::string_view text() { return LCBLOG_FIRST_(__VA_ARGS__, ~); } \
+            };                                                                            \
+            (logger).template logFmt<LcblogFmt_>((level), __VA_ARGS__);                   \
+        }                                                                                 \
+    } while (0)
+
+/**
+ * @def LCBLOG_LIMIT
+ * @brief Log at most perSecond messages per second from this call site.
+ *
+ * Declares a LogRateLimit for the call site and passes it to
+ * logLimited(), so refused messages are never formatted. As with
+ * LCBLOG_S, nothing is evaluated below LCBLOG_MIN_LEVEL.
+ */
+#define LCBLOG_LIMIT(logger, level, perSecond, burst, ...)                                 \
+    do                                                                                    \
+    {                                                                                     \
+        if constexpr (::lcblogCompiledIn(level))                                          \
+        {                                                                                 \
+            static ::LogRateLimit lcblogLimit_((perSecond), (burst));                     \
+            (logger).logLimited(lcblogLimit_, (level), __VA_ARGS__);                      \
+        }                                                                                 \
+    } while (0)
 
 #endif // LCBLOG_HPP
@@ -39,24 +39,27 @@
 
 #include "lcblog.hpp"
 
-#include <chrono>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iomanip>
-#include <iostream>
-#include <regex>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <utility>
-#include <vector>
-
-#include <cctype>
 
 /**
  * @brief Enqueue a formatted log message for asynchronous processing.
  *
  * This template formats the provided arguments into a single string,
- * selects the appropriate output queue (standard or error), and
- * notifies a background worker without blocking the calling thread.
+ * queues it for every route whose level range includes level, and
+ * notifies the background workers without blocking the calling thread.
+ * With deferred formatting or binary output enabled, the raw arguments
+ * are packed instead and the worker produces the text or records. The
+ * hot settings are loaded once and used for the whole call.
  *
  * @tparam Args Types of the message components.
  * @param level Severity level of the message.
@@ -65,158 +68,734 @@
 template<typename... Args>
 void LCBLog::log(LogLevel level, Args&&... args)
 {
-    if (!shouldLog(level)) {
+    if (!::lcblogCompiledIn(level)) {
+        return;
+    }
+    const HotConfig settings = hot();
+    if (level < settings.level) {
         return;
     }
+    emit(settings, level, std::forward<Args>(args)...);
+}
 
-    std::ostringstream oss;
-    logToStream(oss, level, std::forward<Args>(args)...);
+/**
+ * @brief Format and queue a message that has passed its level check.
+ *
+ * Shared by log() and LogTag, which check against different thresholds.
+ *
+ * @tparam Args Types of the message components.
+ * @param settings Hot settings loaded by the caller.
+ * @param level    Severity level of the message.
+ * @param args     Components of the message to log.
+ */
+template<typename... Args>
+void LCBLog::emit(const HotConfig& settings, LogLevel level, Args&&... args)
+{
+    if (routesFor(level).empty()) {
+        return;
+    }
 
-    auto entry = std::make_unique<LogEntry>();
-    entry->msg  = std::move(oss.str());
-    entry->dest = (level >= LogLevel::ERROR
-                       ? ::LogEntry::Err
-                       : ::LogEntry::Out);
+    std::string& buffer = formatBuffer();
+    buffer.clear();
+    if (settings.deferred || settings.binary) {
+        LogPack::putHeader(buffer, currentStyle(settings));
+        (::packLogArg(buffer, args), ...);
+        dispatch(settings, level, buffer, true);
+        return;
+    }
 
-    auto& queue = (entry->dest == ::LogEntry::Err ? errQueue_ : outQueue_);
-    auto& mtx   = (entry->dest == ::LogEntry::Err ? errMtx_   : outMtx_);
-    auto& cv    = (entry->dest == ::LogEntry::Err ? errCv_    : outCv_);
+    formatTo(buffer, currentStyle(settings), level, std::forward<Args>(args)...);
+    dispatch(settings, level, buffer, false);
+}
 
-    {
-        std::lock_guard<std::mutex> lock(mtx);
-        // drop oldest if we’re at capacity
-        if (queue.size() >= this->maxQueueSize_) {
-            queue.pop_front();
-        }
-        queue.push_back(std::move(entry));
-    }
-    cv.notify_one();
+/**
+ * @brief Format a message exactly as it would be logged.
+ *
+ * The text is built in a buffer owned by the calling thread, which is
+ * reused across calls so that steady-state formatting does not allocate.
+ *
+ * @tparam Args Types of the message components.
+ * @param level Severity level of the message.
+ * @param args  Components of the message.
+ * @return View of the formatted text, valid until the next call to
+ * format() on the same thread.
+ */
+template<typename... Args>
+std::string_view LCBLog::format(LogLevel level, Args&&... args)
+{
+    std::string& buffer = formatBuffer();
+    buffer.clear();
+    formatTo(buffer, currentStyle(), level, std::forward<Args>(args)...);
+    return buffer;
 }
 
 /**
- * @brief Format log message components and write to an output stream.
+ * @brief Format log message components and append them to a buffer.
  *
- * This template converts each argument to a string, applies spacing logic,
- * splits on line breaks, applies optional timestamps and log level tags,
- * and writes each line to the provided stream.
+ * This template converts each argument to text in a reusable per-thread
+ * buffer, applies spacing logic between adjacent components, then splits
+ * on line breaks and appends each line with optional timestamp and level
+ * tag to the destination buffer.
  *
- * @tparam T   Type of the first message component.
+ * @tparam T    Type of the first message component.
  * @tparam Args Types of any additional components.
- * @param stream Output stream for formatted log text.
- * @param level Severity level of the message.
- * @param t     First component of the message.
- * @param args  Remaining components of the message.
+ * @param buffer Destination for the formatted log text.
+ * @param style  Timestamp and normalization options.
+ * @param level  Severity level of the message.
+ * @param t      First component of the message.
+ * @param args   Remaining components of the message.
  */
 template<typename T, typename... Args>
-void LCBLog::logToStream(std::ostream& stream,
-                         LogLevel       level,
-                         T&&            t,
-                         Args&&...      args)
+void LCBLog::formatTo(std::string&    buffer,
+                      const LogStyle& style,
+                      LogLevel        level,
+                      T&&             t,
+                      Args&&...       args)
 {
-    // Build padded level tag
-    std::string levelStr = ::logLevelToString(level);
-    constexpr int LOG_LEVEL_WIDTH = 5;
-    if (levelStr.size() < LOG_LEVEL_WIDTH) {
-        levelStr.append(LOG_LEVEL_WIDTH - levelStr.size(), ' ');
-    }
+    // Collect all parts into one buffer, tracking where the last one began
+    std::string& combined = combineBuffer();
+    combined.clear();
+    ::appendLogArg(combined, t);
 
-    // Prepare conversion lambda
-    auto toString = [&](auto&& val) {
-        std::ostringstream tmp;
-        if constexpr (std::is_floating_point_v<std::decay_t<decltype(val)>>) {
-            if (val == static_cast<long long>(val)) {
-                tmp << std::showpoint << std::fixed << std::setprecision(1);
-            }
-        }
-        tmp << val;
-        return tmp.str();
+    size_t prevStart = 0;
+    [[maybe_unused]] auto join = [&](const auto& arg) {
+        size_t start = combined.size();
+        ::appendLogArg(combined, arg);
+        joinPart(combined, prevStart, start);
     };
+    (join(args), ...);
+
+    // Split lines, apply cleanup, timestamp, and tag
+    appendLines(buffer, level, combined, style);
+}
+
+/**
+ * @brief Detect LazyArg wrappers.
+ *
+ * @tparam T Type to test.
+ */
+template<typename T>
+struct IsLazyArg : std::false_type {};
+
+template<typename F>
+struct IsLazyArg<LazyArg<F>> : std::true_type {};
+
+/**
+ * @brief Component type groups shared by appendLogArg() and packLogArg().
+ *
+ * T is the component type as deduced; D is its decayed form.
+ */
+template<typename T>
+inline constexpr bool isLogCharArray =
+    std::is_array_v<T> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<T>>, char>;
 
-    // Collect all parts as strings
-    std::vector<std::string> parts;
-    parts.reserve(1 + sizeof...(args));
-    parts.push_back(toString(std::forward<T>(t)));
-    (parts.push_back(toString(std::forward<Args>(args))), ...);
-
-    // Recombine with spacing logic
-    std::ostringstream combined;
-    for (size_t i = 0; i < parts.size(); ++i) {
-        if (i > 0 && !::shouldSkipSpace(parts[i - 1], parts[i])) {
-            combined << ' ';
+template<typename D>
+inline constexpr bool isLogCString = std::is_same_v<D, const char*> || std::is_same_v<D, char*>;
+
+template<typename D>
+inline constexpr bool isLogChar =
+    std::is_same_v<D, char> || std::is_same_v<D, signed char> || std::is_same_v<D, unsigned char>;
+
+template<typename D>
+inline constexpr bool isLogInteger =
+    std::is_integral_v<D> && !std::is_same_v<D, bool> && !isLogChar<D> &&
+    !std::is_same_v<D, wchar_t> && !std::is_same_v<D, char16_t> && !std::is_same_v<D, char32_t>;
+
+template<typename D>
+inline constexpr bool isLogObjectPointer =
+    std::is_pointer_v<D> && std::is_object_v<std::remove_pointer_t<D>> &&
+    !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<D>>, signed char> &&
+    !std::is_same_v<std::remove_cv_t<std::remove_pointer_t<D>>, unsigned char>;
+
+/**
+ * @brief Append a value through its stream insertion operator.
+ *
+ * Used for types without a dedicated conversion in appendLogArg(). The
+ * underlying stream is reused per thread.
+ *
+ * @tparam T Type of the value.
+ * @param buffer Destination buffer.
+ * @param value  Value to insert.
+ */
+template<typename T>
+void appendStreamed(std::string& buffer, const T& value)
+{
+    static thread_local std::ostringstream tmp;
+    tmp.str(std::string());
+    tmp.clear();
+    tmp.flags(std::ios_base::fmtflags());
+    tmp.precision(6);
+    if constexpr (std::is_floating_point_v<T>) {
+        if (value == static_cast<long long>(value)) {
+            tmp << std::showpoint << std::fixed << std::setprecision(1);
         }
-        combined << parts[i];
     }
+    tmp << value;
+    buffer.append(tmp.str());
+}
 
-    // Split lines, apply cleanup, timestamp, and tag
-    std::istringstream msgStream(combined.str());
-    std::string        line;
-    bool               firstLine  = true;
-    bool               printedAny = false;
-
-    while (std::getline(msgStream, line)) {
-        if (!firstLine) {
-            stream << std::endl;
+/**
+ * @brief Append the text form of one message component to a buffer.
+ *
+ * Strings and characters are copied as-is. Integers and floating-point
+ * values are converted with std::to_chars; a floating-point value with
+ * no fractional part keeps one decimal place (for example "100.0").
+ * Lazy components are invoked here and their result appended. Other
+ * types fall back to their stream insertion operator.
+ *
+ * @tparam T Type of the component.
+ * @param buffer Destination buffer.
+ * @param value  Component to append.
+ */
+template<typename T>
+void appendLogArg(std::string& buffer, const T& value)
+{
+    using D = std::decay_t<T>;
+
+    if constexpr (IsLazyArg<D>::value) {
+        ::appendLogArg(buffer, value.fn());
+    } else if constexpr (std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>) {
+        buffer.append(value.data(), value.size());
+    } else if constexpr (std::is_same_v<D, BorrowedArg>) {
+        buffer.append(value.text.data(), value.text.size());
+    } else if constexpr (std::is_same_v<D, LogFormat>) {
+        buffer.append(value.text.data(), value.text.size());
+    } else if constexpr (isLogCharArray<T>) {
+        buffer.append(value);
+    } else if constexpr (isLogCString<D>) {
+        if (value != nullptr) {
+            buffer.append(value);
+        }
+    } else if constexpr (isLogChar<D>) {
+        buffer.push_back(static_cast<char>(value));
+    } else if constexpr (std::is_same_v<D, bool>) {
+        buffer.push_back(value ? '1' : '0');
+    } else if constexpr (std::is_same_v<D, std::nullptr_t>) {
+        buffer.append("nullptr");
+    } else if constexpr (isLogInteger<D>) {
+        char digits[24];
+        auto res = std::to_chars(digits, digits + sizeof(digits), value);
+        buffer.append(digits, res.ptr);
+    } else if constexpr (std::is_floating_point_v<D>) {
+        char digits[64];
+        std::to_chars_result res;
+        if (value == static_cast<long long>(value)) {
+            res = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::fixed, 1);
+        } else {
+            res = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general, 6);
+        }
+        if (res.ec == std::errc()) {
+            buffer.append(digits, res.ptr);
+        } else {
+            // Values too wide for the stack buffer, such as 1e300 in fixed form
+            appendStreamed(buffer, value);
         }
-        if (printTimestamps) {
-            stream << getStamp() << "\t";
+    } else if constexpr (isLogObjectPointer<D>) {
+        if (value == nullptr) {
+            buffer.push_back('0');
+        } else {
+            char digits[2 + 2 * sizeof(void*)] = {'0', 'x'};
+            auto res = std::to_chars(digits + 2, digits + sizeof(digits),
+                                     reinterpret_cast<std::uintptr_t>(value), 16);
+            buffer.append(digits, res.ptr);
         }
-        crush(line);
-        stream << "[" << levelStr << "] " << line;
-        firstLine  = false;
-        printedAny = true;
+    } else {
+        appendStreamed(buffer, value);
     }
+}
 
-    // Emit an empty entry if nothing was printed
-    if (!printedAny) {
-        if (printTimestamps) {
-            stream << getStamp() << "\t";
+/**
+ * @brief Append the LogPack encoding of one message component.
+ *
+ * Numbers, characters and pointers are stored raw so the worker can
+ * convert them. Strings are copied, except borrowed ones, which store
+ * only their address. Lazy components are invoked now, since whatever
+ * they capture may not outlive the call. Remaining types are converted
+ * to text immediately and stored as Text.
+ *
+ * @tparam T Type of the component.
+ * @param buffer Destination buffer.
+ * @param value  Component to encode.
+ */
+template<typename T>
+void packLogArg(std::string& buffer, const T& value)
+{
+    using D = std::decay_t<T>;
+
+    if constexpr (IsLazyArg<D>::value) {
+        ::packLogArg(buffer, value.fn());
+    } else if constexpr (std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>) {
+        LogPack::putText(buffer, std::string_view(value.data(), value.size()));
+    } else if constexpr (std::is_same_v<D, BorrowedArg>) {
+        buffer.push_back(LogPack::Borrowed);
+        LogPack::putU64(buffer, reinterpret_cast<std::uintptr_t>(value.text.data()));
+        LogPack::putU64(buffer, value.text.size());
+    } else if constexpr (std::is_same_v<D, LogFormat>) {
+        buffer.push_back(LogPack::Format);
+        LogPack::putU32(buffer, value.id);
+    } else if constexpr (isLogCharArray<T>) {
+        LogPack::putText(buffer, std::string_view(value));
+    } else if constexpr (isLogCString<D>) {
+        LogPack::putText(buffer, value != nullptr ? std::string_view(value) : std::string_view());
+    } else if constexpr (isLogChar<D>) {
+        buffer.push_back(LogPack::Char);
+        buffer.push_back(static_cast<char>(value));
+    } else if constexpr (std::is_same_v<D, bool>) {
+        buffer.push_back(LogPack::Bool);
+        buffer.push_back(value ? 1 : 0);
+    } else if constexpr (std::is_same_v<D, std::nullptr_t>) {
+        buffer.push_back(LogPack::Null);
+    } else if constexpr (isLogInteger<D> && std::is_signed_v<D>) {
+        buffer.push_back(LogPack::Int);
+        LogPack::putU64(buffer, static_cast<uint64_t>(static_cast<int64_t>(value)));
+    } else if constexpr (isLogInteger<D>) {
+        buffer.push_back(LogPack::Uint);
+        LogPack::putU64(buffer, static_cast<uint64_t>(value));
+    } else if constexpr (std::is_same_v<D, float> || std::is_same_v<D, double>) {
+        // Widening is exact, so the worker prints the same digits
+        double wide = value;
+        uint64_t bits;
+        std::memcpy(&bits, &wide, sizeof(bits));
+        buffer.push_back(LogPack::Float);
+        LogPack::putU64(buffer, bits);
+    } else if constexpr (isLogObjectPointer<D>) {
+        buffer.push_back(LogPack::Pointer);
+        LogPack::putU64(buffer, reinterpret_cast<std::uintptr_t>(value));
+    } else {
+        // Convert in place behind a length field patched afterwards
+        buffer.push_back(LogPack::Text);
+        size_t at = buffer.size();
+        buffer.append(4, '\0');
+        ::appendLogArg(buffer, value);
+        uint32_t len = static_cast<uint32_t>(buffer.size() - at - 4);
+        for (int i = 0; i < 4; ++i) {
+            buffer[at + i] = static_cast<char>(len >> (8 * i));
         }
-        stream << "[" << levelStr << "] ";
     }
+}
+
+/**
+ * @brief Log a message built by a callable, only if the level passes.
+ *
+ * @tparam F Callable type taking no arguments.
+ * @param level Severity level of the message.
+ * @param fn    Callable returning the message or a value to format.
+ */
+template<typename F>
+void LCBLog::logLazy(LogLevel level, F&& fn)
+{
+    log(level, ::lazy(std::forward<F>(fn)));
+}
 
-    // Write final newline
-    stream << std::endl;
+/**
+ * @brief Log a message if a limiter allows it.
+ *
+ * @tparam Args Types of the message components.
+ * @param limit Limiter for the call site.
+ * @param level Severity level of the message.
+ * @param args  Components of the message.
+ */
+template<typename... Args>
+void LCBLog::logLimited(LogRateLimit& limit, LogLevel level, Args&&... args)
+{
+    if (!::lcblogCompiledIn(level)) {
+        return;
+    }
+    const HotConfig settings = hot();
+    if (level < settings.level) {
+        return;
+    }
+    if (!limit.allow()) {
+        watchLimit(limit, level, nullptr);
+        return;
+    }
+    if (uint64_t suppressed = limit.takeSuppressed()) {
+        emit(settings, level, suppressed, "similar messages suppressed");
+    }
+    emit(settings, level, std::forward<Args>(args)...);
 }
 
 /**
- * @brief Determine if a space should be omitted between two tokens.
+ * @brief Log with a registered format as the first component.
  *
- * This free function returns true when the next token is empty or
- * starts with punctuation, or when the previous token ends with
- * whitespace. It returns false if a space is required before a word.
+ * @tparam T    Type of the literal.
+ * @tparam Args Types of the remaining components.
+ * @param level   Severity level of the message.
+ * @param fmt     Registered form of the literal.
+ * @param literal Original text, ignored.
+ * @param args    Remaining components of the message.
+ */
+template<typename T, typename... Args>
+void LCBLog::logF(LogLevel level, const LogFormat& fmt, T&& /*literal*/, Args&&... args)
+{
+    log(level, fmt, std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Marks a format string that LCBLOG_FMT cannot use.
+ */
+inline constexpr size_t logFmtInvalid = static_cast<size_t>(-1);
+
+/**
+ * @brief Count the {} placeholders in a format string.
  *
- * @tparam PrevT Type of the previous token.
- * @tparam T     Type of the next token.
- * @param prevArg Previous token string.
- * @param arg     Next token string.
- * @return True if no space should be added, false otherwise.
+ * @param fmt Format string; {{ and }} are literal braces.
+ * @return Number of placeholders, or logFmtInvalid if a brace is
+ * unmatched or a placeholder holds anything.
  */
-template<typename PrevT, typename T>
-bool shouldSkipSpace(const PrevT& prevArg, const T& arg)
+constexpr size_t logFmtCount(std::string_view fmt)
 {
-    std::ostringstream ossPrev, ossCurr;
-    ossPrev << prevArg;
-    ossCurr << arg;
-    std::string prev = ossPrev.str();
-    std::string curr = ossCurr.str();
-
-    // Skip if next token is empty or begins with punctuation
-    if (curr.empty() || std::ispunct(static_cast<unsigned char>(curr.front()))) {
-        return true;
+    size_t count = 0;
+    for (size_t i = 0; i < fmt.size(); ++i) {
+        const bool doubled = i + 1 < fmt.size() && fmt[i + 1] == fmt[i];
+        if (fmt[i] == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}') {
+            ++count;
+            ++i;
+        } else if (fmt[i] == '{' || fmt[i] == '}') {
+            if (!doubled) {
+                return logFmtInvalid;
+            }
+            ++i;
+        }
     }
+    return count;
+}
 
-    // Require space if this is the first token
-    if (prev.empty()) {
-        return false;
+/**
+ * @brief Literal segments of a format string, resolved at compile time.
+ *
+ * Segment k, the text before placeholder k (or after the last one),
+ * spans text[bounds[k]] to text[bounds[k + 1]].
+ *
+ * @tparam Size  Length of the format string.
+ * @tparam Count Number of placeholders.
+ */
+template<size_t Size, size_t Count>
+struct LogFmtLayout {
+    std::array<char, Size + 1> text{};      /**< Literal text with escapes resolved. */
+    std::array<size_t, Count + 2> bounds{}; /**< Segment boundaries in text. */
+};
+
+/**
+ * @brief Split a valid format string into its literal segments.
+ *
+ * @tparam Size  Length of fmt.
+ * @tparam Count Placeholders in fmt, as given by logFmtCount().
+ * @param fmt Format string.
+ * @return Layout of the segments.
+ */
+template<size_t Size, size_t Count>
+constexpr LogFmtLayout<Size, Count> makeLogFmtLayout(std::string_view fmt)
+{
+    LogFmtLayout<Size, Count> layout;
+    size_t out = 0;
+    size_t segment = 0;
+    for (size_t i = 0; i < fmt.size(); ++i) {
+        if (fmt[i] == '{' && fmt[i + 1] == '}') {
+            layout.bounds[++segment] = out;
+            ++i;
+            continue;
+        }
+        layout.text[out++] = fmt[i];
+        if (fmt[i] == '{' || fmt[i] == '}') {
+            ++i; // Skip the second brace of an escape
+        }
     }
+    layout.bounds[segment + 1] = out;
+    return layout;
+}
 
-    // Skip if previous ends in whitespace
-    if (std::isspace(static_cast<unsigned char>(prev.back()))) {
-        return true;
+/**
+ * @brief Log with a format string parsed and checked at compile time.
+ *
+ * Parsing, validation, and the unescaped literal segments are all
+ * constant; at run time the segments are copied and only the values are
+ * converted. Values are appended with appendLogArg(), as in format(), and
+ * the message then goes through the same line handling.
+ *
+ * @tparam Fmt  Type whose static constexpr text() returns the format.
+ * @tparam T    Type of the literal.
+ * @tparam Args Types of the values.
+ * @param level   Severity level of the message.
+ * @param literal Original text, ignored.
+ * @param args    One value per placeholder.
+ */
+template<typename Fmt, typename T, typename... Args>
+void LCBLog::logFmt(LogLevel level, T&& /*literal*/, Args&&... args)
+{
+    if (!::lcblogCompiledIn(level)) {
+        return;
+    }
+    const HotConfig settings = hot();
+    if (level < settings.level) {
+        return;
+    }
+    emitFmt<Fmt>(settings, level, std::string_view(), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Format and queue a logFmt() message that has passed its level check.
+ *
+ * Shared by logFmt() and LogTag::logFmt(). A non-empty prefix is joined
+ * to the formatted text with the usual spacing rules, as a tag's label
+ * is in log().
+ *
+ * @tparam Fmt  Type whose static constexpr text() returns the format.
+ * @tparam Args Types of the values.
+ * @param settings Hot settings loaded by the caller.
+ * @param level    Severity level of the message.
+ * @param prefix   Text placed before the formatted message, or empty.
+ * @param args     One value per placeholder.
+ */
+template<typename Fmt, typename... Args>
+void LCBLog::emitFmt(const HotConfig& settings, LogLevel level, std::string_view prefix, Args&&... args)
+{
+    constexpr std::string_view text = Fmt::text();
+    constexpr size_t count = logFmtCount(text);
+    static_assert(count != logFmtInvalid, "LCBLOG_FMT: unmatched brace or non-empty placeholder");
+    static_assert(count == sizeof...(Args), "LCBLOG_FMT: placeholder count does not match the values");
+    static constexpr auto layout = makeLogFmtLayout<text.size(), count>(text);
+
+    if (routesFor(level).empty()) {
+        return;
+    }
+
+    std::string& combined = combineBuffer();
+    combined.assign(prefix.data(), prefix.size());
+    auto segment = [&](size_t k) {
+        combined.append(layout.text.data() + layout.bounds[k], layout.bounds[k + 1] - layout.bounds[k]);
+    };
+    segment(0);
+    size_t next = 0;
+    [[maybe_unused]] auto value = [&](const auto& arg) {
+        ::appendLogArg(combined, arg);
+        segment(++next);
+    };
+    (value(args), ...);
+    if (!prefix.empty()) {
+        size_t prevStart = 0;
+        joinPart(combined, prevStart, prefix.size());
+    }
+
+    std::string& buffer = formatBuffer();
+    buffer.clear();
+    appendLines(buffer, level, combined, currentStyle(settings));
+    dispatch(settings, level, buffer, false);
+}
+
+/**
+ * @brief Log a structured record of named fields.
+ *
+ * Encodes the record in the thread's format buffer, then hands it to the
+ * routes for its level. Records skip deferred packing since the encoders
+ * already write final text without an intermediate parts buffer.
+ *
+ * @tparam Fields KV field types.
+ * @param level  Severity level of the record.
+ * @param msg    Human-readable message.
+ * @param fields Fields created with kv().
+ */
+template<typename... Fields>
+void LCBLog::logKV(LogLevel level, std::string_view msg, const Fields&... fields)
+{
+    if (!::lcblogCompiledIn(level)) {
+        return;
+    }
+    const HotConfig settings = hot();
+    if (level < settings.level || routesFor(level).empty()) {
+        return;
+    }
+
+    const KVFormat fmt = settings.kvFormat;
+    std::string& buffer = formatBuffer();
+    buffer.clear();
+    beginRecord(buffer, settings, level, msg);
+    [[maybe_unused]] auto field = [&](const auto& f) {
+        appendKey(buffer, fmt, f.key);
+        appendKVValue(buffer, fmt, f.value);
+    };
+    (field(fields), ...);
+    endRecord(buffer, fmt);
+    dispatch(settings, level, buffer, false);
+}
+
+/**
+ * @brief Append one structured field value.
+ *
+ * Numbers, bools and null are written bare; strings and characters are
+ * quoted as the format requires. Non-finite floats have no JSON form and
+ * are written as strings. Other types are converted as logS() would and
+ * then quoted.
+ *
+ * @tparam T Type of the value.
+ * @param buffer Destination buffer.
+ * @param format Record encoding.
+ * @param value  Value to encode.
+ */
+template<typename T>
+void LCBLog::appendKVValue(std::string& buffer, KVFormat format, const T& value)
+{
+    using D = std::decay_t<T>;
+
+    if constexpr (IsLazyArg<D>::value) {
+        appendKVValue(buffer, format, value.fn());
+    } else if constexpr (std::is_same_v<D, std::string> || std::is_same_v<D, std::string_view>) {
+        appendQuoted(buffer, format, std::string_view(value.data(), value.size()));
+    } else if constexpr (std::is_same_v<D, BorrowedArg>) {
+        appendQuoted(buffer, format, value.text);
+    } else if constexpr (isLogCharArray<T>) {
+        appendQuoted(buffer, format, std::string_view(value));
+    } else if constexpr (isLogCString<D>) {
+        if (value == nullptr) {
+            buffer.append("null");
+        } else {
+            appendQuoted(buffer, format, std::string_view(value));
+        }
+    } else if constexpr (isLogChar<D>) {
+        const char c = static_cast<char>(value);
+        appendQuoted(buffer, format, std::string_view(&c, 1));
+    } else if constexpr (std::is_same_v<D, bool>) {
+        buffer.append(value ? "true" : "false");
+    } else if constexpr (std::is_same_v<D, std::nullptr_t>) {
+        buffer.append("null");
+    } else if constexpr (isLogInteger<D>) {
+        ::appendLogArg(buffer, value);
+    } else if constexpr (std::is_floating_point_v<D>) {
+        if (std::isfinite(value)) {
+            ::appendLogArg(buffer, value);
+        } else {
+            std::string& text = combineBuffer();
+            text.clear();
+            ::appendLogArg(text, value);
+            appendQuoted(buffer, format, text);
+        }
+    } else {
+        std::string& text = combineBuffer();
+        text.clear();
+        ::appendLogArg(text, value);
+        appendQuoted(buffer, format, text);
+    }
+}
+
+/**
+ * @brief Log a message under this tag.
+ *
+ * The tag's label is borrowed, since the logger keeps it for its whole
+ * lifetime.
+ *
+ * @tparam Args Types of the message components.
+ * @param level Severity level of the message.
+ * @param args  Components of the message.
+ */
+template<typename... Args>
+void LogTag::log(LogLevel level, Args&&... args)
+{
+    if (!shouldLog(level)) {
+        return;
+    }
+    owner_->emit(owner_->hot(), level, BorrowedArg{state_->label}, std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Log a message under this tag.
+ *
+ * @tparam T    Type of the first message component.
+ * @tparam Args Types of any additional components.
+ * @param level Severity level of the message.
+ * @param t     First component of the message.
+ * @param args  Remaining components of the message.
+ */
+template<typename T, typename... Args>
+void LogTag::logS(LogLevel level, T&& t, Args&&... args)
+{
+    log(level, std::forward<T>(t), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Log a message under this tag.
+ *
+ * @tparam T    Type of the first message component.
+ * @tparam Args Types of any additional components.
+ * @param level Severity level of the message.
+ * @param t     First component of the message.
+ * @param args  Remaining components of the message.
+ */
+template<typename T, typename... Args>
+void LogTag::logE(LogLevel level, T&& t, Args&&... args)
+{
+    log(level, std::forward<T>(t), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Log a message built by a callable, only if the tag's level passes.
+ *
+ * @tparam F Callable type taking no arguments.
+ * @param level Severity level of the message.
+ * @param fn    Callable returning the message or a value to format.
+ */
+template<typename F>
+void LogTag::logLazy(LogLevel level, F&& fn)
+{
+    log(level, ::lazy(std::forward<F>(fn)));
+}
+
+/**
+ * @brief Log under this tag with a registered format.
+ *
+ * @tparam T    Type of the literal.
+ * @tparam Args Types of the remaining components.
+ * @param level   Severity level of the message.
+ * @param fmt     Registered form of the literal.
+ * @param literal Original text, ignored.
+ * @param args    Remaining components of the message.
+ */
+template<typename T, typename... Args>
+void LogTag::logF(LogLevel level, const LogFormat& fmt, T&& /*literal*/, Args&&... args)
+{
+    log(level, fmt, std::forward<Args>(args)...);
+}
+
+/**
+ * @brief Log under this tag with a compile-time checked format.
+ *
+ * @tparam Fmt  Type whose static constexpr text() returns the format.
+ * @tparam T    Type of the literal.
+ * @tparam Args Types of the values.
+ * @param level   Severity level of the message.
+ * @param literal Original text, ignored.
+ * @param args    One value per placeholder.
+ */
+template<typename Fmt, typename T, typename... Args>
+void LogTag::logFmt(LogLevel level, T&& /*literal*/, Args&&... args)
+{
+    if (!shouldLog(level)) {
+        return;
     }
+    owner_->emitFmt<Fmt>(owner_->hot(), level, state_->label, std::forward<Args>(args)...);
+}
 
-    // Otherwise, add a space
-    return false;
+/**
+ * @brief Log under this tag if a limiter allows it.
+ *
+ * @tparam Args Types of the message components.
+ * @param limit Limiter for the call site.
+ * @param level Severity level of the message.
+ * @param args  Components of the message.
+ */
+template<typename... Args>
+void LogTag::logLimited(LogRateLimit& limit, LogLevel level, Args&&... args)
+{
+    if (!shouldLog(level)) {
+        return;
+    }
+    if (!limit.allow()) {
+        owner_->watchLimit(limit, level, state_);
+        return;
+    }
+    if (uint64_t suppressed = limit.takeSuppressed()) {
+        owner_->emit(owner_->hot(), level, BorrowedArg{state_->label}, suppressed, "similar messages suppressed");
+    }
+    owner_->emit(owner_->hot(), level, BorrowedArg{state_->label}, std::forward<Args>(args)...);
 }
 
 /**
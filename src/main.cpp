@@ -34,11 +34,70 @@
  */
 
 #include "lcblog.hpp"
+#include <algorithm>
+#include <condition_variable>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <regex>
 #include <thread>
 #include <vector>
 #include <cassert>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if defined(LCBLOG_WITH_ZLIB)
+#include <zlib.h>
+#endif
+
+// Count heap allocations made by the current thread
+static thread_local size_t threadAllocations = 0;
+
+// Called with the size of each allocation made by the current thread
+static thread_local void (*allocationHook)(std::size_t) = nullptr;
+
+// GCC cannot see that these replace the global pair and flags free() here
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(std::size_t size)
+{
+    ++threadAllocations;
+    if (allocationHook)
+    {
+        allocationHook(size);
+    }
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+#pragma GCC diagnostic pop
 
 void threadSafetyTest()
 {
@@ -183,6 +242,1840 @@ void crushTestViaLog()
     llog.logS(INFO, testStr7); // This should automatically be cleaned by crush
 }
 
+// Reference implementation: the original five-pass regex normalizer
+std::string regexCrush(std::string s)
+{
+    s = std::regex_replace(s, std::regex(R"(^\s+|\s+$)"), "");
+    s = std::regex_replace(s, std::regex(R"(\s+)"), " ");
+    s = std::regex_replace(s, std::regex(R"(\s+([,\.!?:;]))"), "$1");
+    s = std::regex_replace(s, std::regex(R"(\(\s+)"), "(");
+    s = std::regex_replace(s, std::regex(R"(\s+\))"), ")");
+    return s;
+}
+
+void crushDifferentialTest()
+{
+    std::cout << "Testing crush against the regex reference." << std::endl;
+
+    const std::vector<std::string> fixed = {
+        "", " ", "\t\n", "   Hello World   ", "Hello    World", "Hello  , World",
+        "Hello (   World   )", "   This    is   \t\ttest   ", "a ( ) b", "( ,",
+        "x ! y ? z : w ; v .", "((  ))", "no-whitespace-at-all-in-this-long-run",
+        "a\vb\fc\rd", "trailing newline\n", "sixteen-byte-run  then more text here"};
+    for (const auto &in : fixed)
+    {
+        std::string out = in;
+        LCBLog::crush(out);
+        assert(out == regexCrush(in));
+    }
+
+    // Random strings dense in the characters the rules care about
+    const std::string alphabet = "  \t\n\v\f\r(),.!?:;abcdefghijklmnop";
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<size_t> pick(0, alphabet.size() - 1);
+    std::uniform_int_distribution<size_t> length(0, 48);
+    for (int i = 0; i < 5000; ++i)
+    {
+        std::string in(length(rng), ' ');
+        for (auto &c : in)
+        {
+            c = alphabet[pick(rng)];
+        }
+        std::string out = in;
+        LCBLog::crush(out);
+        assert(out == regexCrush(in));
+    }
+}
+
+void formatAllocationTest()
+{
+    std::cout << "Testing steady-state formatting allocations." << std::endl;
+
+    std::string owned = "  owned   string ";
+    auto formatOnce = [&]()
+    {
+        llog.format(INFO, "Value", 42, "and", 3.5, "or", 100.0, owned, '!', -7L);
+        llog.format(WARN, "Multi ", 100.01, " \nline (", 0.0, ")");
+    };
+
+    // Warm up the thread-local buffers, then require no further allocations
+    llog.enableTimestamps(true);
+    formatOnce();
+    size_t before = threadAllocations;
+    for (int i = 0; i < 1000; ++i)
+    {
+        formatOnce();
+    }
+    assert(threadAllocations == before);
+
+    assert(llog.format(INFO, "Testing1", "(", 0.0, ")").find("[INFO ] Testing1(0.0)\n") != std::string_view::npos);
+}
+
+void ringConcurrencyTest()
+{
+    std::cout << "Testing lock-free queue with concurrent producers." << std::endl;
+
+    const int producers = 4;
+    const int perProducer = 20000;
+    LogRing ring(64);
+    std::atomic<bool> stop{false};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+    {
+        threads.emplace_back([&ring, p]()
+                             {
+            for (int i = 0; i < perProducer; ++i)
+            {
+                std::string text = std::to_string(p) + ":" + std::to_string(i);
+                while (!ring.tryPush(LogEntry::Out, INFO, text))
+                {
+                    std::this_thread::yield();
+                }
+                ring.notify();
+            } });
+    }
+
+    // Every message must arrive exactly once and in order per producer
+    std::vector<int> next(producers, 0);
+    LogEntry entry;
+    int received = 0;
+    while (received < producers * perProducer)
+    {
+        if (!ring.tryPop(entry))
+        {
+            ring.wait(std::chrono::milliseconds(10), stop);
+            continue;
+        }
+        size_t colon = entry.msg.find(':');
+        int p = std::stoi(entry.msg.substr(0, colon));
+        int i = std::stoi(entry.msg.substr(colon + 1));
+        assert(i == next[p]);
+        ++next[p];
+        ++received;
+    }
+
+    for (auto &t : threads)
+    {
+        t.join();
+    }
+    assert(ring.empty());
+    assert(!ring.tryPop(entry));
+}
+
+void ringOverflowTest()
+{
+    std::cout << "Testing queue overflow list and drop counter." << std::endl;
+
+    LogRing ring(2);
+    assert(ring.tryPush(LogEntry::Out, INFO, "a"));
+    assert(ring.tryPush(LogEntry::Out, INFO, "b"));
+    assert(!ring.tryPush(LogEntry::Out, INFO, "c"));
+
+    // The overflow list honors its byte cap and drains after the ring
+    assert(ring.trySpill(LogEntry::Out, INFO, "c", 4));
+    assert(!ring.trySpill(LogEntry::Out, INFO, "dddd", 4));
+    assert(ring.spilling());
+
+    LogEntry entry;
+    for (const char *expected : {"a", "b", "c"})
+    {
+        assert(ring.tryPop(entry));
+        assert(entry.msg == expected);
+    }
+    assert(ring.empty());
+
+    ring.recordDrop();
+    ring.recordDrop();
+    assert(ring.takeDropped() == 2);
+    assert(ring.takeDropped() == 0);
+    assert(ring.droppedTotal() == 2);
+
+    // A slot claimed but not yet filled holds back the overflow list, so
+    // one producer's spilled message cannot pass its earlier ones
+    LogRing small(4, 16);
+    static std::atomic<bool> filling{false};
+    static std::atomic<bool> release{false};
+    std::thread slow([&]()
+                     {
+        const std::string text(1000, 's');
+        // Stall while copying the text, after the slot is claimed
+        allocationHook = [](std::size_t size)
+        {
+            if (size >= 1000)
+            {
+                filling.store(true);
+                while (!release.load())
+                {
+                    std::this_thread::yield();
+                }
+            }
+        };
+        assert(small.tryPush(LogEntry::Out, INFO, text));
+        allocationHook = nullptr; });
+    while (!filling.load())
+    {
+        std::this_thread::yield();
+    }
+    for (const char *text : {"1", "2", "3"})
+    {
+        assert(!small.spilling() && small.tryPush(LogEntry::Out, INFO, text));
+    }
+    assert(!small.tryPush(LogEntry::Out, INFO, "4"));
+    assert(small.trySpill(LogEntry::Out, INFO, "4", 64));
+    assert(!small.tryPop(entry) && small.empty());
+    release.store(true);
+    slow.join();
+    assert(small.tryPop(entry) && entry.msg.size() == 1000);
+    for (const char *expected : {"1", "2", "3", "4"})
+    {
+        assert(small.tryPop(entry));
+        assert(entry.msg == expected);
+    }
+    assert(small.empty());
+}
+
+void configTest()
+{
+    std::cout << "Testing runtime configuration." << std::endl;
+
+    LCBLogConfig bad;
+    bad.batchSize = 0;
+    bool threw = false;
+    try
+    {
+        bad.validate();
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    const LCBLogConfig original = llog.getConfig();
+
+    LCBLogConfig tuned = original;
+    tuned.queueCapacity = 64;
+    tuned.batchSize = 4;
+    tuned.flushInterval = std::chrono::milliseconds(1);
+    llog.setConfig(tuned);
+    assert(llog.getConfig().batchSize == 4);
+    assert(llog.getConfig().flushInterval == std::chrono::milliseconds(1));
+    llog.logS(INFO, "Logged with a 1 ms flush interval and batches of 4.");
+
+    // Ring storage is fixed, so capacity cannot grow past the original size
+    tuned.queueCapacity = original.queueCapacity + 1;
+    threw = false;
+    try
+    {
+        llog.setConfig(tuned);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    assert(llog.getConfig().queueCapacity == 64);
+
+    // The shorthand setter validates too and leaves the settings alone
+    threw = false;
+    try
+    {
+        llog.setOverflowPolicy(GrowToCap, std::chrono::milliseconds(0), 0);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+    assert(llog.getConfig().overflowPolicy == original.overflowPolicy);
+    assert(llog.getConfig().overflowByteCap == original.overflowByteCap);
+
+    llog.setConfig(original);
+}
+
+void batchedStreamTest()
+{
+    std::cout << "Testing batched writes to caller-supplied streams." << std::endl;
+
+    std::ostringstream outText;
+    std::ostringstream errText;
+    {
+        LCBLog logger(outText, errText);
+        for (int i = 0; i < 100; ++i)
+        {
+            logger.logS(INFO, "line", i);
+        }
+        logger.logE(ERROR, "failure");
+    } // Destruction drains both queues
+
+    assert(outText.str().find("[INFO ] line 0\n") == 0);
+    assert(outText.str().find("[INFO ] line 99\n") != std::string::npos);
+    assert(errText.str() == "[ERROR] failure\n");
+}
+
+void timestampTest()
+{
+    std::cout << "Testing cached timestamps." << std::endl;
+
+    std::ostringstream sink;
+    LCBLogConfig config;
+    config.timestampPrecision = StampMicros;
+    config.timestampClock = ClockRealtimeCoarse;
+    LCBLog logger(sink, sink, config);
+    logger.enableTimestamps(true);
+
+    // "YYYY-MM-DD HH:MM:SS.uuuuuu UTC\t" prefixes every line identically
+    std::string text(logger.format(INFO, "first\nsecond\nthird"));
+    const size_t prefix = std::string("2025-01-01 00:00:00.000000 UTC\t").size();
+    assert(text.size() > 3 * prefix);
+    assert(text[19] == '.' && text.compare(26, 5, " UTC\t") == 0);
+    size_t second = text.find('\n') + 1;
+    size_t third = text.find('\n', second) + 1;
+    assert(text.compare(0, prefix, text, second, prefix) == 0);
+    assert(text.compare(0, prefix, text, third, prefix) == 0);
+}
+
+void compiledLevelTest()
+{
+    std::cout << "Testing compile-time level macros." << std::endl;
+
+    static_assert(lcblogCompiledIn(FATAL), "FATAL is always compiled in");
+
+    std::ostringstream sink;
+    int evaluated = 0;
+    {
+        LCBLog logger(sink, sink);
+        LCBLOG_S(logger, WARN, "kept", ++evaluated);
+        LCBLOG_E(logger, ERROR, "kept", ++evaluated);
+    }
+
+    // Levels at or above LCBLOG_MIN_LEVEL evaluate their arguments once
+    assert(evaluated == (lcblogCompiledIn(WARN) ? 1 : 0) + (lcblogCompiledIn(ERROR) ? 1 : 0));
+}
+
+void lazyArgumentTest()
+{
+    std::cout << "Testing lazy message arguments." << std::endl;
+
+    std::ostringstream sink;
+    int calls = 0;
+    auto payload = [&calls]()
+    {
+        ++calls;
+        return std::string("expensive payload");
+    };
+    {
+        LCBLog logger(sink, sink);
+        logger.setLogLevel(INFO);
+        logger.logS(DEBUG, "filtered:", lazy(payload));
+        logger.logLazy(DEBUG, payload);
+        assert(calls == 0);
+
+        logger.logS(INFO, "kept:", lazy(payload));
+        logger.logLazy(INFO, payload);
+        assert(calls == 2);
+
+        // Callables that change their own state work too
+        auto counter = [n = 0]() mutable { return ++n; };
+        logger.logS(INFO, "count:", lazy(counter));
+        logger.logLazy(INFO, counter);
+        logger.logKV(INFO, "counted", kv("n", lazy(counter)));
+    }
+    assert(sink.str() == "[INFO ] kept: expensive payload\n[INFO ] expensive payload\n"
+                         "[INFO ] count: 1\n[INFO ] 1\nlevel=INFO msg=counted n=1\n");
+}
+
+// Test that deferred formatting writes the same bytes as eager formatting
+void deferredFormattingTest()
+{
+    std::cout << "Testing deferred formatting." << std::endl;
+
+    static const char borrowed[] = "borrowed text";
+    int value = 7;
+    auto logAll = [&](LCBLog &logger)
+    {
+        logger.logS(INFO, "Mixed:", 42, -7L, 3.14159, 100.0, 0.5f, 'c', true, nullptr);
+        logger.logS(INFO, std::string("Parts"), std::string_view("joined"), borrow(borrowed), ".");
+        logger.logS(INFO, "Transmission completed", "(", 0.0, "sec)");
+        logger.logS(INFO, "Lines\nsplit", 18446744073709551615ULL, "\n");
+        logger.logS(INFO, "Pointer", &value, static_cast<const char *>(nullptr), "end");
+        logger.logS(INFO, "Lazy:", lazy([] { return 2.5; }), 1e300, static_cast<long double>(0.25));
+        logger.logS(ERROR, "Error", "line");
+    };
+
+    std::ostringstream eagerOut, eagerErr, deferredOut, deferredErr;
+    {
+        LCBLog eager(eagerOut, eagerErr);
+        logAll(eager);
+    }
+    {
+        LCBLogConfig config;
+        config.deferredFormatting = true;
+        LCBLog deferred(deferredOut, deferredErr, config);
+        logAll(deferred);
+    }
+    assert(!eagerOut.str().empty());
+    assert(eagerOut.str() == deferredOut.str());
+    assert(eagerErr.str() == deferredErr.str());
+
+    // Malformed input is rejected rather than misread
+    std::string text;
+    assert(!LCBLog::formatPacked(text, INFO, std::string_view("\x00\x01", 2)));
+}
+
+// Decode a whole binary log, returning false on a malformed record
+static bool decodeBinary(std::string_view bytes, std::string &text)
+{
+    LogBinaryDecoder decoder;
+    LogBinaryDecoder::Result result;
+    while ((result = decoder.next(bytes, text)) == LogBinaryDecoder::Decoded)
+    {
+    }
+    return result != LogBinaryDecoder::Malformed;
+}
+
+// Test that binary records decode to the text the logger would write
+void binaryFormatTest()
+{
+    std::cout << "Testing binary log format." << std::endl;
+
+    static const char borrowed[] = "borrowed";
+    auto logAll = [&](LCBLog &logger)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            LCBLOG_F(logger, INFO, "Request served in", 1.5 * i, "ms, status", 200 + i);
+        }
+        LCBLOG_F(logger, WARN, "Startup complete.");
+        logger.logS(INFO, "Plain", borrow(borrowed), 'x', "\nsecond line");
+        LCBLOG_F(logger, ERROR, "Failed with code", -3);
+    };
+
+    std::ostringstream textOut, textErr, binOut, binErr;
+    {
+        LCBLog text(textOut, textErr);
+        logAll(text);
+    }
+    {
+        LCBLogConfig config;
+        config.binaryFormat = true;
+        LCBLog binary(binOut, binErr, config);
+        logAll(binary);
+    }
+
+    std::string decodedOut, decodedErr;
+    assert(decodeBinary(binOut.str(), decodedOut));
+    assert(decodeBinary(binErr.str(), decodedErr));
+    assert(decodedOut == textOut.str());
+    assert(decodedErr == textErr.str());
+
+    // A truncated file decodes up to its last complete record
+    std::string cut = binOut.str();
+    cut.resize(cut.size() - 3);
+    std::string partial;
+    assert(decodeBinary(cut, partial));
+    std::string expected = textOut.str();
+    expected.resize(expected.rfind("[INFO ] Plain"));
+    assert(partial == expected);
+
+    // Corrupt input is rejected
+    std::string bad = binOut.str();
+    bad[4] = 'Z';
+    std::string ignored;
+    assert(!decodeBinary(bad, ignored));
+
+    // A format ID that skips ahead is rejected, not used to size the table
+    std::string evil = binOut.str();
+    std::string_view header = evil;
+    uint32_t headerLength = 0;
+    assert(LogPack::getU32(header, headerLength));
+    evil.resize(4 + headerLength);
+    LogPack::putU32(evil, 5);
+    evil.push_back(LogPack::RecordFormat);
+    LogPack::putU32(evil, 0xFFFFFFF0u);
+    assert(!decodeBinary(evil, ignored));
+}
+
+// Read a whole file, or return an empty string if it does not exist
+static std::string readFile(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+// Test the fd, buffered file, and rotating file sinks
+void sinkTest()
+{
+    std::cout << "Testing log sinks." << std::endl;
+
+    const std::string dir = "/tmp/lcblog_sink_test_" + std::to_string(::getpid());
+    assert(::mkdir(dir.c_str(), 0755) == 0);
+
+    // Raw descriptor sink, shared by both queues
+    const std::string fdPath = dir + "/fd.log";
+    int fd = ::open(fdPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    assert(fd >= 0);
+    {
+        LCBLog logger(std::make_shared<FdSink>(fd, true), nullptr);
+        logger.logS(INFO, "to fd", 1);
+        logger.logE(ERROR, "to fd", 2);
+    }
+    std::string fdText = readFile(fdPath);
+    assert(fdText.find("[INFO ] to fd 1\n") != std::string::npos);
+    assert(fdText.find("[ERROR] to fd 2\n") != std::string::npos);
+
+    // Buffered file sink appends to what is already there
+    const std::string filePath = dir + "/file.log";
+    {
+        std::ofstream seed(filePath);
+        seed << "existing\n";
+    }
+    {
+        auto sink = std::make_shared<FileSink>(filePath);
+        LCBLog logger(sink, sink);
+        for (int i = 0; i < 100; ++i)
+        {
+            logger.logS(INFO, "line", i);
+        }
+    }
+    std::string fileText = readFile(filePath);
+    assert(fileText.compare(0, 9, "existing\n") == 0);
+    assert(fileText.find("[INFO ] line 99\n") != std::string::npos);
+
+    // Rotation keeps whole entries and at most keep old files
+    const std::string rotPath = dir + "/rot.log";
+    {
+        LCBLog logger(std::make_shared<RotatingFileSink>(rotPath, 200, std::chrono::seconds(0), 2), nullptr);
+        for (int i = 0; i < 50; ++i)
+        {
+            logger.logS(INFO, "rotating entry", i);
+        }
+    }
+    std::string current = readFile(rotPath);
+    std::string older = readFile(rotPath + ".1");
+    std::string oldest = readFile(rotPath + ".2");
+    assert(!current.empty() && !older.empty() && !oldest.empty());
+    assert(readFile(rotPath + ".3").empty());
+    for (const std::string *part : {&current, &older, &oldest})
+    {
+        assert(part->size() <= 200);
+        assert(part->back() == '\n');
+        assert(part->compare(0, 8, "[INFO ] ") == 0);
+    }
+    assert(current.find("rotating entry 49\n") != std::string::npos);
+
+    for (const char *name : {"fd.log", "file.log", "rot.log", "rot.log.1", "rot.log.2"})
+    {
+        std::remove((dir + "/" + name).c_str());
+    }
+    ::rmdir(dir.c_str());
+}
+
+// Test that the io_uring sink, or its fallback, writes every entry in order
+void uringSinkTest()
+{
+    std::cout << "Testing io_uring file sink." << std::endl;
+
+    const std::string path = "/tmp/lcblog_uring_test_" + std::to_string(::getpid()) + ".log";
+    {
+        std::ofstream seed(path);
+        seed << "existing\n";
+    }
+    std::string expected = "existing\n";
+    {
+        // Small buffers force many submissions and waits for free buffers
+        auto sink = std::make_shared<UringFileSink>(path, 2, 256);
+        LCBLogConfig config;
+        config.overflowPolicy = BlockWithTimeout;
+        config.blockTimeout = std::chrono::milliseconds(5000);
+        LCBLog logger(sink, nullptr, config);
+        for (int i = 0; i < 2000; ++i)
+        {
+            logger.logS(INFO, "uring entry", i);
+            expected += "[INFO ] uring entry " + std::to_string(i) + "\n";
+        }
+    }
+    assert(readFile(path) == expected);
+    std::remove(path.c_str());
+}
+
+// Test that a mapped ring keeps the newest entries across reopen and wrap
+void mappedRingTest()
+{
+    std::cout << "Testing memory-mapped ring sink." << std::endl;
+
+    const std::string path = "/tmp/lcblog_ring_test_" + std::to_string(::getpid()) + ".ring";
+    std::remove(path.c_str());
+    LCBLogConfig config;
+    config.overflowPolicy = BlockWithTimeout;
+    config.blockTimeout = std::chrono::milliseconds(5000);
+    {
+        LCBLog logger(std::make_shared<MappedRingSink>(path, 4096), nullptr, config);
+        logger.logS(INFO, "first run");
+    }
+    std::string recovered;
+    assert(MappedRingSink::recover(path, recovered));
+    assert(recovered == "[INFO ] first run\n");
+
+    // Reopening appends; wrapping drops the oldest entries whole
+    {
+        LCBLog logger(std::make_shared<MappedRingSink>(path, 4096), nullptr, config);
+        for (int i = 0; i < 1000; ++i)
+        {
+            logger.logS(INFO, "entry", i);
+        }
+    }
+    recovered.clear();
+    assert(MappedRingSink::recover(path, recovered));
+    assert(recovered.size() <= 4096);
+    assert(recovered.compare(0, 8, "[INFO ] ") == 0);
+    const std::string tail = "[INFO ] entry 998\n[INFO ] entry 999\n";
+    assert(recovered.compare(recovered.size() - tail.size(), tail.size(), tail) == 0);
+    assert(recovered.find("first run") == std::string::npos);
+
+    // A corrupt length is not trusted: the writer starts the ring over
+    std::remove(path.c_str());
+    {
+        LCBLog logger(std::make_shared<MappedRingSink>(path, 4096), nullptr, config);
+        logger.logS(INFO, "first run");
+    }
+    {
+        // The only entry starts the data area, which ends the file
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-4096, std::ios::end);
+        file.write("\xff\xff\xff\x7f", 4);
+    }
+    {
+        LCBLog logger(std::make_shared<MappedRingSink>(path, 4096), nullptr, config);
+        for (int i = 0; i < 1000; ++i)
+        {
+            logger.logS(INFO, "entry", i);
+        }
+    }
+    recovered.clear();
+    assert(MappedRingSink::recover(path, recovered));
+    assert(recovered.size() <= 4096);
+    assert(recovered.compare(0, 8, "[INFO ] ") == 0);
+    assert(recovered.compare(recovered.size() - tail.size(), tail.size(), tail) == 0);
+
+    std::string error;
+    assert(!MappedRingSink::recover(path + ".missing", recovered, &error));
+    assert(!error.empty());
+    std::remove(path.c_str());
+}
+
+// Sink that keeps every entry it is given, optionally stalling first
+class CaptureSink : public LogSink
+{
+public:
+    void write(LogEntrySpan entries) override
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        cv.wait(lk, [this] { return !stalled; });
+        for (const LogEntry &e : entries)
+        {
+            texts.emplace_back(e.text());
+            buffers.push_back(e.shared);
+        }
+        cv.notify_all();
+    }
+
+    // Wait up to a second for count entries
+    bool waitFor(size_t count)
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        return cv.wait_for(lk, std::chrono::seconds(1), [&] { return texts.size() >= count; });
+    }
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lk(mtx);
+        stalled = false;
+        cv.notify_all();
+    }
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool stalled = false;
+    std::vector<std::string> texts;
+    std::vector<std::shared_ptr<const std::string>> buffers;
+};
+
+// Test fan-out through a routing table with per-sink levels and queues
+void routingTest()
+{
+    std::cout << "Testing multi-sink routing." << std::endl;
+
+    auto all = std::make_shared<CaptureSink>();
+    auto warn = std::make_shared<CaptureSink>();
+    auto error = std::make_shared<CaptureSink>();
+    error->stalled = true;
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{all, DEBUG, FATAL}, {warn, WARN, FATAL}, {error, ERROR, FATAL}}, config);
+        logger.logS(INFO, "info");
+        logger.logS(WARN, "warn");
+        logger.logS(ERROR, "error");
+
+        // A stalled sink does not hold up the others
+        assert(all->waitFor(3));
+        assert(warn->waitFor(2));
+        error->release();
+    }
+
+    assert((all->texts == std::vector<std::string>{"[INFO ] info\n", "[WARN ] warn\n", "[ERROR] error\n"}));
+    assert((warn->texts == std::vector<std::string>{"[WARN ] warn\n", "[ERROR] error\n"}));
+    assert((error->texts == std::vector<std::string>{"[ERROR] error\n"}));
+
+    // Formatted once: every sink saw the same buffer for the shared message
+    assert(error->buffers[0] != nullptr);
+    assert(error->buffers[0] == warn->buffers[1]);
+    assert(error->buffers[0] == all->buffers[2]);
+
+    // A message for a single route is copied into its slot as before
+    assert(all->buffers[0] == nullptr);
+
+    bool threw = false;
+    try
+    {
+        LCBLog bad({{all, ERROR, WARN}});
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// Test logfmt and JSON encoding of structured records
+void structuredLogTest()
+{
+    std::cout << "Testing structured key/value logging." << std::endl;
+
+    auto sink = std::make_shared<CaptureSink>();
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{sink}}, config);
+        logger.setLogLevel(DEBUG);
+        std::string user = "ada lovelace";
+        logger.logKV(INFO, "request done", kv("user", user), kv("latency_us", 125), kv("ok", true),
+                     kv("ratio", 0.5), kv("path", "/a=b"), kv("bad key", "x"), kv("empty", ""));
+        logger.logKV(DEBUG, "  spaced   out  ", kv("n", nullptr), kv("inf", std::numeric_limits<double>::infinity()));
+
+        config.kvFormat = KVJson;
+        logger.setConfig(config);
+        logger.logKV(WARN, "quote \"and\" slash \\", kv("user", user), kv("latency_us", 125),
+                     kv("ok", false), kv("ratio", 0.5), kv("tab", "a\tb\n"), kv("ctl", std::string(1, '\x01')),
+                     kv("n", nullptr), kv("lazy", lazy([] { return 7; })));
+        logger.logKV(ERROR, "bare");
+        logger.enableTimestamps(true);
+        logger.logKV(INFO, "stamped");
+        assert(sink->waitFor(5));
+    }
+
+    assert(sink->texts[0] == "level=INFO msg=\"request done\" user=\"ada lovelace\" latency_us=125 ok=true "
+                             "ratio=0.5 path=\"/a=b\" bad_key=x empty=\"\"\n");
+    assert(sink->texts[1] == "level=DEBUG msg=\"  spaced   out  \" n=null inf=inf\n");
+    assert(sink->texts[2] == "{\"level\":\"WARN\",\"msg\":\"quote \\\"and\\\" slash \\\\\",\"user\":\"ada lovelace\","
+                             "\"latency_us\":125,\"ok\":false,\"ratio\":0.5,\"tab\":\"a\\tb\\n\",\"ctl\":\"\\u0001\","
+                             "\"n\":null,\"lazy\":7}\n");
+    assert(sink->texts[3] == "{\"level\":\"ERROR\",\"msg\":\"bare\"}\n");
+    assert(sink->texts[4].rfind("{\"ts\":\"", 0) == 0);
+    assert(sink->texts[4].find(" UTC\",\"level\":\"INFO\",\"msg\":\"stamped\"}\n") != std::string::npos);
+}
+
+// Test per-thread producer queues, their merge order, and thread-exit handoff
+void perThreadQueueTest()
+{
+    std::cout << "Testing per-thread producer queues." << std::endl;
+
+    LCBLogConfig config;
+    config.flushInterval = std::chrono::milliseconds(1);
+    config.overflowPolicy = BlockWithTimeout;
+    config.blockTimeout = std::chrono::milliseconds(5000);
+    config.perThreadQueues = true;
+    config.threadQueueCapacity = 8;
+
+    // Threads exit before the worker sees their entries; the merge restores order
+    auto merged = std::make_shared<CaptureSink>();
+    merged->stalled = true;
+    {
+        LCBLog logger({{merged}}, config);
+        for (int i = 0; i < 8; ++i)
+        {
+            std::thread([&logger, i] { logger.logS(INFO, "m", i); }).join();
+        }
+        merged->release();
+        assert(merged->waitFor(8));
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        assert(merged->texts[i] == "[INFO ] m " + std::to_string(i) + "\n");
+    }
+
+    // Concurrent producers lose nothing and keep their own order
+    const int threads = 4;
+    const int perThread = 500;
+    auto all = std::make_shared<CaptureSink>();
+    {
+        LCBLog logger({{all}}, config);
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t)
+        {
+            producers.emplace_back([&logger, t]
+                                   {
+                                       for (int i = 0; i < perThread; ++i)
+                                       {
+                                           logger.logS(INFO, t, i);
+                                       }
+                                   });
+        }
+        for (auto &p : producers)
+        {
+            p.join();
+        }
+    }
+    assert(all->texts.size() == static_cast<size_t>(threads * perThread));
+    std::vector<int> next(threads, 0);
+    for (const std::string &text : all->texts)
+    {
+        int t = 0;
+        int i = 0;
+        assert(std::sscanf(text.c_str(), "[INFO ] %d %d", &t, &i) == 2);
+        assert(i == next[t]);
+        ++next[t];
+    }
+
+    // Drops in thread queues are counted, even after the thread exits
+    auto stalled = std::make_shared<CaptureSink>();
+    stalled->stalled = true;
+    {
+        LCBLogConfig dropping = config;
+        dropping.overflowPolicy = DropNewest;
+        LCBLog logger({{stalled}}, dropping);
+        std::thread([&logger]
+                    {
+                        for (int i = 0; i < 100; ++i)
+                        {
+                            logger.logS(INFO, "d", i);
+                        }
+                    })
+            .join();
+        // At most a batch, one merge lookahead, and a full queue are kept
+        assert(logger.droppedCount() >= 100 - dropping.batchSize - 1 - dropping.threadQueueCapacity);
+        stalled->release();
+    }
+
+    // A new logger gets a new queue on a thread that used an old one
+    for (int round = 0; round < 2; ++round)
+    {
+        auto sink = std::make_shared<CaptureSink>();
+        {
+            LCBLog logger({{sink}}, config);
+            logger.logS(INFO, "round", round);
+        }
+        assert((sink->texts == std::vector<std::string>{"[INFO ] round " + std::to_string(round) + "\n"}));
+    }
+}
+
+// Test that settings can change while other threads are logging
+void hotConfigTest()
+{
+    std::cout << "Testing settings changes during logging." << std::endl;
+
+    auto sink = std::make_shared<CaptureSink>();
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        config.overflowPolicy = BlockWithTimeout;
+        config.blockTimeout = std::chrono::milliseconds(5000);
+        LCBLog logger({{sink}}, config);
+
+        std::atomic<bool> stop{false};
+        std::atomic<int> calls{0};
+        std::thread producer([&]
+                             {
+                                 while (!stop.load())
+                                 {
+                                     logger.logS(WARN, "tick");
+                                     calls.fetch_add(1);
+                                 }
+                             });
+        for (int i = 0; i < 200; ++i)
+        {
+            logger.setLogLevel(i % 2 ? ERROR : DEBUG);
+            logger.enableTimestamps(i % 3 == 0);
+            logger.enableNormalization(i % 5 != 0);
+            // Let the producer make a few calls under each setting
+            for (int seen = calls.load(); calls.load() < seen + 3;)
+            {
+                std::this_thread::yield();
+            }
+        }
+        stop.store(true);
+        producer.join();
+
+        // A level change takes effect on the next call
+        logger.setLogLevel(ERROR);
+        assert(!logger.shouldLog(WARN));
+        logger.setLogLevel(WARN);
+        assert(logger.shouldLog(WARN));
+    }
+
+    assert(!sink->texts.empty());
+    for (const std::string &text : sink->texts)
+    {
+        const std::string line = "[WARN ] tick\n";
+        assert(text.size() >= line.size() && text.compare(text.size() - line.size(), line.size(), line) == 0);
+    }
+}
+
+// Test per-tag thresholds, inheritance, and prefixes
+void tagLevelTest()
+{
+    std::cout << "Testing per-tag log levels." << std::endl;
+
+    auto sink = std::make_shared<CaptureSink>();
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{sink}}, config);
+        LogTag rf = logger.tag("rf");
+        LogTag net = logger.tag("net");
+        assert(rf.name() == "rf");
+
+        // Tags follow the logger's level until given their own
+        rf.logS(DEBUG, "hidden");
+        logger.setTagLevel("rf", DEBUG);
+        rf.logS(DEBUG, "tuned", 7);
+        net.logS(DEBUG, "hidden");
+        logger.logS(DEBUG, "hidden");
+        net.logS(INFO, "up");
+
+        logger.setLogLevel(WARN);
+        assert(!net.shouldLog(INFO));
+        assert(rf.shouldLog(DEBUG));
+
+        // Handles looked up again share the same state
+        logger.tag("rf").logS(DEBUG, "again");
+        logger.resetTagLevel("rf");
+        assert(!rf.shouldLog(INFO));
+        LCBLOG_S(rf, WARN, "macro");
+        LCBLOG_FMT(rf, WARN, "gain {} dB", 12);
+        LCBLOG_FMT(net, INFO, "hidden {}", 0);
+        assert(sink->waitFor(5));
+    }
+
+    assert((sink->texts == std::vector<std::string>{"[DEBUG] rf: tuned 7\n", "[INFO ] net: up\n",
+                                                    "[DEBUG] rf: again\n", "[WARN ] rf: macro\n",
+                                                    "[WARN ] rf: gain 12 dB\n"}));
+}
+
+// Test per-call-site rate limits and folding of repeated messages
+void rateLimitTest()
+{
+    std::cout << "Testing rate limiting and repeat folding." << std::endl;
+
+    bool threw = false;
+    try
+    {
+        LogRateLimit bad(0.0);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    // A burst of three, then nothing until the next token a second later
+    LogRateLimit limit(1.0, 3);
+    int allowed = 0;
+    for (int i = 0; i < 10; ++i)
+    {
+        allowed += limit.allow() ? 1 : 0;
+    }
+    assert(allowed == 3);
+    assert(limit.takeSuppressed() == 7);
+    assert(limit.takeSuppressed() == 0);
+
+    auto limited = std::make_shared<CaptureSink>();
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{limited}}, config);
+        auto busy = [&](int i) { LCBLOG_LIMIT(logger, WARN, 20.0, 1, "busy", i); };
+        for (int i = 0; i < 5; ++i)
+        {
+            busy(i);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        for (int i = 5; i < 7; ++i)
+        {
+            busy(i);
+        }
+
+        // The trailing refusal is reported once the window passes
+        assert(limited->waitFor(4));
+    }
+    assert((limited->texts == std::vector<std::string>{"[WARN ] busy 0\n", "[WARN ] 4 similar messages suppressed\n",
+                                                       "[WARN ] busy 5\n", "[WARN ] 1 similar messages suppressed\n"}));
+
+    // Refusals still inside the window are reported when the limiter or the
+    // logger goes away, with the tag
+    auto tagged = std::make_shared<CaptureSink>();
+    {
+        LogRateLimit lasting(0.001, 1);
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{tagged}}, config);
+        LogTag net = logger.tag("net");
+        LogRateLimit slow(0.001, 1);
+        for (int i = 0; i < 3; ++i)
+        {
+            net.logLimited(slow, ERROR, "timeout", i);
+        }
+        for (int i = 0; i < 2; ++i)
+        {
+            net.logLimited(lasting, WARN, "retry", i);
+        }
+    }
+    assert((tagged->texts == std::vector<std::string>{"[ERROR] net: timeout 0\n", "[WARN ] net: retry 0\n",
+                                                      "[ERROR] net: 2 similar messages suppressed\n",
+                                                      "[WARN ] net: 1 similar messages suppressed\n"}));
+
+    // Repeats fold into a count, ignoring timestamps, in text and packed form
+    for (bool deferred : {false, true})
+    {
+        auto folded = std::make_shared<CaptureSink>();
+        {
+            LCBLogConfig config;
+            config.flushInterval = std::chrono::milliseconds(1000);
+            config.collapseRepeats = true;
+            config.deferredFormatting = deferred;
+            LCBLog logger({{folded}}, config);
+            logger.enableTimestamps(true);
+            for (int i = 0; i < 5; ++i)
+            {
+                logger.logS(ERROR, "disk full");
+            }
+            logger.logS(INFO, "recovered");
+            logger.logS(INFO, "recovered");
+        }
+        std::vector<std::string> lines;
+        for (const std::string &text : folded->texts)
+        {
+            lines.push_back(text.substr(text.find('[')));
+        }
+        assert((lines == std::vector<std::string>{"[ERROR] disk full\n", "[ERROR] last message repeated 4 times\n",
+                                                  "[INFO ] recovered\n", "[INFO ] last message repeated 1 times\n"}));
+    }
+}
+
+// Test the stats snapshot and the periodic self-report
+void statsTest()
+{
+    std::cout << "Testing logger statistics." << std::endl;
+
+    auto sink = std::make_shared<CaptureSink>();
+    auto reports = std::make_shared<CaptureSink>();
+    sink->stalled = true;
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        config.statsInterval = std::chrono::milliseconds(20);
+        config.statsSink = reports;
+        LCBLog logger({{sink}}, config);
+
+        // The first message holds the worker in write() while the rest queue up
+        logger.logS(INFO, "first");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        for (int i = 0; i < 9; ++i)
+        {
+            logger.logS(INFO, "queued", i);
+        }
+        sink->release();
+        assert(sink->waitFor(10));
+
+        LogStats stats;
+        for (int tries = 0; tries < 1000; ++tries)
+        {
+            stats = logger.stats();
+            if (stats.total.written == 10)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        uint64_t bytes = 0;
+        for (const std::string &text : sink->texts)
+        {
+            bytes += text.size();
+        }
+        assert(stats.routes.size() == 1);
+        assert(stats.total.enqueued == 10);
+        assert(stats.total.written == 10);
+        assert(stats.total.dropped == 0);
+        assert(stats.total.bytesWritten == bytes);
+        assert(stats.total.batches >= 2 && stats.total.batches <= 10);
+        assert(stats.total.highWater >= 9);
+        assert(stats.total.writeTime >= std::chrono::milliseconds(40));
+
+        assert(reports->waitFor(1));
+    }
+    assert(reports->texts[0].rfind("level=INFO msg=\"lcblog stats\" route=0 enqueued=", 0) == 0);
+    assert(reports->texts[0].find(" write_us=") != std::string::npos);
+
+    // Retuning the interval takes effect at once, including after a pause
+    auto retuned = std::make_shared<CaptureSink>();
+    {
+        LCBLogConfig config;
+        config.statsInterval = std::chrono::seconds(60);
+        config.statsSink = retuned;
+        LCBLog logger({{sink}}, config);
+        config.statsInterval = std::chrono::milliseconds(10);
+        logger.setConfig(config);
+        assert(retuned->waitFor(1));
+
+        config.statsInterval = std::chrono::milliseconds(0);
+        logger.setConfig(config);
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        size_t seen;
+        {
+            std::lock_guard<std::mutex> lk(retuned->mtx);
+            seen = retuned->texts.size();
+        }
+        config.statsInterval = std::chrono::milliseconds(10);
+        logger.setConfig(config);
+        assert(retuned->waitFor(seen + 1));
+    }
+}
+
+// Test flush barriers and the bounded shutdown drain
+void flushTest()
+{
+    std::cout << "Testing flush and shutdown deadline." << std::endl;
+
+    // Nothing would be written for ten seconds without the barrier
+    for (bool perThread : {false, true})
+    {
+        auto sink = std::make_shared<CaptureSink>();
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::seconds(10);
+        config.batchSize = 1000;
+        config.perThreadQueues = perThread;
+        LCBLog logger({{sink}}, config);
+        logger.logS(INFO, "one");
+        std::thread other([&] { logger.logS(INFO, "two"); });
+        other.join();
+        logger.flush();
+        {
+            std::lock_guard<std::mutex> lk(sink->mtx);
+            assert(sink->texts.size() == 2);
+        }
+        assert(logger.flushFor(std::chrono::milliseconds(100)));
+    }
+
+    // A stalled sink times the barrier out until it is released
+    {
+        auto sink = std::make_shared<CaptureSink>();
+        sink->stalled = true;
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{sink}}, config);
+        logger.logS(INFO, "held");
+        assert(!logger.flushFor(std::chrono::milliseconds(20)));
+        sink->release();
+        assert(logger.flushFor(std::chrono::seconds(1)));
+        assert(sink->texts.size() == 1);
+    }
+
+    // Past the shutdown deadline the backlog is dropped, not written
+    auto sink = std::make_shared<CaptureSink>();
+    sink->stalled = true;
+    std::thread releaser;
+    {
+        LCBLogConfig config;
+        config.batchSize = 1;
+        config.flushInterval = std::chrono::milliseconds(1);
+        config.shutdownTimeout = std::chrono::milliseconds(20);
+        LCBLog logger({{sink}}, config);
+        for (int i = 0; i < 50; ++i)
+        {
+            logger.logS(INFO, "backlog", i);
+        }
+        releaser = std::thread([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            sink->release();
+        });
+    }
+    releaser.join();
+    assert(sink->texts.size() < 50);
+    assert(sink->texts.back().find("messages dropped") != std::string::npos);
+
+    LCBLogConfig config;
+    config.shutdownTimeout = std::chrono::milliseconds(-1);
+    bool threw = false;
+    try
+    {
+        config.validate();
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+// Descriptor sink whose writes never return, so entries stay queued
+class StuckFdSink : public FdSink
+{
+public:
+    using FdSink::FdSink;
+
+    void write(LogEntrySpan) override
+    {
+        for (;;)
+        {
+            pause();
+        }
+    }
+};
+
+// Test that a crash writes what is still queued to the sink's descriptor
+void crashHandlerTest()
+{
+    std::cout << "Testing crash dump of queued entries." << std::endl;
+
+    int fds[2];
+    assert(pipe(fds) == 0);
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0)
+    {
+        close(fds[0]);
+        LCBLogConfig config;
+        config.crashHandler = true;
+        config.batchSize = 1;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{std::make_shared<StuckFdSink>(fds[1])}}, config);
+
+        // The worker takes the first entry into write() and never returns
+        logger.logS(INFO, "taken");
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        logger.logS(WARN, "queued", 1);
+        logger.logS(ERROR, "queued", 2);
+        abort();
+    }
+
+    close(fds[1]);
+    std::string out;
+    char buf[256];
+    ssize_t n;
+    while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+    {
+        out.append(buf, static_cast<size_t>(n));
+    }
+    close(fds[0]);
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+    assert(out == "[FATAL] Caught signal " + std::to_string(SIGABRT) +
+                      ", writing queued log entries\n[WARN ] queued 1\n[ERROR] queued 2\n");
+}
+
+// Sink that only counts what reaches it
+class CountingSink : public LogSink
+{
+public:
+    void write(LogEntrySpan entries) override
+    {
+        count.fetch_add(entries.count, std::memory_order_release);
+    }
+
+    std::atomic<size_t> count{0};
+};
+
+// Test that steady-state logging, fan-out included, stays off the allocator
+void pooledBufferTest()
+{
+    std::cout << "Testing pooled queue buffers." << std::endl;
+
+    auto first = std::make_shared<CountingSink>();
+    auto second = std::make_shared<CountingSink>();
+    LCBLogConfig config;
+    config.queueCapacity = 64;
+    config.flushInterval = std::chrono::milliseconds(1);
+    LCBLog logger({{first}, {second}}, config);
+
+    size_t expected = 0;
+    auto burst = [&]()
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            logger.logS(INFO, "a message longer than the short string buffer", i);
+        }
+        expected += 16;
+        while (first->count.load(std::memory_order_acquire) < expected ||
+               second->count.load(std::memory_order_acquire) < expected)
+        {
+            std::this_thread::yield();
+        }
+    };
+
+    // Let every slot and pooled buffer see a message, then require no further allocations
+    for (int i = 0; i < 20; ++i)
+    {
+        burst();
+    }
+    size_t before = threadAllocations;
+    for (int i = 0; i < 50; ++i)
+    {
+        burst();
+    }
+    assert(threadAllocations == before);
+    assert(logger.droppedCount() == 0);
+}
+
+// Test compile-time format strings against the component API
+void formatStringTest()
+{
+    std::cout << "Testing compile-time format strings." << std::endl;
+
+    static_assert(logFmtCount("Value {} and {}") == 2);
+    static_assert(logFmtCount("{{}} only braces") == 0);
+    static_assert(logFmtCount("{x}") == logFmtInvalid);
+    static_assert(logFmtCount("stray }") == logFmtInvalid);
+    static_assert(logFmtCount("open {") == logFmtInvalid);
+
+    for (bool deferred : {false, true})
+    {
+        auto sink = std::make_shared<CaptureSink>();
+        {
+            LCBLogConfig config;
+            config.flushInterval = std::chrono::milliseconds(1);
+            config.deferredFormatting = deferred;
+            LCBLog logger({{sink}}, config);
+            LCBLOG_FMT(logger, INFO, "Value {} and {}", 42, 3.5);
+            logger.logS(INFO, "Value", 42, "and", 3.5);
+            LCBLOG_FMT(logger, WARN, "{{{}}} is {}", 7, 100.0);
+            LCBLOG_FMT(logger, ERROR, "plain text");
+            LCBLOG_FMT(logger, INFO, "a {}\nb {}", 'x', lazy([] { return std::string("late"); }));
+            LCBLOG_FMT(logger, DEBUG, "filtered {}", 1);
+        }
+        assert((sink->texts == std::vector<std::string>{"[INFO ] Value 42 and 3.5\n", "[INFO ] Value 42 and 3.5\n",
+                                                        "[WARN ] {7} is 100.0\n", "[ERROR] plain text\n",
+                                                        "[INFO ] a x\n[INFO ] b late\n"}));
+    }
+}
+
+// Receive one datagram, waiting at most a second
+static std::string receiveDatagram(int fd)
+{
+    char buf[4096];
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    return n < 0 ? std::string() : std::string(buf, static_cast<size_t>(n));
+}
+
+// Bind a datagram socket at a fresh Unix path
+static int bindUnixDatagram(const std::string &path)
+{
+    unlink(path.c_str());
+    int fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+    struct sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, path.c_str());
+    assert(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+    struct timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+// Bind a socket of the given type on a free loopback port
+static int bindLoopback(int type, uint16_t &port)
+{
+    int fd = socket(AF_INET, type, 0);
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0);
+    socklen_t size = sizeof(addr);
+    getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &size);
+    port = ntohs(addr.sin_port);
+    struct timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    return fd;
+}
+
+// Test the syslog, journal, UDP, and TCP sinks against local listeners
+void networkSinkTest()
+{
+    std::cout << "Testing syslog, journald, and network sinks." << std::endl;
+
+    std::vector<LogEntry> batch(2);
+    batch[0].level = INFO;
+    batch[0].msg = "[INFO ] hello\n";
+    batch[1].level = ERROR;
+    batch[1].msg = "[ERROR] a\n[ERROR] b\n";
+    const LogEntrySpan span{batch.data(), batch.size()};
+
+    // RFC 5424 over a Unix datagram socket, severity from the level
+    const std::string syslogPath = "/tmp/lcblog_test_syslog.sock";
+    int syslogFd = bindUnixDatagram(syslogPath);
+    {
+        SyslogSink sink("app", 1, syslogPath);
+        sink.write(span);
+    }
+    std::string first = receiveDatagram(syslogFd);
+    std::string second = receiveDatagram(syslogFd);
+    const std::string tail = " app " + std::to_string(getpid()) + " - - ";
+    assert(first.rfind("<14>1 - ", 0) == 0);
+    assert(first.size() > tail.size() && first.find(tail + "[INFO ] hello") == first.size() - tail.size() - 13);
+    assert(second.rfind("<11>1 - ", 0) == 0);
+    assert(second.find(tail + "[ERROR] a\n[ERROR] b") != std::string::npos);
+    close(syslogFd);
+    unlink(syslogPath.c_str());
+
+    // Journal native protocol with a length-prefixed MESSAGE field
+    const std::string journalPath = "/tmp/lcblog_test_journal.sock";
+    int journalFd = bindUnixDatagram(journalPath);
+    {
+        JournaldSink sink("app", journalPath);
+        sink.write(span);
+    }
+    auto journalRecord = [](char priority, const std::string &message)
+    {
+        std::string record = std::string("PRIORITY=") + priority + "\nSYSLOG_IDENTIFIER=app\nMESSAGE\n";
+        record.push_back(static_cast<char>(message.size()));
+        record.append(7, '\0');
+        return record + message + "\n";
+    };
+    assert(receiveDatagram(journalFd) == journalRecord('6', "[INFO ] hello"));
+    assert(receiveDatagram(journalFd) == journalRecord('3', "[ERROR] a\n[ERROR] b"));
+    close(journalFd);
+    unlink(journalPath.c_str());
+
+    // One UDP datagram per entry, fed by a logger's worker
+    uint16_t port = 0;
+    int udpFd = bindLoopback(SOCK_DGRAM, port);
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        LCBLog logger({{std::make_shared<UdpSink>("127.0.0.1", port)}}, config);
+        logger.logS(INFO, "over", "udp");
+        logger.logS(WARN, "second");
+    }
+    assert(receiveDatagram(udpFd) == "[INFO ] over udp\n");
+    assert(receiveDatagram(udpFd) == "[WARN ] second\n");
+    close(udpFd);
+
+    // TCP streams the batch, and a lost collector does not raise SIGPIPE
+    int listenFd = bindLoopback(SOCK_STREAM, port);
+    assert(listen(listenFd, 1) == 0);
+    TcpSink tcp("127.0.0.1", port);
+    tcp.write(span);
+    int conn = accept(listenFd, nullptr, nullptr);
+    assert(conn >= 0);
+    std::string received;
+    const std::string expected = "[INFO ] hello\n[ERROR] a\n[ERROR] b\n";
+    while (received.size() < expected.size())
+    {
+        char buf[256];
+        ssize_t n = recv(conn, buf, sizeof(buf), 0);
+        assert(n > 0);
+        received.append(buf, static_cast<size_t>(n));
+    }
+    assert(received == expected);
+    close(conn);
+    close(listenFd);
+    for (int i = 0; i < 3; ++i)
+    {
+        tcp.write(span);
+    }
+}
+
+// Find the ID of this process's thread with the given name, or 0
+pid_t findThread(const std::string &name)
+{
+    pid_t found = 0;
+    DIR *dir = opendir("/proc/self/task");
+    assert(dir != nullptr);
+    while (dirent *entry = readdir(dir))
+    {
+        std::ifstream comm(std::string("/proc/self/task/") + entry->d_name + "/comm");
+        std::string line;
+        if (entry->d_name[0] != '.' && std::getline(comm, line) && line == name)
+        {
+            found = static_cast<pid_t>(std::atoi(entry->d_name));
+        }
+    }
+    closedir(dir);
+    return found;
+}
+
+// Test worker thread names, affinity, nice values, and spinning before parking
+void workerTuningTest()
+{
+    std::cout << "Testing worker thread settings." << std::endl;
+
+    // Naming is opt-in, so existing thread names are left alone
+    assert(LCBLogConfig().threadName.empty());
+
+    auto first = std::make_shared<CaptureSink>();
+    auto second = std::make_shared<CaptureSink>();
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        config.threadName = "tuned";
+        config.workerCpus = {0};
+        config.workerNice = 5;
+        config.workerSpin = std::chrono::microseconds(500);
+        LCBLog logger({{first}, {second}}, config);
+        for (int i = 0; i < 100; ++i)
+        {
+            logger.logS(INFO, "spun", i);
+        }
+        assert(first->waitFor(100) && second->waitFor(100));
+
+        for (const char *name : {"tuned-0", "tuned-1"})
+        {
+            const pid_t tid = findThread(name);
+            assert(tid != 0);
+            assert(getpriority(PRIO_PROCESS, static_cast<id_t>(tid)) == 5);
+            std::ifstream status("/proc/self/task/" + std::to_string(tid) + "/status");
+            std::string line;
+            bool pinned = false;
+            while (std::getline(status, line))
+            {
+                pinned = pinned || line == "Cpus_allowed_list:\t0";
+            }
+            assert(pinned);
+        }
+
+        // Messages sent after the spin has decayed still wake the worker
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        logger.logS(INFO, "after idle");
+        assert(first->waitFor(101));
+    }
+    for (const std::string &text : first->texts)
+    {
+        assert(text.find("kept default") == std::string::npos);
+    }
+
+    // Long prefixes are cut so the index still fits
+    {
+        LCBLogConfig config;
+        config.threadName = "averyverylongprefix";
+        LCBLog logger({{first}}, config);
+        logger.flush();
+        assert(findThread("averyverylong-0") != 0);
+    }
+
+    // A core the host lacks is reported, and the worker still runs
+    auto refused = std::make_shared<CaptureSink>();
+    {
+        LCBLogConfig config;
+        config.workerCpus = {CPU_SETSIZE - 1};
+        LCBLog logger({{refused}}, config);
+        logger.logS(INFO, "still written");
+        assert(refused->waitFor(2));
+    }
+    auto written = [&](const char *text)
+    {
+        return std::any_of(refused->texts.begin(), refused->texts.end(),
+                           [&](const std::string &t) { return t.find(text) != std::string::npos; });
+    };
+    assert(written("[WARN ] Worker 0 kept default thread settings for affinity: Invalid argument"));
+    assert(written("still written"));
+
+    auto rejects = [](void (*change)(LCBLogConfig &))
+    {
+        LCBLogConfig config;
+        change(config);
+        try
+        {
+            config.validate();
+        }
+        catch (const std::invalid_argument &)
+        {
+            return true;
+        }
+        return false;
+    };
+    assert(rejects([](LCBLogConfig &c) { c.workerCpus = {-1}; }));
+    assert(rejects([](LCBLogConfig &c) { c.workerNice = 20; }));
+    assert(rejects([](LCBLogConfig &c) { c.workerRealtimePriority = 100; }));
+    assert(rejects([](LCBLogConfig &c) { c.workerSpin = std::chrono::microseconds(-1); }));
+}
+
+// Count this process's threads
+size_t threadCount()
+{
+    size_t count = 0;
+    DIR *dir = opendir("/proc/self/task");
+    assert(dir != nullptr);
+    while (dirent *entry = readdir(dir))
+    {
+        count += entry->d_name[0] != '.';
+    }
+    closedir(dir);
+    return count;
+}
+
+// Sink that flushes another logger from inside write()
+class FlushingSink : public LogSink
+{
+public:
+    void write(LogEntrySpan entries) override
+    {
+        if (target != nullptr && entries.size() > 0)
+        {
+            refused = refused || !target->flushFor(std::chrono::seconds(1));
+        }
+    }
+
+    LCBLog *target = nullptr;
+    bool refused = false;
+};
+
+// Test loggers whose routes share executor threads
+void sharedExecutorTest()
+{
+    std::cout << "Testing shared executor." << std::endl;
+
+    auto workers = std::make_shared<LogExecutor>(2, "lcbexec");
+    assert(workers->threads() == 2);
+    for (int i = 0; i < 100 && (findThread("lcbexec-0") == 0 || findThread("lcbexec-1") == 0); ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(findThread("lcbexec-0") != 0 && findThread("lcbexec-1") != 0);
+
+    LCBLogConfig config;
+    config.flushInterval = std::chrono::milliseconds(1);
+    config.executor = workers;
+    std::vector<std::shared_ptr<CaptureSink>> sinks;
+    {
+        const size_t before = threadCount();
+        std::vector<std::unique_ptr<LCBLog>> loggers;
+        for (int i = 0; i < 8; ++i)
+        {
+            sinks.push_back(std::make_shared<CaptureSink>());
+            loggers.push_back(std::make_unique<LCBLog>(std::vector<LogRoute>{{sinks.back()}}, config));
+        }
+        assert(threadCount() == before);
+
+        // Every logger is served, and flush() waits for its own messages
+        std::thread producer([&]()
+                             {
+                                 for (int n = 0; n < 100; ++n)
+                                 {
+                                     for (auto &logger : loggers)
+                                     {
+                                         logger->logS(INFO, "shared", n);
+                                     }
+                                 }
+                             });
+        producer.join();
+        for (size_t i = 0; i < loggers.size(); ++i)
+        {
+            assert(loggers[i]->flushFor(std::chrono::seconds(5)));
+            assert(sinks[i]->texts.size() == 100);
+            assert(sinks[i]->texts[99].find("shared 99") != std::string::npos);
+        }
+
+        // Messages still queued at destruction are drained
+        for (auto &logger : loggers)
+        {
+            logger->logS(INFO, "last");
+        }
+    }
+    for (const auto &sink : sinks)
+    {
+        assert(sink->texts.size() == 101);
+    }
+
+    // A sink running on an executor thread cannot wait for a flush
+    auto flushing = std::make_shared<FlushingSink>();
+    {
+        LCBLog target(std::vector<LogRoute>{{std::make_shared<CaptureSink>()}}, config);
+        LCBLog logger(std::vector<LogRoute>{{flushing}}, config);
+        flushing->target = &target;
+        logger.logS(INFO, "flush from the executor");
+        assert(logger.flushFor(std::chrono::seconds(5)));
+    }
+    assert(flushing->refused);
+
+    bool threw = false;
+    try
+    {
+        LogExecutor none(0);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+#if defined(LCBLOG_WITH_ZLIB)
+// Decompress concatenated gzip members, counting the complete ones; an
+// unfinished or damaged tail yields what decodes up to the break
+static std::string gunzip(const std::string &data, size_t &members)
+{
+    std::string out;
+    members = 0;
+    z_stream z{};
+    assert(inflateInit2(&z, 15 + 16) == Z_OK);
+    z.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    z.avail_in = static_cast<uInt>(data.size());
+    std::string member;
+    while (z.avail_in > 0)
+    {
+        Bytef chunk[4096];
+        z.next_out = chunk;
+        z.avail_out = sizeof(chunk);
+        const int rc = inflate(&z, Z_NO_FLUSH);
+        member.append(reinterpret_cast<char *>(chunk), sizeof(chunk) - z.avail_out);
+        if (rc == Z_STREAM_END)
+        {
+            out += member;
+            member.clear();
+            ++members;
+            inflateReset(&z);
+        }
+        else if (rc != Z_OK)
+        {
+            break;
+        }
+    }
+    inflateEnd(&z);
+    return out + member;
+}
+#endif
+
+// Test gzip compression in front of file sinks
+void gzipSinkTest()
+{
+    std::cout << "Testing gzip sink." << std::endl;
+#if defined(LCBLOG_WITH_ZLIB)
+    const std::string dir = "/tmp/lcblog_gzip_test_" + std::to_string(::getpid());
+    assert(::mkdir(dir.c_str(), 0755) == 0);
+
+    // A burst stays in one member, and repetitive text shrinks a lot
+    const std::string path = dir + "/app.log.gz";
+    std::string expected;
+    {
+        LCBLogConfig config;
+        config.flushInterval = std::chrono::milliseconds(1);
+        config.queueCapacity = 4096;
+        LCBLog logger(std::vector<LogRoute>{{std::make_shared<GzipSink>(std::make_shared<FileSink>(path))}}, config);
+        logger.setLogLevel(DEBUG);
+        for (int i = 0; i < 2000; ++i)
+        {
+            logger.logS(DEBUG, "[net] polling socket", i % 10, "for readiness");
+            expected += "[DEBUG] [net] polling socket " + std::to_string(i % 10) + " for readiness\n";
+        }
+        logger.flush();
+        logger.logS(DEBUG, "after the flush");
+        expected += "[DEBUG] after the flush\n";
+    }
+    std::string compressed = readFile(path);
+    size_t members = 0;
+    assert(gunzip(compressed, members) == expected);
+    assert(members == 1);
+    assert(compressed.size() * 10 < expected.size());
+
+    // At a low rate every line is flushed on its own; sync points keep the
+    // file readable after each one without giving up the dictionary
+    const std::string slowPath = dir + "/slow.log.gz";
+    expected.clear();
+    {
+        LCBLog logger(std::vector<LogRoute>{{std::make_shared<GzipSink>(std::make_shared<FileSink>(slowPath))}});
+        logger.setLogLevel(DEBUG);
+        for (int i = 0; i < 60; ++i)
+        {
+            logger.logS(DEBUG, "[net] polling socket", i % 10, "for readiness");
+            expected += "[DEBUG] [net] polling socket " + std::to_string(i % 10) + " for readiness\n";
+            logger.flush();
+            assert(gunzip(readFile(slowPath), members) == expected);
+            assert(members == 0);
+        }
+    }
+    compressed = readFile(slowPath);
+    assert(gunzip(compressed, members) == expected);
+    assert(members == 1);
+    assert(compressed.size() * 3 < expected.size());
+
+    // Members close at frameBytes, and a truncated file keeps what precedes the cut
+    const std::string framedPath = dir + "/framed.log.gz";
+    expected.clear();
+    {
+        LCBLog logger(std::vector<LogRoute>{{std::make_shared<GzipSink>(std::make_shared<FileSink>(framedPath), 9, 1000)}});
+        for (int i = 0; i < 500; ++i)
+        {
+            logger.logS(INFO, "framed entry", i);
+            expected += "[INFO ] framed entry " + std::to_string(i) + "\n";
+        }
+    }
+    compressed = readFile(framedPath);
+    assert(gunzip(compressed, members) == expected);
+    assert(members >= expected.size() / 1000);
+    const size_t whole = members;
+    const std::string recovered = gunzip(compressed.substr(0, compressed.size() - 5), members);
+    assert(members == whole - 1);
+    assert(!recovered.empty() && expected.compare(0, recovered.size(), recovered) == 0);
+
+    // Rotated files decompress when joined in order
+    const std::string rotPath = dir + "/rot.log.gz";
+    expected.clear();
+    {
+        auto files = std::make_shared<RotatingFileSink>(rotPath, 300, std::chrono::seconds(0), 20);
+        LCBLog logger(std::vector<LogRoute>{{std::make_shared<GzipSink>(files, 6, 500)}});
+        for (int i = 0; i < 300; ++i)
+        {
+            logger.logS(INFO, "rotated entry", i);
+            expected += "[INFO ] rotated entry " + std::to_string(i) + "\n";
+        }
+    }
+    std::string joined;
+    for (int i = 20; i >= 0; --i)
+    {
+        joined += readFile(i == 0 ? rotPath : rotPath + "." + std::to_string(i));
+    }
+    assert(!readFile(rotPath + ".1").empty());
+    assert(gunzip(joined, members) == expected);
+
+    {
+        GzipSink stored(std::make_shared<FileSink>(dir + "/bad.gz"), 0);
+    }
+    bool threw = false;
+    try
+    {
+        GzipSink bad(std::make_shared<FileSink>(dir + "/bad.gz"), 10);
+    }
+    catch (const std::invalid_argument &)
+    {
+        threw = true;
+    }
+    assert(threw);
+
+    for (const std::string &file : {path, slowPath, framedPath, rotPath, dir + "/bad.gz"})
+    {
+        std::remove(file.c_str());
+    }
+    for (int i = 1; i <= 20; ++i)
+    {
+        std::remove((rotPath + "." + std::to_string(i)).c_str());
+    }
+    ::rmdir(dir.c_str());
+#endif
+}
+
 void multiLineLogTest()
 {
     std::cout << "Testing multiline function via log." << std::endl;
@@ -263,6 +2156,35 @@ int main()
     // threadSafetyTest();
     // logToDifferentStreamsTest();
     crushTestViaLog();
+    crushDifferentialTest();
+    formatAllocationTest();
+    ringConcurrencyTest();
+    ringOverflowTest();
+    configTest();
+    batchedStreamTest();
+    timestampTest();
+    compiledLevelTest();
+    lazyArgumentTest();
+    deferredFormattingTest();
+    binaryFormatTest();
+    sinkTest();
+    routingTest();
+    uringSinkTest();
+    mappedRingTest();
+    structuredLogTest();
+    perThreadQueueTest();
+    hotConfigTest();
+    tagLevelTest();
+    rateLimitTest();
+    statsTest();
+    flushTest();
+    crashHandlerTest();
+    pooledBufferTest();
+    formatStringTest();
+    networkSinkTest();
+    workerTuningTest();
+    sharedExecutorTest();
+    gzipSinkTest();
     // multiLineLogTest();
     // messageFormattingTest();
     // runLogLevelFilteringTests();
@@ -0,0 +1,75 @@
+/**
+ * @file minlevel/main.cpp
+ * @brief Test that levels below LCBLOG_MIN_LEVEL are compiled out.
+ *
+ * Built together with its own copy of lcblog.cpp with LCBLOG_MIN_LEVEL
+ * raised to WARN (see the Makefile), since the level is fixed per build.
+ * `make test` runs it after the main test driver.
+ *
+ * This software is distributed under the MIT License. See LICENSE.md for
+ * details.
+ *
+ * Copyright (C) 2023-2025 Lee C. Bussy (@LBussy). All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "../lcblog.hpp"
+#include <cassert>
+#include <iostream>
+#include <sstream>
+
+static_assert(LCBLOG_MIN_LEVEL == 2, "build this test with -DLCBLOG_MIN_LEVEL=2");
+
+int main()
+{
+    std::cout << "Testing compile-time level filtering at LCBLOG_MIN_LEVEL=2." << std::endl;
+
+    static_assert(!lcblogCompiledIn(DEBUG) && !lcblogCompiledIn(INFO), "DEBUG and INFO are compiled out");
+    static_assert(lcblogCompiledIn(WARN), "WARN is compiled in");
+
+    std::ostringstream sink;
+    int evaluated = 0;
+    {
+        LCBLog logger(sink, sink);
+        logger.setLogLevel(DEBUG);
+
+        // Nothing below the minimum is evaluated, whatever the runtime level
+        LCBLOG_S(logger, DEBUG, "dropped", ++evaluated);
+        LCBLOG_E(logger, INFO, "dropped", ++evaluated);
+        LCBLOG_F(logger, INFO, "dropped", ++evaluated);
+        LCBLOG_FMT(logger, DEBUG, "dropped {}", ++evaluated);
+        LCBLOG_LIMIT(logger, INFO, 10, 10, "dropped", ++evaluated);
+        assert(evaluated == 0);
+
+        // Direct calls still filter below the minimum
+        logger.logS(INFO, "dropped");
+        assert(!logger.shouldLog(INFO));
+
+        LCBLOG_S(logger, WARN, "kept", ++evaluated);
+        LCBLOG_E(logger, ERROR, "kept", ++evaluated);
+        assert(evaluated == 2);
+    }
+    // The two lines go through separate queues, so their order may vary
+    const std::string out = sink.str();
+    assert(out.size() == std::string("[WARN ] kept 1\n[ERROR] kept 2\n").size());
+    assert(out.find("[WARN ] kept 1\n") != std::string::npos);
+    assert(out.find("[ERROR] kept 2\n") != std::string::npos);
+    return 0;
+}
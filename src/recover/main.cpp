@@ -0,0 +1,62 @@
+/**
+ * @file recover/main.cpp
+ * @brief lcblog-recover: print the entries that survive in a ring file.
+ *
+ * Usage: lcblog-recover ring-file...
+ *
+ * Writes the entries left in each MappedRingSink file to standard
+ * output, oldest first. Rings holding binary records can be piped into
+ * lcblog-decode.
+ *
+ * This software is distributed under the MIT License. See LICENSE.md for
+ * details.
+ *
+ * Copyright (C) 2023-2025 Lee C. Bussy (@LBussy). All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "../lcblog.hpp"
+#include <iostream>
+#include <string>
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " ring-file..." << std::endl;
+        return 2;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string entries;
+        std::string error;
+        if (!MappedRingSink::recover(argv[i], entries, &error))
+        {
+            std::cerr << argv[i] << ": " << error << std::endl;
+            ok = false;
+            continue;
+        }
+        std::cout.write(entries.data(), static_cast<std::streamsize>(entries.size()));
+    }
+    std::cout.flush();
+    return ok ? 0 : 1;
+}